@@ -0,0 +1,174 @@
+#ifndef RBST_BATCHSIM_HPP
+#define RBST_BATCHSIM_HPP
+
+//std
+#include <algorithm>
+#include <thread>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "VecBatch.hpp"
+
+//many headless matches stepped together, for balance runs and bot work
+//each lane's state machines (inputs, dashes, hits, the projectile walk) run one lane at a time through the same steps
+//simulate() is made of, but the parts of a frame that are plain adds are done for many at once with the v2batch
+//kernels: every player's move, kept in columns across the lanes, and each lane's projectiles, whose pool already is
+//columns; the lanes are split across worker threads on top of that
+//every lane stays bit-identical to a plain simulate() run, rbst_batchbench checks it
+
+struct MatchBatch
+{
+	std::vector<GameState> states;
+	std::vector<SecSimFlux> fluxes;
+	std::vector<const Config*> cfgs;
+	//inputs for the coming frame, one entry per lane
+	std::vector<InputData> inputs;
+	//lanes stop simulating once their match is over
+	std::vector<char> finished;
+	//lanes whose players and projectiles get stepped this frame
+	std::vector<char> playing;
+	//every player's position and the step it takes this frame, at lane * MAX_PLAYERS + player
+	//steps stay 0 for players a lane doesn't have and lanes that aren't playing
+	std::vector<num_det> posX;
+	std::vector<num_det> posY;
+	std::vector<num_det> stepX;
+	std::vector<num_det> stepY;
+	//frames a lane had to move its projectiles one at a time, see chargeReleasable()
+	std::vector<long> walkedFrames;
+};
+
+//inputs for a lane on the frame it is about to simulate
+using BatchInputSource = InputData(*)(void* context, int lane, long frame);
+
+int batchSize(const MatchBatch* batch)
+{
+	return static_cast<int>(batch->states.size());
+}
+
+void resetBatch(MatchBatch* batch, int lanes, const Config* cfg)
+{
+	batch->states.assign(lanes, initialState(cfg));
+	batch->fluxes.assign(lanes, SecSimFlux{});
+	batch->cfgs.assign(lanes, cfg);
+	batch->inputs.assign(lanes, InputData{});
+	batch->finished.assign(lanes, 0);
+	batch->playing.assign(lanes, 0);
+	batch->posX.assign(lanes * MAX_PLAYERS, num_det{ 0 });
+	batch->posY.assign(lanes * MAX_PLAYERS, num_det{ 0 });
+	batch->stepX.assign(lanes * MAX_PLAYERS, num_det{ 0 });
+	batch->stepY.assign(lanes * MAX_PLAYERS, num_det{ 0 });
+	batch->walkedFrames.assign(lanes, 0);
+}
+
+//for batches mixing configs (e.g. one per replay), call after resetBatch
+void setLaneConfig(MatchBatch* batch, int lane, const Config* cfg)
+{
+	batch->cfgs[lane] = cfg;
+	batch->states[lane] = initialState(cfg);
+}
+
+//one frame for lanes [first, last), inputs already in the columns
+void stepLanes(MatchBatch* batch, int first, int last)
+{
+	//PLAYERS - where everyone is and how far they go, lane by lane
+	for (int lane = first; lane < last; lane++)
+	{
+		size_t column = static_cast<size_t>(lane) * MAX_PLAYERS;
+		GameState* state = &(batch->states[lane]);
+		batch->playing[lane] = !batch->finished[lane] && framePlays(state, batch->cfgs[lane], &(batch->inputs[lane]));
+		if (!batch->playing[lane])
+		{
+			std::fill(&(batch->stepX[column]), &(batch->stepX[column]) + MAX_PLAYERS, num_det{ 0 });
+			std::fill(&(batch->stepY[column]), &(batch->stepY[column]) + MAX_PLAYERS, num_det{ 0 });
+			continue;
+		}
+		Vec2 steps[MAX_PLAYERS];
+		playerSteps(state, batch->cfgs[lane], &(batch->inputs[lane]), steps);
+		for (int i = 0; i < state->playerCount; i++)
+		{
+			batch->posX[column + i] = state->players[i].pos.x;
+			batch->posY[column + i] = state->players[i].pos.y;
+			batch->stepX[column + i] = steps[i].x;
+			batch->stepY[column + i] = steps[i].y;
+		}
+	}
+	//the moves of every lane at once
+	size_t from = static_cast<size_t>(first) * MAX_PLAYERS;
+	Vec2Columns pos = { &(batch->posX[from]), &(batch->posY[from]) };
+	v2batch::add(pos, ConstVec2Columns(&(batch->stepX[from]), &(batch->stepY[from])), pos, static_cast<size_t>(last - first) * MAX_PLAYERS);
+	//and the rest of the frame, lane by lane
+	for (int lane = first; lane < last; lane++)
+	{
+		if (batch->finished[lane]) continue;
+		GameState* state = &(batch->states[lane]);
+		SecSimFlux* flux = &(batch->fluxes[lane]);
+		const Config* cfg = batch->cfgs[lane];
+		if (batch->playing[lane])
+		{
+			size_t column = static_cast<size_t>(lane) * MAX_PLAYERS;
+			for (int i = 0; i < state->playerCount; i++)
+			{
+				state->players[i].pos = Vec2{ batch->posX[column + i], batch->posY[column + i] };
+			}
+			settlePlayers(state, cfg);
+			//PROJECTILES - all moved in one pass unless a full charge could go off during the walk
+			bool moved = !chargeReleasable(state, cfg);
+			if (moved) integrateProjectiles(&(state->projs));
+			else (batch->walkedFrames[lane])++;
+			resolveFrame(state, flux, cfg, batch->inputs[lane], moved);
+			//nobody is watching batched matches, so secondary sim events are dropped right away
+			clearFlux(flux);
+		}
+		batch->finished[lane] = endCondition(state, cfg);
+	}
+}
+
+//frames for lanes [first, last), pulling inputs from the source right before each one
+void runLanes(MatchBatch* batch, int first, int last, long frames, BatchInputSource source, void* context)
+{
+	for (long f = 0; f < frames; f++)
+	{
+		for (int lane = first; lane < last; lane++)
+		{
+			if (batch->finished[lane]) continue;
+			batch->inputs[lane] = source(context, lane, batch->states[lane].frame);
+		}
+		stepLanes(batch, first, last);
+	}
+}
+
+//lanes never share data, so each worker gets a contiguous slice and runs all frames on it
+//threads <= 0 uses every hardware thread
+void runBatch(MatchBatch* batch, long frames, int threads, BatchInputSource source, void* context)
+{
+	int lanes = batchSize(batch);
+	if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::max(1, std::min(threads, lanes));
+	if (threads == 1)
+	{
+		runLanes(batch, 0, lanes, frames, source, context);
+		return;
+	}
+	std::vector<std::thread> workers;
+	int slice = (lanes + threads - 1) / threads;
+	for (int first = 0; first < lanes; first += slice)
+	{
+		int last = std::min(lanes, first + slice);
+		workers.push_back(std::thread(runLanes, batch, first, last, frames, source, context));
+	}
+	for (auto it = workers.begin(); it != workers.end(); it++)
+	{
+		it->join();
+	}
+}
+
+bool batchFinished(const MatchBatch* batch)
+{
+	return std::all_of(batch->finished.begin(), batch->finished.end(), [](char f) { return f != 0; });
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef RBST_COLLISIONGRID_HPP
+#define RBST_COLLISIONGRID_HPP
+
+//std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Player.hpp"
+
+//uniform grid over the arena, used as a broadphase in front of the exact collision checks
+//every query region (hitbox, perfect dash spot, combo radius, railgun ray) is marked on the cells it touches
+//and a projectile only gets the exact fixed-point test when its own cell carries the mark
+//marks are conservative, so the grid never changes an outcome, it only saves the square roots that couldn't pass
+//projectiles are still walked in vector order: parries, hitstop and altShots fired mid-loop all depend on it
+
+const int GRID_DIM = 32;
+const int GRID_CELLS = GRID_DIM * GRID_DIM;
+//slack around every region, way more than v2::length can be off by
+const std::int32_t GRID_MARGIN_RAW = 1 << 8;
+//bigger arenas can overflow the distance maths in the exact checks, and then there's nothing safe to filter on
+const num_det GRID_MAX_ARENA{ 32 };
+
+enum GridLayer
+{
+	Body,
+	Perfect,
+	Combo
+};
+
+//layers hold one bit per player, see playerBit
+struct GridCell
+{
+	bool insideArena = false;
+	std::uint8_t body = 0;
+	std::uint8_t perfect = 0;
+	std::uint8_t combo = 0;
+};
+
+struct CollisionGrid
+{
+	//off means every check goes through the exact test, handy for benchmarks and for checking the grid itself
+	bool enabled = true;
+	bool active = false;
+	//what the cell layout and insideArena were built for
+	num_det arenaRadius{ 0 };
+	std::int32_t originRaw = 0;
+	int cellShift = 16;
+	GridCell cells[GRID_CELLS];
+	//what positions off the grid get: anything might be there
+	GridCell anywhere = { false, 0xff, 0xff, 0xff };
+};
+
+//cells touched by one railgun ray, kept by the caller since altShot can fire another one before it's done
+struct RayCells
+{
+	std::uint64_t bits[GRID_CELLS / 64];
+};
+
+//one per thread, so batched matches on different threads don't share it
+thread_local CollisionGrid collisionGrid;
+
+inline std::uint8_t playerBit(playerid id)
+{
+	return static_cast<std::uint8_t>(1 << (id - 1));
+}
+
+//-1 or GRID_DIM when off the grid
+inline int gridCoord(const CollisionGrid* grid, std::int64_t raw)
+{
+	std::int64_t offset = raw - grid->originRaw;
+	if (offset < 0) return -1;
+	std::int64_t coord = offset >> grid->cellShift;
+	return (coord >= GRID_DIM) ? GRID_DIM : static_cast<int>(coord);
+}
+
+void layoutCollisionGrid(CollisionGrid* grid, const Config* cfg)
+{
+	grid->arenaRadius = cfg->arenaRadius;
+	//smallest power of two cell that fits the arena (plus margin) in half the grid each way
+	std::int64_t extent = static_cast<std::int64_t>(cfg->arenaRadius.raw_value()) + GRID_MARGIN_RAW;
+	grid->cellShift = 8;
+	while ((static_cast<std::int64_t>(GRID_DIM / 2) << grid->cellShift) <= extent)
+	{
+		grid->cellShift++;
+	}
+	grid->originRaw = -static_cast<std::int32_t>((GRID_DIM / 2) << grid->cellShift);
+
+	//a cell is inside when even its farthest corner is, the arena check can skip those
+	std::int64_t inner = static_cast<std::int64_t>(cfg->arenaRadius.raw_value()) - GRID_MARGIN_RAW;
+	std::int64_t innerSq = (inner > 0) ? inner * inner : 0;
+	std::int64_t size = std::int64_t{ 1 } << grid->cellShift;
+	for (int y = 0; y < GRID_DIM; y++)
+	{
+		std::int64_t y0 = grid->originRaw + y * size;
+		std::int64_t farY = std::max(y0 * y0, (y0 + size) * (y0 + size));
+		for (int x = 0; x < GRID_DIM; x++)
+		{
+			std::int64_t x0 = grid->originRaw + x * size;
+			std::int64_t farX = std::max(x0 * x0, (x0 + size) * (x0 + size));
+			grid->cells[y * GRID_DIM + x].insideArena = (farX + farY) < innerSq;
+		}
+	}
+}
+
+//called every frame before anything is marked
+void resetCollisionGrid(CollisionGrid* grid, const Config* cfg)
+{
+	grid->active = grid->enabled && cfg->arenaRadius > num_det{ 0 } && cfg->arenaRadius <= GRID_MAX_ARENA;
+	if (!grid->active) return;
+	if (grid->arenaRadius != cfg->arenaRadius)
+	{
+		layoutCollisionGrid(grid, cfg);
+	}
+	for (int i = 0; i < GRID_CELLS; i++)
+	{
+		grid->cells[i].body = 0;
+		grid->cells[i].perfect = 0;
+		grid->cells[i].combo = 0;
+	}
+}
+
+inline std::uint8_t* layerBits(GridCell* cell, GridLayer layer)
+{
+	switch (layer)
+	{
+	case GridLayer::Perfect:
+		return &(cell->perfect);
+	case GridLayer::Combo:
+		return &(cell->combo);
+	default:
+		return &(cell->body);
+	}
+}
+
+//marks every cell touching the square around the circle, which holds anything closer than radius to center
+void markDisc(CollisionGrid* grid, Vec2 center, num_det radius, GridLayer layer, std::uint8_t bit)
+{
+	if (!grid->active) return;
+	std::int64_t reach = static_cast<std::int64_t>(radius.raw_value()) + GRID_MARGIN_RAW;
+	int minX = std::max(gridCoord(grid, center.x.raw_value() - reach), 0);
+	int maxX = std::min(gridCoord(grid, center.x.raw_value() + reach), GRID_DIM - 1);
+	int minY = std::max(gridCoord(grid, center.y.raw_value() - reach), 0);
+	int maxY = std::min(gridCoord(grid, center.y.raw_value() + reach), GRID_DIM - 1);
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			*layerBits(&(grid->cells[y * GRID_DIM + x]), layer) |= bit;
+		}
+	}
+}
+
+//the regions simulate() and altShot() check projectiles against, positions don't change after movement so once per frame does it
+void markPlayer(CollisionGrid* grid, const Player* player, const Config* cfg)
+{
+	std::uint8_t bit = playerBit(player->id);
+	markDisc(grid, player->pos, cfg->playerRadius + cfg->projRadius, GridLayer::Body, bit);
+	markDisc(grid, player->perfectPos, cfg->playerRadius + cfg->projRadius, GridLayer::Perfect, bit);
+	markDisc(grid, player->pos, cfg->comboRadius + cfg->playerRadius, GridLayer::Combo, bit);
+}
+
+inline const GridCell* gridCell(const CollisionGrid* grid, Vec2 pos)
+{
+	if (!grid->active) return &(grid->anywhere);
+	int x = gridCoord(grid, pos.x.raw_value());
+	int y = gridCoord(grid, pos.y.raw_value());
+	if (x < 0 || y < 0 || x >= GRID_DIM || y >= GRID_DIM) return &(grid->anywhere);
+	return &(grid->cells[y * GRID_DIM + x]);
+}
+
+//cells that could hold a point v2::closest puts in front of the ray and within radius of it
+//whatever the length of direction, those points sit less than radius away from the ray's line, so this marks a half strip
+//doubles are fine here: they only pick cells, with a margin, and the fixed-point test still decides every hit
+void markRay(const CollisionGrid* grid, RayCells* ray, Vec2 origin, Vec2 direction, num_det radius)
+{
+	std::uint64_t fill = grid->active ? 0 : ~std::uint64_t{ 0 };
+	for (int i = 0; i < GRID_CELLS / 64; i++)
+	{
+		ray->bits[i] = fill;
+	}
+	if (!grid->active) return;
+
+	const double toUnits = 1.0 / 65536.0;
+	double dirX = direction.x.raw_value() * toUnits;
+	double dirY = direction.y.raw_value() * toUnits;
+	double dirLength = std::sqrt(dirX * dirX + dirY * dirY);
+	//a zero direction gives a zero dot product, which never counts as in front
+	if (dirLength == 0.0) return;
+	dirX /= dirLength;
+	dirY /= dirLength;
+
+	double size = static_cast<double>(std::int64_t{ 1 } << grid->cellShift) * toUnits;
+	//cells are tested through their bounding circle
+	double cellReach = size * 0.7072;
+	double margin = GRID_MARGIN_RAW * toUnits;
+	double halfWidth = static_cast<double>(radius.raw_value()) * toUnits + margin + cellReach;
+	double behind = -(margin + cellReach);
+	double firstCenter = grid->originRaw * toUnits + size * 0.5;
+	double originX = origin.x.raw_value() * toUnits;
+	double originY = origin.y.raw_value() * toUnits;
+	for (int y = 0; y < GRID_DIM; y++)
+	{
+		double relY = firstCenter + y * size - originY;
+		for (int x = 0; x < GRID_DIM; x++)
+		{
+			double relX = firstCenter + x * size - originX;
+			double along = relX * dirX + relY * dirY;
+			double across = std::abs(relX * dirY - relY * dirX);
+			if (along >= behind && across <= halfWidth)
+			{
+				int i = y * GRID_DIM + x;
+				ray->bits[i / 64] |= std::uint64_t{ 1 } << (i % 64);
+			}
+		}
+	}
+}
+
+inline bool onRay(const CollisionGrid* grid, const RayCells* ray, Vec2 pos)
+{
+	if (!grid->active) return true;
+	int x = gridCoord(grid, pos.x.raw_value());
+	int y = gridCoord(grid, pos.y.raw_value());
+	if (x < 0 || y < 0 || x >= GRID_DIM || y >= GRID_DIM) return true;
+	int i = y * GRID_DIM + x;
+	return (ray->bits[i / 64] >> (i % 64)) & 1;
+}
+
+#endif
@@ -51,10 +51,10 @@ struct Config
 	int16 strongHitstop = 0;
 };
 
-Config readTOMLForCfg()
+Config readTOMLForCfg(const char* path = "RBST_config.toml")
 {
 	Config cfg;
-	auto file = toml::parse_file("RBST_config.toml");
+	auto file = toml::parse_file(path);
 	std::istringstream iss;
 	num_det extract;
 
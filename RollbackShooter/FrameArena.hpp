@@ -0,0 +1,109 @@
+#ifndef RBST_FRAMEARENA_HPP
+#define RBST_FRAMEARENA_HPP
+
+//std
+#include <algorithm>
+#include <cassert>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+//-----
+
+//what a frame builds only to throw away at its end (the HUD text) comes out of an arena: a fixed buffer handed out
+//by bumping a pointer and taken back all at once by resetArena(), so once a loop is going none of it touches the heap
+//text shared between threads goes in fixed char arrays instead, see appendText()
+
+//FRAME ARENA
+
+//a few times the longest HUD, diagnostics on
+const size_t FRAME_ARENA_BYTES = 16 * 1024;
+
+struct FrameArena
+{
+	alignas(std::max_align_t) std::byte buffer[FRAME_ARENA_BYTES];
+	//past the buffer it falls back on the heap, which the allocation count then catches
+	std::pmr::monotonic_buffer_resource resource{ buffer, FRAME_ARENA_BYTES, std::pmr::new_delete_resource() };
+};
+
+using FrameString = std::pmr::string;
+
+//everything handed out since the last reset is gone, nothing built on the arena may outlive this
+inline void resetArena(FrameArena* arena)
+{
+	arena->resource.release();
+}
+
+FrameString frameString(FrameArena* arena, size_t reserve = 1024)
+{
+	FrameString text{ &arena->resource };
+	text.reserve(reserve);
+	return text;
+}
+
+//printf onto the end of it, a line at most 255 characters long
+void appendf(FrameString* text, const char* format, ...)
+{
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (length > 0) text->append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+}
+
+//printf onto the end of a fixed, null terminated buffer, cut short when it's full
+void appendText(char* text, size_t size, const char* format, ...)
+{
+	size_t used = strnlen(text, size);
+	if (used + 1 >= size) return;
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text + used, size - used, format, args);
+	va_end(args);
+}
+
+//ALLOCATION COUNT
+
+//debug builds count every operator new each thread makes, so a loop can check its steady frames don't allocate
+//(malloc isn't counted, that's the drivers' and the C libraries' business)
+//replacing operator new takes over the whole program's allocator, so it's only done in the source file a program is
+//built from (Main.cpp, and HudBench.cpp for the bench), which also defines the count
+#if defined(_DEBUG) && !defined(RBST_COUNT_ALLOCATIONS)
+#define RBST_COUNT_ALLOCATIONS
+#endif
+
+#ifdef RBST_COUNT_ALLOCATIONS
+extern thread_local long threadAllocations;
+#endif
+
+//a frame is steady once this many in a row went without allocating; anything that's allowed to allocate (a menu
+//action, a replay starting over) starts the count again through unsteadyFrame()
+const int ALLOCATION_WARMUP_FRAMES = 120;
+
+struct FrameAllocCheck
+{
+	long counted = 0;
+	int steadyFrames = 0;
+};
+
+inline void unsteadyFrame(FrameAllocCheck* check)
+{
+	check->steadyFrames = 0;
+}
+
+//once a frame, on the thread the frames run on: what it allocated since the last call has to be nothing once steady
+void checkFrameAllocations(FrameAllocCheck* check)
+{
+#ifdef RBST_COUNT_ALLOCATIONS
+	long allocations = threadAllocations - check->counted;
+	check->counted = threadAllocations;
+	assert((check->steadyFrames < ALLOCATION_WARMUP_FRAMES || allocations == 0) && "a steady frame allocated");
+	check->steadyFrames = (allocations == 0) ? check->steadyFrames + 1 : 0;
+#endif
+}
+
+#endif
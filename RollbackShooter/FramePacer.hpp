@@ -0,0 +1,79 @@
+#ifndef RBST_FRAMEPACER_HPP
+#define RBST_FRAMEPACER_HPP
+
+//std
+#include <algorithm>
+//-----
+
+//how long each frame of an online match should last, so the peer that runs ahead gives the time back
+//GGPO sends a timesync event when this side is a few frames ahead; the old way was to drop to 50 FPS for 5 frames
+//per frame ahead, 3.3ms extra on each of them, which shows as a stutter
+//spreading makes frames at most maxStretchMs longer instead, paying the same time back over many more frames,
+//and also leans on the frame advantage GGPO measures all the time so this side rarely gets far enough ahead for an event
+
+const double FRAME_MS = 1000.0 / 60.0;
+//about 59 FPS at worst, for as long as it takes
+const double PACER_MAX_STRETCH_MS = 0.3;
+//advantage under this is noise (GGPO measures it in whole frames, averaged)
+const double PACER_DEADBAND_FRAMES = 0.5;
+//the measured lead past the deadband gets paid back over this many frames
+const double PACER_SPREAD_FRAMES = 60;
+
+enum class PacingMode
+{
+	//the old 50 FPS penalty
+	Penalty,
+	Spread
+};
+
+struct FramePacer
+{
+	PacingMode mode = PacingMode::Spread;
+	double maxStretchMs = PACER_MAX_STRETCH_MS;
+	//Penalty: frames left at 50 FPS
+	int penaltyFrames = 0;
+	//Spread: milliseconds still to give back from timesync events
+	double debtMs = 0;
+	long timesyncs = 0;
+	double stretchedMs = 0;
+};
+
+void resetPacer(FramePacer* pacer, PacingMode mode, double maxStretchMs = PACER_MAX_STRETCH_MS)
+{
+	*pacer = FramePacer{};
+	pacer->mode = mode;
+	pacer->maxStretchMs = std::max(0.0, maxStretchMs);
+}
+
+//GGPO_EVENTCODE_TIMESYNC, it tells how far ahead this side is as of now so it replaces what's left of the last one
+void pacerTimesync(FramePacer* pacer, int framesAhead)
+{
+	(pacer->timesyncs)++;
+	if (pacer->mode == PacingMode::Penalty) pacer->penaltyFrames = 5 * framesAhead;
+	else pacer->debtMs = std::max(0, framesAhead) * FRAME_MS;
+}
+
+//once per frame, how long it should last; framesAhead is the advantage GGPO measures right now, 0 if unknown
+double pacerFrameMs(FramePacer* pacer, double framesAhead)
+{
+	double frameMs = FRAME_MS;
+	if (pacer->mode == PacingMode::Penalty)
+	{
+		if (pacer->penaltyFrames > 0)
+		{
+			(pacer->penaltyFrames)--;
+			frameMs = 1000.0 / 50.0;
+		}
+	}
+	else
+	{
+		double lead = std::max(0.0, framesAhead - PACER_DEADBAND_FRAMES) * FRAME_MS / PACER_SPREAD_FRAMES;
+		double stretch = std::min(pacer->maxStretchMs, std::max(pacer->debtMs, lead));
+		pacer->debtMs = std::max(0.0, pacer->debtMs - stretch);
+		frameMs += stretch;
+	}
+	pacer->stretchedMs += frameMs - FRAME_MS;
+	return frameMs;
+}
+
+#endif
@@ -91,46 +91,76 @@ typedef struct tagBITMAPINFOHEADER {
 #include "Replay.hpp"
 #include "SecondarySim.hpp"
 #include "GameState.hpp"
+#include "SaveStatePool.hpp"
+#include "StateHash.hpp"
+#include "Snapshot.hpp"
+#include "RollbackProfiler.hpp"
+#include "InputDelay.hpp"
+#include "FramePacer.hpp"
+#include "SimThread.hpp"
+#include "UdpSocket.hpp"
+#include "SpectatorRelay.hpp"
+#include "FrameArena.hpp"
 #include "Presentation.hpp"
 
-GameState ggState;
-SecSimFluxHistory ggFlux;
-SecSimParticles ggParticles;
-Config ggCfg;
-GGPOSession* ggpo = NULL;
-GGPOPlayerHandle ggHandle1, ggHandle2, localHandle;
-bool connected = false;
-int framesAheadPenalty = -1;
-std::string connectionString = "";
-long confirmFrame = 0;
-long currentFrame = 0;
-long restoredFrame = 0;
-int rollbackFrames = 0;
-int rollbackWorst = 0;
-ReplayWriter* replayW = NULL;
-
-//lifted from GGPO example
-//(itself lifted from a Wikipedia article about the algorithm? lul)
-int fletcher32_checksum(short* data, size_t len)
+//everything one online match needs, so a process can run as many of them as it has ports for
+//(a local match server, a bot farm, a spectator relay), each one a fixed size apart from a few short lived containers
+struct NetSession
 {
-    int sum1 = 0xffff, sum2 = 0xffff;
-
-    while (len) {
-        size_t tlen = len > 360 ? 360 : len;
-        len -= tlen;
-        do {
-            sum1 += *data++;
-            sum2 += sum1;
-        } while (--tlen);
-        sum1 = (sum1 & 0xffff) + (sum1 >> 16);
-        sum2 = (sum2 & 0xffff) + (sum2 >> 16);
-    }
+    GameState state;
+    SecSimFluxHistory flux;
+    SecSimParticles particles;
+    Config cfg;
+    SaveStatePool savePool;
+    RollbackProfiler profiler;
+    //picks the local input delay between rounds
+    DelayController delay;
+    ReplayWriter replay;
+    //spectators watching through this session, NULL when it doesn't host a relay
+    SpectatorRelay* relay = NULL;
+    GGPOSession* ggpo = NULL;
+    GGPOPlayerHandle handle1 = GGPO_INVALID_HANDLE;
+    GGPOPlayerHandle handle2 = GGPO_INVALID_HANDLE;
+    GGPOPlayerHandle localHandle = GGPO_INVALID_HANDLE;
+    bool connected = false;
+    //time sync: how long the current frame should last, see FramePacer.hpp
+    FramePacer pacer;
+    double frameMs = FRAME_MS;
+    std::string connectionString = "";
+    long confirmFrame = 0;
+    long currentFrame = 0;
+    long restoredFrame = 0;
+    int rollbackFrames = 0;
+    int rollbackWorst = 0;
+    int checksumInterval = 1;
+    //kept particles reconciled after rollbacks, or none kept and every published frame's made from the flux history
+    ParticleMode particleMode = ParticleMode::Reconcile;
+};
+
+//from RBST_home.toml, 1 checksums every saved frame, new sessions take it on
+int checksumInterval = 1;
+//also from RBST_home.toml, the mean rollback depth the input delay is picked to stay under
+double rollbackTarget = 2;
+//also from RBST_home.toml, how a session that runs ahead gives the time back
+PacingMode pacingMode = PacingMode::Spread;
+double maxStretchMs = PACER_MAX_STRETCH_MS;
+//also from RBST_home.toml, how sessions keep their particles, see ParticleMode
+ParticleMode particleMode = ParticleMode::Reconcile;
+//also from RBST_home.toml, whether sessions relay the match to spectators and on which port
+bool hostRelay = false;
+unsigned short relayPort = 8002;
+
+//GGPO's callbacks take no context pointer, so they work on whichever session this thread is inside a GGPO call for
+//every ggpo_* call that can call back goes through a SessionScope
+thread_local NetSession* activeSession = NULL;
+
+struct SessionScope
+{
+    NetSession* previous;
 
-    /* Second reduction step to reduce sums to 16 bits */
-    sum1 = (sum1 & 0xffff) + (sum1 >> 16);
-    sum2 = (sum2 & 0xffff) + (sum2 >> 16);
-    return sum2 << 16 | sum1;
-}
+    SessionScope(NetSession* session) : previous(activeSession) { activeSession = session; }
+    ~SessionScope() { activeSession = previous; }
+};
 
 //GGPO deprecated callback
 bool __cdecl rbst_begin_game_callback(const char*)
@@ -141,26 +171,32 @@ bool __cdecl rbst_begin_game_callback(const char*)
 //unused parameter: flags
 bool __cdecl rbst_advance_frame_callback(int)
 {
+    NetSession* session = activeSession;
+    ProfileClock::time_point advanceStart = profileStart();
     PlayerInputZip zips[2] = { 0 };
     int disconnect_flags;
     //get synced inputs
-    ggpo_synchronize_input(ggpo, (void*)zips, sizeof(PlayerInputZip)*2, &disconnect_flags);
+    ggpo_synchronize_input(session->ggpo, (void*)zips, sizeof(PlayerInputZip)*2, &disconnect_flags);
     PlayerInput p1 = unzipInput(zips[0]);
     PlayerInput p2 = unzipInput(zips[1]);
     InputData input { p1,p2 };
-    overwriteReplayInput(replayW, input, ggState.frame);
+    overwriteReplayInput(&session->replay, input, session->state.frame);
     //simulate one step
-    SecSimFlux flux;
-    ggState = simulate(ggState, &flux, &ggCfg, input);
-    ggFlux.erase(ggState.frame);
-    ggFlux.insert(std::pair<long, SecSimFlux>(ggState.frame, flux));
+    simulate(&session->state, recordFlux(&session->flux, session->state.frame + 1), &session->cfg, input);
     //this wasn't on vector war but GGPO does expect me to advance frames in this callback or it will fail some assertion
-    ggpo_advance_frame(ggpo);
-    rollbackFrames++;
+    ggpo_advance_frame(session->ggpo);
+    session->rollbackFrames++;
 
     //to avoid losing info when two rollbacks happen within a frame, do this here
-    if (ggState.frame == currentFrame) rollbackSecSim(&ggFlux, &ggParticles, restoredFrame);
-    
+    //derived particles have nothing to fix, the flux history simulate() just rewrote is all there is
+    if (session->state.frame == session->currentFrame && session->particleMode == ParticleMode::Reconcile)
+    {
+        ProfileClock::time_point secSimStart = profileStart();
+        rollbackSecSim(&session->flux, &session->particles, session->restoredFrame);
+        profileStop(&session->profiler.secSimMs, secSimStart);
+    }
+
+    profileStop(&session->profiler.advanceMs, advanceStart);
     return true;
 }
 
@@ -171,28 +207,29 @@ bool __cdecl rbst_advance_frame_callback(int)
 
 bool __cdecl rbst_load_game_state_callback(unsigned char* buffer, int len)
 {
-    memcpy(&ggState, buffer, len);
-    rollbackFrames = 0;
-    restoredFrame = ggState.frame;
+    NetSession* session = activeSession;
+    if (!decodeSnapshot(buffer, len, &session->state)) return false;
+    session->rollbackFrames = 0;
+    session->restoredFrame = session->state.frame;
     return true;
 }
 
-//unused parameter: frame
-bool __cdecl rbst_save_game_state_callback(unsigned char** buffer, int* len, int* checksum, int)
+bool __cdecl rbst_save_game_state_callback(unsigned char** buffer, int* len, int* checksum, int frame)
 {
-    *len = sizeof(ggState);
-    *buffer = (unsigned char*)malloc(*len);
+    NetSession* session = activeSession;
+    *buffer = acquireSaveState(&session->savePool);
     if (!*buffer) {
         return false;
     }
-    memcpy(*buffer, &ggState, *len);
-    *checksum = fletcher32_checksum((short*)*buffer, *len / 2);
+    //saved as snapshots rather than the whole struct, a save is a fraction of the bytes
+    *len = static_cast<int>(encodeSnapshot(&session->state, *buffer, MAX_SNAPSHOT_BYTES));
+    *checksum = checksumFrame(frame, session->checksumInterval) ? static_cast<int>(stateHash(&session->state)) : 0;
     return true;
 }
 
 void __cdecl rbst_free_buffer(void* buffer)
 {
-    free(buffer);
+    releaseSaveState(&activeSession->savePool, buffer);
 }
 
 //not using this
@@ -204,42 +241,42 @@ bool __cdecl rbst_log_game_state(char* filename, unsigned char* buffer, int)
 //event management
 bool __cdecl rbst_on_event_callback(GGPOEvent* info)
 {
+    NetSession* session = activeSession;
     int progress;
     switch (info->code) {
     case GGPO_EVENTCODE_CONNECTED_TO_PEER:
-        connectionString.insert(0, "[NET]Succesfully connected!\n");
+        session->connectionString.insert(0, "[NET]Succesfully connected!\n");
         break;
     case GGPO_EVENTCODE_SYNCHRONIZING_WITH_PEER:
         progress = info->u.synchronizing.count;
         char txt[32];
         sprintf_s(txt, "[NET]Synchronizing... %d%% \n", progress);
-        connectionString.insert(0, txt);
+        session->connectionString.insert(0, txt);
         break;
     case GGPO_EVENTCODE_SYNCHRONIZED_WITH_PEER:
-        connectionString.insert(0, "[NET]Succesfully synchronized!\n");
+        session->connectionString.insert(0, "[NET]Succesfully synchronized!\n");
         break;
     case GGPO_EVENTCODE_RUNNING:
-        connectionString = "";
+        session->connectionString = "";
         break;
     case GGPO_EVENTCODE_CONNECTION_INTERRUPTED:
         break;
     case GGPO_EVENTCODE_CONNECTION_RESUMED:
         break;
     case GGPO_EVENTCODE_DISCONNECTED_FROM_PEER:
-        connected = false;
+        session->connected = false;
         break;
     case GGPO_EVENTCODE_TIMESYNC:
-        //this game is ahead by n frames
-        //and as such will be penalized down by n*5 frames at 50FPS
-        framesAheadPenalty = 5 * info->u.timesync.frames_ahead;
-        SetTargetFPS(50);
+        //this game is ahead by n frames and has to give them back, either spread thin or at 50FPS for n*5 frames
+        pacerTimesync(&session->pacer, info->u.timesync.frames_ahead);
         break;
     }
     return true;
 }
 
-void NewNetworkedSession(std::string remoteAddress, unsigned short port, playerid localPlayer)
+void NewNetworkedSession(NetSession* session, std::string remoteAddress, unsigned short port, playerid localPlayer)
 {
+    SessionScope scope(session);
     GGPOErrorCode ggRes;
     GGPOSessionCallbacks ggCallbacks;
     ggCallbacks.begin_game = rbst_begin_game_callback;
@@ -250,12 +287,39 @@ void NewNetworkedSession(std::string remoteAddress, unsigned short port, playeri
     ggCallbacks.log_game_state = rbst_log_game_state;
     ggCallbacks.on_event = rbst_on_event_callback;
 
-    ggRes = ggpo_start_session(&ggpo, &ggCallbacks, "RBST", 2, sizeof(PlayerInputZip), port);
+    session->cfg = readTOMLForCfg();
+    session->state = initialState(&session->cfg);
+    session->checksumInterval = checksumInterval;
+    session->particleMode = particleMode;
+    resetDelayController(&session->delay, rollbackTarget);
+    resetPacer(&session->pacer, pacingMode, maxStretchMs);
+    session->frameMs = FRAME_MS;
+    resetSaveStatePool(&session->savePool);
+    resetFluxHistory(&session->flux);
+    openReplayFile(&session->replay, &session->cfg);
+    openProfiler(&session->profiler, session->replay.baseName + "_rollback.csv");
+    if (hostRelay)
+    {
+        session->relay = new SpectatorRelay();
+        if (openRelay(session->relay, relayPort, &session->cfg))
+        {
+            session->replay.confirmedContext = session->relay;
+            session->replay.confirmed = relayConfirmedCallback;
+        }
+        else
+        {
+            delete session->relay;
+            session->relay = NULL;
+            session->connectionString.insert(0, "[NET]Couldn't open the spectator port\n");
+        }
+    }
+
+    ggRes = ggpo_start_session(&session->ggpo, &ggCallbacks, "RBST", 2, sizeof(PlayerInputZip), port);
 
     //Automatically disconnect at
-    ggpo_set_disconnect_timeout(ggpo, 3000);
+    ggpo_set_disconnect_timeout(session->ggpo, 3000);
     //Start disconnect timer at
-    ggpo_set_disconnect_notify_start(ggpo, 1000);
+    ggpo_set_disconnect_notify_start(session->ggpo, 1000);
 
     GGPOPlayer ggP1, ggP2;
     ggP1 = ggP2 = { 0 };
@@ -270,24 +334,260 @@ void NewNetworkedSession(std::string remoteAddress, unsigned short port, playeri
         ggP2.type = GGPO_PLAYERTYPE_REMOTE;
         strcpy_s(ggP2.u.remote.ip_address, remoteAddress.c_str());
         ggP2.u.remote.port = port;
-        ggRes = ggpo_add_player(ggpo, &ggP1, &ggHandle1);
-        ggRes = ggpo_add_player(ggpo, &ggP2, &ggHandle2);
-        ggpo_set_frame_delay(ggpo, ggHandle1, 0);
-        localHandle = ggHandle1;
+        ggRes = ggpo_add_player(session->ggpo, &ggP1, &session->handle1);
+        ggRes = ggpo_add_player(session->ggpo, &ggP2, &session->handle2);
+        ggpo_set_frame_delay(session->ggpo, session->handle1, session->delay.delay);
+        session->localHandle = session->handle1;
         break;
     case 2:
         ggP2.type = GGPO_PLAYERTYPE_LOCAL;
         ggP1.type = GGPO_PLAYERTYPE_REMOTE;
         strcpy_s(ggP1.u.remote.ip_address, remoteAddress.c_str());
         ggP1.u.remote.port = port;
-        ggRes = ggpo_add_player(ggpo, &ggP2, &ggHandle2);
-        ggRes = ggpo_add_player(ggpo, &ggP1, &ggHandle1);
-        ggpo_set_frame_delay(ggpo, ggHandle2, 0);
-        localHandle = ggHandle2;
+        ggRes = ggpo_add_player(session->ggpo, &ggP2, &session->handle2);
+        ggRes = ggpo_add_player(session->ggpo, &ggP1, &session->handle1);
+        ggpo_set_frame_delay(session->ggpo, session->handle2, session->delay.delay);
+        session->localHandle = session->handle2;
         break;
     }
 
-    connected = true;
+    session->connected = true;
+}
+
+//the first half of a real frame: GGPO gets idleMs to roll back and exchange packets, then everything that goes by
+//what it found out (pacing, input delay, the replay and the relay)
+void pollNetSession(NetSession* session, int idleMs)
+{
+    SessionScope scope(session);
+    session->rollbackFrames = 0;
+    //GGPO needs this time to execute rollbacks and send packets
+    ProfileClock::time_point idleStart = profileStart();
+    ggpo_idle(session->ggpo, std::max(0, idleMs));
+    profileStop(&session->profiler.idleMs, idleStart);
+
+    session->rollbackWorst = std::max(session->rollbackWorst, session->rollbackFrames);
+    session->profiler.resimulated = session->rollbackFrames;
+    //GGPO doesn't tell which frame is confirmed, so the lag is estimated from the one way trip
+    GGPONetworkStats netStats = { 0 };
+    GGPOPlayerHandle remoteHandle = (session->localHandle == session->handle1) ? session->handle2 : session->handle1;
+    double pingMs = -1;
+    double framesAhead = 0;
+    if (GGPO_SUCCEEDED(ggpo_get_network_stats(session->ggpo, remoteHandle, &netStats)))
+    {
+        pingMs = netStats.network.ping;
+        session->profiler.confirmLag = static_cast<int>(ceil(pingMs * 60 / 2000.0));
+        //the same sum GGPO makes its timesync recommendation from
+        framesAhead = (netStats.timesync.remote_frames_behind - netStats.timesync.local_frames_behind) / 2.0;
+    }
+    session->frameMs = pacerFrameMs(&session->pacer, framesAhead);
+    session->profiler.framesAhead = framesAhead;
+    //the delay only moves outside of a round's fighting, the depth histogram starts over at each new delay
+    delaySample(&session->delay, session->rollbackFrames, pingMs);
+    if (updateInputDelay(&session->delay, session->state.phase, session->state.frame))
+    {
+        ggpo_set_frame_delay(session->ggpo, session->localHandle, session->delay.delay);
+        clearHistogram(&session->profiler.delayDepthHist);
+    }
+    session->profiler.inputDelay = session->delay.delay;
+    session->confirmFrame = session->state.frame - session->rollbackFrames;
+
+    consumeReplayInput(&session->replay, session->confirmFrame);
+    if (session->relay) relayTick(session->relay, relayNowMs());
+}
+
+//the second half: the local input goes in and the frame gets simulated if GGPO lets it
+void advanceNetSession(NetSession* session, PlayerInput localInput)
+{
+    SessionScope scope(session);
+    //input processing
+    GGPOErrorCode ggRes = GGPO_OK;
+    int disconnect_flags;
+    PlayerInputZip zips[2] = { 0 };
+
+    if (session->localHandle != GGPO_INVALID_HANDLE)
+    {
+        PlayerInputZip inputZip = zipInput(localInput);
+        ggRes = ggpo_add_local_input(session->ggpo, session->localHandle, &inputZip, sizeof(inputZip));
+    }
+
+    //input syncing (might have to do with input delay if it's set)
+    if (GGPO_SUCCEEDED(ggRes))
+    {
+        ggRes = ggpo_synchronize_input(session->ggpo, (void*)zips, sizeof(PlayerInputZip) * 2, &disconnect_flags);
+        if (GGPO_SUCCEEDED(ggRes))
+        {
+            PlayerInput p1 = unzipInput(zips[0]);
+            PlayerInput p2 = unzipInput(zips[1]);
+            InputData input{ p1,p2 };
+            writeReplayInput(&session->replay, input, session->state.frame);
+            //primary simulation
+            SecSimFlux* flux = recordFlux(&session->flux, session->state.frame + 1);
+            simulate(&session->state, flux, &session->cfg, input);
+            //secondary simulation, derived particles are only made when the frame gets published
+            if (session->particleMode == ParticleMode::Reconcile)
+            {
+                increaseParticleLifetime(&session->particles);
+                currentFrameSecSim(flux, &session->particles, session->state.frame);
+            }
+            session->currentFrame = session->state.frame;
+            //Notify GGPO that a frame has passed;
+            ggpo_advance_frame(session->ggpo);
+        }
+    }
+    endProfileFrame(&session->profiler, session->state.frame);
+}
+
+//one real frame of the session in one go
+void stepNetSession(NetSession* session, PlayerInput localInput, int idleMs)
+{
+    pollNetSession(session, idleMs);
+    advanceNetSession(session, localInput);
+}
+
+void disconnectNetSession(NetSession* session)
+{
+    SessionScope scope(session);
+    GGPOErrorCode ggRes = ggpo_disconnect_player(session->ggpo, session->localHandle);
+    session->connected = false;
+}
+
+void CloseNetworkedSession(NetSession* session)
+{
+    SessionScope scope(session);
+    //GGPO frees every saved state through the session's callbacks on the way out
+    if (session->ggpo)
+    {
+        ggpo_close_session(session->ggpo);
+        session->ggpo = NULL;
+    }
+    session->connected = false;
+    session->connectionString = "";
+    session->frameMs = FRAME_MS;
+    session->confirmFrame = 0;
+    session->restoredFrame = 0;
+    session->currentFrame = 0;
+    session->rollbackFrames = 0;
+    session->rollbackWorst = 0;
+
+    resetFluxHistory(&session->flux);
+    clearSecSim(&session->particles);
+
+    closeReplayFile(&session->replay);
+    closeProfiler(&session->profiler);
+    if (session->relay)
+    {
+        closeRelay(session->relay);
+        delete session->relay;
+        session->relay = NULL;
+        session->replay.confirmed = NULL;
+        session->replay.confirmedContext = NULL;
+    }
+}
+
+//NETWORKED MATCH THREADS
+
+//what the render thread draws, the sim thread fills one in after every tick
+struct NetFrame
+{
+    GameState state;
+    SecSimParticles particles;
+    ProfileView profile;
+    //the F4 text, less what only the render thread knows; fixed arrays, so publishing one never allocates
+    char diagnostics[1024];
+    char connection[512];
+};
+
+//the session lives on the sim thread, which is the only one to call into GGPO; the render thread only ever sees
+//published frames, the input queue and the flags
+struct NetThreads
+{
+    NetSession* session = NULL;
+    NetFrame frames[3];
+    TripleBuffer frameBuffer;
+    InputQueue input;
+    //sim thread only
+    InputCollector collector;
+    //set by the render thread
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> disconnect{ false };
+    //cleared by the sim thread once the match is over
+    std::atomic<bool> running{ true };
+    //sim ticks and input samples per second over the last second, sim thread only
+    double simHz = 60;
+    double sampleHz = 0;
+};
+
+void publishNetFrame(NetThreads* threads)
+{
+    NetSession* session = threads->session;
+    NetFrame* frame = &threads->frames[tripleWriteSlot(&threads->frameBuffer)];
+    frame->state = session->state;
+    //the secondary sim time of derived particles goes in the next frame's profile, this one's already closed
+    if (session->particleMode == ParticleMode::Derive)
+    {
+        ProfileClock::time_point secSimStart = profileStart();
+        deriveSecSim(&session->flux, &frame->particles, session->state.frame);
+        profileStop(&session->profiler.secSimMs, secSimStart);
+    }
+    else copySecSim(&frame->particles, &session->particles);
+    viewProfiler(&session->profiler, &frame->profile);
+    char* text = frame->diagnostics;
+    size_t size = sizeof(frame->diagnostics);
+    text[0] = '\0';
+    appendText(text, size, "Sim: %g Hz, tick late %g ms mean, %g ms worst\n",
+        threads->simHz, histogramMean(&session->profiler.lateHist), session->profiler.lateHist.worst);
+    appendText(text, size, "Input: %g samples/s, %g ms mean to simulate, %g ms worst\n",
+        threads->sampleHz, histogramMean(&session->profiler.inputHist), session->profiler.inputHist.worst);
+    appendText(text, size, "Rollbacked frames:%df\n", session->rollbackFrames);
+    appendText(text, size, "Worst rollback: %df\n", session->rollbackWorst);
+    appendText(text, size, "Pacing: %s, %ld timesyncs, %g ms given back, frame time sd %g ms\n",
+        session->pacer.mode == PacingMode::Spread ? "spread" : "penalty", session->pacer.timesyncs,
+        session->pacer.stretchedMs, histogramStdDev(&session->profiler.frameHist));
+    appendText(text, size, "Input delay: %df (target mean rollback %gf, %d changes)\n", session->delay.delay, session->delay.target, session->delay.changes);
+    appendText(text, size, "Save slots: %d in use, %d peak of %d\n", session->savePool.inUse, session->savePool.peak, SAVE_STATE_SLOTS);
+    if (session->savePool.fallbacks > 0) appendText(text, size, "Save slot fallbacks: %ld\n", session->savePool.fallbacks);
+    if (session->relay) appendText(text, size, "Spectators: %zu\n", session->relay->spectators.size());
+    frame->connection[0] = '\0';
+    appendText(frame->connection, sizeof(frame->connection), "%s", session->connectionString.c_str());
+    triplePublish(&threads->frameBuffer);
+}
+
+//fixed ticks paced by FramePacer; all the time between them goes to GGPO, and nothing the render thread does
+//(a slow frame, a vsync stall, dragging the window) holds up packets or simulation
+void netSimThread(NetThreads* threads)
+{
+    NetSession* session = threads->session;
+    SimTicker ticker;
+    startTicker(&ticker);
+    long secondTicks = 0;
+    long secondSamples = 0;
+    double secondMs = 0;
+    while (!threads->quit.load() && session->connected && !endCondition(&session->state, &session->cfg))
+    {
+        if (threads->disconnect.exchange(false))
+        {
+            disconnectNetSession(session);
+            break;
+        }
+        //a millisecond short, ggpo_idle can run over and the wait after it lands the tick on time
+        pollNetSession(session, static_cast<int>(floor(tickerMsLeft(&ticker))) - 1);
+        tickerWait(&ticker);
+        tickerTick(&ticker, session->frameMs, &session->profiler.tickLateMs, &session->profiler.frameMs);
+        advanceNetSession(session, collectInput(&threads->collector, &threads->input, &session->profiler.inputLatencyMs));
+
+        secondTicks++;
+        secondMs += session->profiler.frameMs;
+        if (secondMs >= 1000)
+        {
+            threads->simHz = secondTicks * 1000 / secondMs;
+            threads->sampleHz = (threads->collector.samples - secondSamples) * 1000 / secondMs;
+            secondSamples = threads->collector.samples;
+            secondTicks = 0;
+            secondMs = 0;
+        }
+        publishNetFrame(threads);
+    }
+    threads->running.store(false);
 }
 
 void NetworkedMain(const Sprites* sprs, std::string remoteAddress, unsigned short port, playerid localPlayer)
@@ -295,134 +595,142 @@ void NetworkedMain(const Sprites* sprs, std::string remoteAddress, unsigned shor
     //initializing winsockets
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
-    
-    ggCfg = readTOMLForCfg();
-    ggState = initialState(&ggCfg);
-    
+
+    NetThreads* threads = new NetThreads();
+    threads->session = new NetSession();
+    NetSession* session = threads->session;
+
     Camera3D cam = initialCamera();
-    std::ostringstream gameInfoOSS;
+    FrameArena arena;
+    FrameAllocCheck allocCheck;
     double semaphoreIdleTime = 0;
-    long latestConfFrame = 0;
-    long prevConfFrame = 0;
     bool diagnostics = false;
 
-    ReplayWriter replay = { 0 };
-    openReplayFile(&replay, &ggCfg);
-    replayW = &replay;
-
-    NewNetworkedSession(remoteAddress, port, localPlayer);
-    while (connected && !WindowShouldClose() && !endCondition(&ggState, &ggCfg))
+    NewNetworkedSession(session, remoteAddress, port, localPlayer);
+    //the render thread needs something to draw before the first tick
+    publishNetFrame(threads);
+    std::thread simThread(netSimThread, threads);
+
+    //set before the thread started and never changed after
+    POV pov;
+    if (session->localHandle == session->handle1)
+        pov = Player1;
+    else
+        pov = Player2;
+
+    //this thread polls every millisecond and draws every 60th of a second on a clock of its own, raylib isn't to wait
+    SetTargetFPS(0);
+    SimTicker drawTicker;
+    startTicker(&drawTicker);
+    InputSampler sampler;
+    while (threads->running.load() && !WindowShouldClose())
     {
-        //restore framerate to 60FPS after time sync penalty
-        framesAheadPenalty = std::max(-1, framesAheadPenalty - 1);
-        if (framesAheadPenalty == 0)
-        {
-            SetTargetFPS(60);
-        }
-        
+        //each poll, the one in EndDrawing too, is followed by exactly one sample, so every press is seen once
+        queueSample(&sampler, &threads->input, pollInput(&inputBind));
         if (IsKeyPressed(KEY_F10))
         {
-            GGPOErrorCode ggRes = ggpo_disconnect_player(ggpo, localHandle);
-            connected = false;
+            threads->disconnect.store(true);
         }
         if (IsKeyPressed(KEY_F4))
         {
             diagnostics = !diagnostics;
         }
-
-        rollbackFrames = 0;
-        //GGPO needs this time to execute rollbacks and send packets
-        //try to give as much as you can without lagging the main loop
-        int timeGivenToIdle = static_cast<int>(floor(semaphoreIdleTime * 1000)) - 1;
-        ggpo_idle(ggpo, std::max(0, timeGivenToIdle));
-
-        rollbackWorst = std::max(rollbackWorst, rollbackFrames);
-        confirmFrame = ggState.frame - rollbackFrames;
-
-        consumeReplayInput(&replay, confirmFrame);
-        
-        //input processing
-        GGPOErrorCode ggRes = GGPO_OK;
-        int disconnect_flags;
-        PlayerInputZip zips[2] = { 0 };
-
-        if (localHandle != GGPO_INVALID_HANDLE)
+        if (tickerMsLeft(&drawTicker) > 0)
         {
-            PlayerInput localInput = processInput(&inputBind);
-            PlayerInputZip inputZip = zipInput(localInput);
-            ggRes = ggpo_add_local_input(ggpo, localHandle, &inputZip, sizeof(inputZip));
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(INPUT_SAMPLE_MS));
+            PollInputEvents();
+            continue;
         }
+        double drawLateMs, drawIntervalMs;
+        tickerTick(&drawTicker, FRAME_MS, &drawLateMs, &drawIntervalMs);
 
-        //input syncing (might have to do with input delay if it's set)
-        if (GGPO_SUCCEEDED(ggRes))
-        {
-            ggRes = ggpo_synchronize_input(ggpo, (void*)zips, sizeof(PlayerInputZip) * 2, &disconnect_flags);
-            if (GGPO_SUCCEEDED(ggRes))
-            {
-                PlayerInput p1 = unzipInput(zips[0]);
-                PlayerInput p2 = unzipInput(zips[1]);
-                InputData input{ p1,p2 };
-                writeReplayInput(&replay, input, ggState.frame);
-                //primary simulation
-                SecSimFlux flux;
-                ggState = simulate(ggState, &flux, &ggCfg, input);
-                //secondary simulation
-                increaseParticleLifetime(&ggParticles);
-                currentFrameSecSim(&flux, &ggParticles, ggState.frame);
-                currentFrame = ggState.frame;
-                ggFlux.insert(std::pair<long, SecSimFlux>(ggState.frame, flux));
-                ggFlux.erase(currentFrame - 15);
-                //Notify GGPO that a frame has passed;
-                ggpo_advance_frame(ggpo);
-            }
-        }
-        POV pov;
-        if (localHandle == ggHandle1)
-            pov = Player1;
-        else
-            pov = Player2;
+        tripleRead(&threads->frameBuffer);
+        const NetFrame* frame = &threads->frames[tripleReadSlot(&threads->frameBuffer)];
 
         int currentFps = GetFPS();
-        gameInfoOSS.str("");
-        gameInfoOSS << "FPS: " << currentFps << std::endl;
+        //last frame's text went with the end of the last iteration
+        resetArena(&arena);
+        FrameString gameInfo = frameString(&arena);
+        appendf(&gameInfo, "FPS: %d\n", currentFps);
         if (diagnostics)
         {
-            gameInfoOSS << "Semaphore idle time: " << semaphoreIdleTime * 1000 << " ms" << std::endl;
-            gameInfoOSS << "Rollbacked frames:" << rollbackFrames << "f" << std::endl;
-            gameInfoOSS << "Worst rollback: " << rollbackWorst << "f" << std::endl;
+            appendf(&gameInfo, "Semaphore idle time: %g ms\n", semaphoreIdleTime * 1000);
+            gameInfo += frame->diagnostics;
         }
-        else gameInfoOSS << "[F4 for diagnostics]" << std::endl;
-        gameInfoOSS << connectionString;
+        else gameInfo += "[F4 for diagnostics]\n";
+        gameInfo += frame->connection;
 
-        semaphoreIdleTime = present(pov, &ggState, &ggParticles, &ggCfg, &cam, sprs, &gameInfoOSS);
+        semaphoreIdleTime = present(pov, &frame->state, &frame->particles, &session->cfg, &cam, sprs, gameInfo.c_str(), diagnostics ? &frame->profile : NULL);
+        //the render thread only, GGPO allocates on the sim thread whenever packets come and go
+        checkFrameAllocations(&allocCheck);
     }
     //exit session
-    if (ggpo)
+    SetTargetFPS(60);
+    threads->quit.store(true);
+    simThread.join();
+    CloseNetworkedSession(session);
+    delete session;
+    delete threads;
+
+    //cleaning winsockets
+    WSACleanup();
+}
+
+//watching a match through a player's relay, see SpectatorRelay.hpp
+void SpectatorMain(const Sprites* sprs, std::string relayAddress, unsigned short port)
+{
+    //initializing winsockets
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+    UdpSocket sock;
+    UdpLink link;
+    link.socket = &sock;
+    bool opened = parseUdpAddress(relayAddress.c_str(), port, &link.remote) && openUdpSocket(&sock, 0);
+    SpectatorClient* client = new SpectatorClient();
+    resetSpectator(client, udpTransport(&link));
+    client->lastHeardMs = relayNowMs();
+    SecSimParticles particles;
+
+    //shown until the relay sends the match's config
+    Config waitCfg = readTOMLForCfg();
+    GameState waitState = initialState(&waitCfg);
+
+    Camera3D cam = initialCamera();
+    FrameArena arena;
+    while (opened && !WindowShouldClose() && !IsKeyPressed(KEY_F10))
     {
-        ggpo_close_session(ggpo);
-        ggpo = NULL;
+        double nowMs = relayNowMs();
+        bool watching = spectatorTick(client, nowMs);
+        //the relay is gone, or was never there
+        if (nowMs - client->lastHeardMs > RELAY_TIMEOUT_MS) break;
+
+        //a frame per frame, more while far behind so joining late catches up
+        long behind = spectatorNextFrame(client) - client->state.frame;
+        long steps = (behind > 2 * RELAY_BATCH_FRAMES) ? std::min(behind, SPECTATOR_CATCHUP_FRAMES) : 1;
+        for (long i = 0; i < steps && stepSpectator(client); i++)
+        {
+            increaseParticleLifetime(&particles);
+            currentFrameSecSim(&client->flux, &particles, client->state.frame);
+        }
+        if (watching && endCondition(&client->state, &client->cfg)) break;
+
+        resetArena(&arena);
+        FrameString gameInfo = frameString(&arena);
+        appendf(&gameInfo, "FPS: %d\n", GetFPS());
+        if (!watching) appendf(&gameInfo, "[NET]Waiting for %s:%hu...\n", relayAddress.c_str(), port);
+        else if (behind > 2 * RELAY_BATCH_FRAMES) appendf(&gameInfo, "Catching up: %ldf behind\n", behind);
+        gameInfo += "[F10 to stop watching]\n";
+
+        if (watching) present(Spectator, &client->state, &particles, &client->cfg, &cam, sprs, gameInfo.c_str());
+        else present(Spectator, &waitState, &particles, &waitCfg, &cam, sprs, gameInfo.c_str());
     }
-    connected = false;
-    connectionString = "";
-    framesAheadPenalty = -1;
-    confirmFrame = 0;
-    restoredFrame = 0;
-    currentFrame = 0;
-    rollbackFrames = 0;
-    rollbackWorst = 0;
-
-    ggFlux.clear();
-    ggParticles.projs.clear();
-    ggParticles.combos.clear();
-    ggParticles.grazes.clear();
-    ggParticles.alerts.clear();
-    ggParticles.hitscans.clear();
-
-    closeReplayFile(&replay);
-    replayW = NULL;
+    if (opened) leaveRelay(client);
+    closeUdpSocket(&sock);
+    delete client;
 
     //cleaning winsockets
     WSACleanup();
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,16 +1,13 @@
 #ifndef RBST_GAMESTATE_HPP
 #define RBST_GAMESTATE_HPP
 
-//ETL
-#include <etl/vector.h>
-//-----
 #include "Math.hpp"
 #include "Config.hpp"
 #include "Input.hpp"
 #include "Player.hpp"
 #include "SecondarySim.hpp"
-
-const size_t MAX_PROJECTILES = 16;
+#include "CollisionGrid.hpp"
+#include "ProjectilePool.hpp"
 
 enum RoundPhase
 {
@@ -19,65 +16,70 @@ enum RoundPhase
 	End
 };
 
-struct Projectile
-{
-	Vec2 pos = v2::zero();
-	Vec2 vel = v2::zero();
-	playerid owner = 0;
-	int16 lifetime;
-};
-
+//everything per player sits in arrays indexed by id - 1, only the first playerCount entries are in the match
 struct GameState
 {
 	long frame = 0;
 	int16 roundCountdown = 0;
 	RoundPhase phase = Countdown;
 
-	Player p1;
-	int16 health1 = 0;
-	int16 rounds1 = 0;
-	bool p1DmgThisFrame = false;
+	int8 playerCount = 2;
+	Player players[MAX_PLAYERS];
+	int16 health[MAX_PLAYERS] = {};
+	int16 rounds[MAX_PLAYERS] = {};
+	bool dmgThisFrame[MAX_PLAYERS] = {};
 
-	Player p2;
-	int16 health2 = 0;
-	int16 rounds2 = 0;
-	bool p2DmgThisFrame = false;
-
-	etl::vector<Projectile, MAX_PROJECTILES> projs;
+	ProjectilePool projs;
 };
 
-GameState initialState(const Config* cfg)
+//the player count isn't part of Config since Config is the replay header, and duels have to keep reading old replays
+GameState initialState(const Config* cfg, int playerCount = 2)
 {
 	GameState state;
 	state.frame = 0;
 	state.roundCountdown = cfg->roundCountdown;
 	state.phase = RoundPhase::Countdown;
+	state.playerCount = static_cast<int8>(std::max(2, std::min(playerCount, MAX_PLAYERS)));
 
-	respawnPlayer(&(state.p1), cfg, 1);
-	state.health1 = cfg->playerHealth;
-	state.rounds1 = 0;
-	state.p1DmgThisFrame = false;
-
-	respawnPlayer(&(state.p2), cfg, 2);
-	state.health2 = cfg->playerHealth;
-	state.rounds2 = 0;
-	state.p2DmgThisFrame = false;
+	for (int i = 0; i < state.playerCount; i++)
+	{
+		respawnPlayer(&(state.players[i]), cfg, static_cast<playerid>(i + 1), state.playerCount);
+		state.health[i] = cfg->playerHealth;
+		state.rounds[i] = 0;
+		state.dmgThisFrame[i] = false;
+	}
 
 	return state;
 }
 
+inline Player* playerById(GameState* state, playerid id)
+{
+	return &(state->players[id - 1]);
+}
+
 void regDamage(GameState* state, playerid damaged)
 {
-	if (damaged == 1)
+	(state->health[damaged - 1])--;
+	state->dmgThisFrame[damaged - 1] = true;
+}
+
+int playersStanding(const GameState* state)
+{
+	int standing = 0;
+	for (int i = 0; i < state->playerCount; i++)
 	{
-		(state->health1)--;
-		state->p1DmgThisFrame = true;
+		if (state->health[i] > 0) standing++;
 	}
-	else
+	return standing;
+}
+
+bool matchWon(const GameState* state, const Config* cfg)
+{
+	for (int i = 0; i < state->playerCount; i++)
 	{
-		(state->health2)--;
-		state->p2DmgThisFrame = true;
+		if (state->rounds[i] >= cfg->roundsToWin) return true;
 	}
+	return false;
 }
 
 void altShot(GameState* state, SecSimFlux* flux, const Config* cfg, Vec2 origin, Vec2 direction, playerid owner);
@@ -115,469 +117,555 @@ void damagePlayer(Player* player, SecSimFlux* flux, GameState* state, const Conf
 
 void altShot(GameState* state, SecSimFlux* flux, const Config* cfg, Vec2 origin, Vec2 direction, playerid owner)
 {
-	Player* opposition;
-	if (owner == 1)	opposition = &(state->p2); else opposition = &(state->p1);
-	flux->hitscans.push_back({ false, origin, direction, owner });
+	//everything this shot causes this frame, numbered in the order it happens; a shot released by a hit inside this one
+	//numbers its own from its own shooter
+	std::uint16_t seq = static_cast<std::uint16_t>(owner) << 8;
+	flux->hitscans.push_back({ false, origin, direction, owner, eventId(state->frame, owner, seq++) });
 	//PARRY
-	if (opposition->pushdown.top() == PState::Dashing &&
-		opposition->dashCount < cfg->dashPerfect)
+	//the first player in line to perfect dash it sends it back, only once
+	for (int i = 0; i < state->playerCount; i++)
 	{
-		Vec2 dotDist = v2::closest(origin, direction, opposition->perfectPos);
-		if (v2::rayWithinRadius(dotDist.x, dotDist.y, cfg->playerRadius))
+		Player* parrier = &(state->players[i]);
+		if (parrier->id == owner) continue;
+		if (parrier->pushdown.top() == PState::Dashing &&
+			parrier->dashCount < cfg->dashPerfect)
 		{
-			//right back at ya
-			origin = v2::add(v2::projection(v2::sub(opposition->perfectPos, origin), direction), origin);
-			direction = v2::scalarMult(direction, num_det{ -1 });
-			owner = opposition->id;
-			opposition->pushdown.push(PState::Hitstop);
-			opposition->hitstopCount = cfg->midHitstop;
-			if (owner == 1)	opposition = &(state->p2); else opposition = &(state->p1);
-			//add another hitscan juuuust a bit to the side
-			flux->hitscans.push_back({ false, v2::add(origin, v2::scalarMult(v2::rotate(direction, origin.x.half_pi()), num_det{0.01f})), direction, owner});
+			Vec2 dotDist = v2::closest(origin, direction, parrier->perfectPos);
+			if (v2::rayWithinRadius(dotDist.x, dotDist.y, cfg->playerRadius))
+			{
+				//right back at ya
+				origin = v2::add(v2::projection(v2::sub(parrier->perfectPos, origin), direction), origin);
+				direction = v2::scalarMult(direction, num_det{ -1 });
+				owner = parrier->id;
+				parrier->pushdown.push(PState::Hitstop);
+				parrier->hitstopCount = cfg->midHitstop;
+				//add another hitscan juuuust a bit to the side
+				flux->hitscans.push_back({ false, v2::add(origin, v2::scalarMult(v2::rotate(direction, COMPASS_RIGHT), num_det{0.01f})), direction, owner, eventId(state->frame, owner, seq++) });
+				break;
+			}
 		}
 	}
 	//DIRECT HIT OR GRAZE
-	Vec2 dotDist = v2::closest(origin, direction, opposition->pos);
-	if (!opposition->stunned && (dotDist.x > num_det{ 0 }))
+	for (int i = 0; i < state->playerCount; i++)
 	{
-		if (dotDist.y < cfg->playerRadius)
-		{
-			damagePlayer(opposition, flux, state, cfg, origin, 2);
-			if (owner == 1)	regDamage(state, 2); else regDamage(state, 1);
-		}
-		else if (dotDist.y < cfg->grazeRadius)
+		Player* opposition = &(state->players[i]);
+		if (opposition->id == owner) continue;
+		Vec2 dotDist = v2::closest(origin, direction, opposition->pos);
+		if (!opposition->stunned && (dotDist.x > num_det{ 0 }))
 		{
-			opposition->ammo = cfg->ammoMax;
-			opposition->stamina = cfg->staminaMax;
-			flux->grazes.push_back({ false, opposition->pos });
+			if (dotDist.y < cfg->playerRadius)
+			{
+				damagePlayer(opposition, flux, state, cfg, origin, 2);
+				regDamage(state, opposition->id);
+			}
+			else if (dotDist.y < cfg->grazeRadius)
+			{
+				opposition->ammo = cfg->ammoMax;
+				opposition->stamina = cfg->staminaMax;
+				flux->grazes.push_back({ false, opposition->pos, eventId(state->frame, owner, seq++) });
+			}
 		}
 	}
 
 	//COMBO
-	auto it = state->projs.begin();
-	while (it != state->projs.end())
+	RayCells ray;
+	markRay(&collisionGrid, &ray, origin, direction, cfg->projRadius);
+	ProjectilePool* projs = &(state->projs);
+	projslot slot = firstProjectile(projs);
+	while (slot != NO_PROJECTILE)
 	{
-		Vec2 dotDist = v2::closest(origin, direction, it->pos);
-		if (v2::rayWithinRadius(dotDist.x, dotDist.y, cfg->projRadius))
+		Vec2 pos = projectilePos(projs, slot);
+		if (onRay(&collisionGrid, &ray, pos))
 		{
-			if (!state->p1.stunned && v2::length(v2::sub(it->pos, state->p1.pos)) < (cfg->comboRadius + cfg->playerRadius))
-			{
-				damagePlayer(&(state->p1), flux, state, cfg, it->pos, 3);
-				regDamage(state, 1);
-			}
-			if (!state->p2.stunned && v2::length(v2::sub(it->pos, state->p2.pos)) < (cfg->comboRadius + cfg->playerRadius))
+			Vec2 dotDist = v2::closest(origin, direction, pos);
+			if (v2::rayWithinRadius(dotDist.x, dotDist.y, cfg->projRadius))
 			{
-				damagePlayer(&(state->p2), flux, state, cfg, it->pos, 3);
-				regDamage(state, 2);
+				const GridCell* cell = gridCell(&collisionGrid, pos);
+				for (int i = 0; i < state->playerCount; i++)
+				{
+					Player* caught = &(state->players[i]);
+					//anyone caught before might have been holding a full charge, and that railgun can combo this projectile first
+					if (slotAlive(projs, slot) && !caught->stunned && (cell->combo & playerBit(caught->id)) && v2::length(v2::sub(pos, caught->pos)) < (cfg->comboRadius + cfg->playerRadius))
+					{
+						damagePlayer(caught, flux, state, cfg, pos, 3);
+						regDamage(state, caught->id);
+					}
+				}
+				if (slotAlive(projs, slot))
+				{
+					flux->combos.push_back({ false,pos,eventId(state->frame, owner, seq++) });
+					removeProjectile(projs, slot);
+				}
 			}
-			flux->combos.push_back({ false,it->pos });
-			state->projs.erase(it);
-		}
-		else
-		{
-			++it;
 		}
+		slot = nextProjectile(projs, slot);
 	}
 }
 
 Vec2 pickDashDir(Vec2 front, MoveInput mov)
 {
-	const num_det num;
-	const num_det quarter_pi = num.pi() / 4;
 	switch (mov)
 	{
 	case MoveInput::ForLeft:
-		return v2::rotate(front, -quarter_pi);
+		return v2::rotate(front, COMPASS_FOR_LEFT);
 	case MoveInput::Left:
-		return v2::rotate(front, -num.half_pi());
+		return v2::rotate(front, COMPASS_LEFT);
 	case MoveInput::BackLeft:
-		return v2::rotate(front, num.pi() + quarter_pi);
+		return v2::rotate(front, COMPASS_BACK_LEFT);
 	case MoveInput::Back:
 		return v2::scalarMult(front, num_det{ -1 });
 	case MoveInput::BackRight:
-		return v2::rotate(front, num.pi() - quarter_pi);
+		return v2::rotate(front, COMPASS_BACK_RIGHT);
 	case MoveInput::Right:
-		return v2::rotate(front, num.half_pi());
+		return v2::rotate(front, COMPASS_RIGHT);
 	case MoveInput::ForRight:
-		return v2::rotate(front, quarter_pi);
+		return v2::rotate(front, COMPASS_FOR_RIGHT);
 	default:
 		return front;
 	}
 }
 
-GameState simulate(GameState state, SecSimFlux* flux, const Config* cfg, InputData input)
+//what's left of a player's step once its move has been added: back inside the arena, resources and state countdowns
+void settlePlayer(Player* player, const Config* cfg)
 {
-	state.frame++;
-	state.roundCountdown--;
-	switch (state.phase)
+	keepInArena(player, cfg);
+	player->ammo++;
+	player->ammo = std::min(player->ammo, cfg->ammoMax);
+	player->stamina++;
+	player->stamina = std::min(player->stamina, cfg->staminaMax);
+	switch (player->pushdown.top())
 	{
-	case RoundPhase::Countdown:
-		if (state.roundCountdown <= 0)
+	case PState::Dashing:
+		player->dashCount++;
+		if (player->dashCount >= cfg->dashDuration)
 		{
-			state.roundCountdown = cfg->roundTime;
-			state.phase = RoundPhase::Play;
+			player->pushdown.pop();
 		}
 		break;
-	case RoundPhase::End:
-		if (state.roundCountdown <= 0)
+	case PState::Charging:
+		player->chargeCount++;
+		break;
+	case PState::Hitstop:
+		player->hitstopCount--;
+		if (player->hitstopCount <= 0)
 		{
-			if (state.rounds1 < cfg->roundsToWin && state.rounds2 < cfg->roundsToWin)
-			{
-				state.roundCountdown = cfg->roundCountdown;
-				state.phase = RoundPhase::Countdown;
-				respawnPlayer(&(state.p1), cfg, state.p1.id);
-				state.health1 = cfg->playerHealth;
-				respawnPlayer(&(state.p2), cfg, state.p2.id);
-				state.health2 = cfg->playerHealth;
-				state.projs.clear();
-			}
-			break;
+			player->pushdown.pop();
 		}
-		// will simulate at half speed
-		else if (state.roundCountdown % 2 == 0)
+		break;
+	}
+}
+
+//a projectile's events are known by the frame it was fired on (counted back the way its lifetime counted up) and its
+//spawn serial, which no other projectile alive has and which a snapshot keeps, unlike the slot
+inline std::uint64_t projectileEventId(const GameState* state, projslot slot)
+{
+	const ProjectilePool* projs = &(state->projs);
+	return eventId(state->frame - projs->lifetime[slot], projs->owner[slot], projs->serial[slot]);
+}
+
+//one projectile against everyone but its owner, first player it touches in id order takes it
+void collideProjectile(GameState* state, SecSimFlux* flux, const Config* cfg, projslot slot)
+{
+	ProjectilePool* projs = &(state->projs);
+	Vec2 pos = projectilePos(projs, slot);
+	const GridCell* cell = gridCell(&collisionGrid, pos);
+	if (!cell->insideArena && v2::length(pos) > cfg->arenaRadius)
+	{
+		flux->projs.push_back({ false,pos,projs->owner[slot],projectileEventId(state, slot) });
+		removeProjectile(projs, slot);
+		return;
+	}
+	playerid owner = projs->owner[slot];
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		Player* target = &(state->players[i]);
+		if (target->id == owner) continue;
+		if (target->pushdown.top() == PState::Dashing &&
+			target->dashCount < cfg->dashPerfect &&
+			(cell->perfect & playerBit(target->id)) &&
+			v2::length(v2::sub(pos, target->perfectPos)) < (cfg->playerRadius + cfg->projRadius))
 		{
-			break;
+			//ayo a parry just happened, send that projectile back
+			projs->owner[slot] = target->id;
+			num_det newSpeed = v2::length(projectileVel(projs, slot)) * cfg->projCounterMultiply;
+			setProjectileVel(projs, slot, v2::normalizeMult(v2::sub(playerById(state, owner)->pos, pos), newSpeed));
+			target->pushdown.push(PState::Hitstop);
+			target->hitstopCount = cfg->weakHitstop;
+			return;
 		}
-		input.p1Input = PlayerInput{};
-		input.p2Input = PlayerInput{};
-	case RoundPhase::Play:
-		state.p1DmgThisFrame = false;
-		state.p2DmgThisFrame = false;
-
-		//PLAYER 1
-		movePlayer(&(state.p1), cfg, input.p1Input);
-		state.p1.ammo = std::min(++state.p1.ammo, cfg->ammoMax);
-		state.p1.stamina = std::min(++state.p1.stamina, cfg->staminaMax);
-		switch (state.p1.pushdown.top())
+		else if (!target->stunned && //not stunned
+			(target->pushdown.top() != PState::Dashing || target->dashCount < projs->lifetime[slot]) && //not dashing, or dashing but dash is "younger"
+			(cell->body & playerBit(target->id)) && //close enough to be worth checking
+			v2::length(v2::sub(pos, target->pos)) < (cfg->playerRadius + cfg->projRadius)) //collision happened
 		{
-		case PState::Dashing:
-			state.p1.dashCount++;
-			if (state.p1.dashCount >= cfg->dashDuration)
+			damagePlayer(target, flux, state, cfg, pos, 1);
+			regDamage(state, target->id);
+			//a full charge gets released by the hit, and its combo may have taken this projectile already
+			if (slotAlive(projs, slot))
 			{
-				state.p1.pushdown.pop();
+				flux->projs.push_back({ false,pos,projs->owner[slot],projectileEventId(state, slot) });
+				removeProjectile(projs, slot);
 			}
-			break;
-		case PState::Charging:
-			state.p1.chargeCount++;
-			break;
-		case PState::Hitstop:
-			state.p1.hitstopCount--;
-			if (state.p1.hitstopCount <= 0)
-			{
-				state.p1.pushdown.pop();
-			}
-			break;
+			return;
 		}
-		//PLAYER 2
-		movePlayer(&(state.p2), cfg, input.p2Input);
-		state.p2.ammo = std::min(++state.p2.ammo, cfg->ammoMax);
-		state.p2.stamina = std::min(++state.p2.stamina, cfg->staminaMax);
-		switch (state.p2.pushdown.top())
+	}
+}
+
+//dash against dash or body for one pair of players, a comes before b in id order
+void resolveDashes(GameState* state, SecSimFlux* flux, const Config* cfg, Player* a, Player* b)
+{
+	bool directColl = v2::length(v2::sub(a->pos, b->pos)) < (cfg->playerRadius + cfg->playerRadius);
+	//BOTH DASHING IN THIS FRAME
+	if (a->pushdown.top() == PState::Dashing && b->pushdown.top() == PState::Dashing)
+	{
+		//DIRECT HIT, MOST RECENT DASH LOSES
+		if (directColl)
 		{
-		case PState::Dashing:
-			state.p2.dashCount++;
-			if (state.p2.dashCount >= cfg->dashDuration)
-			{
-				state.p2.pushdown.pop();
-			}
-			break;
-		case PState::Charging:
-			state.p2.chargeCount++;
-			break;
-		case PState::Hitstop:
-			state.p2.hitstopCount--;
-			if (state.p2.hitstopCount <= 0)
+			int dashDiff = a->dashCount - b->dashCount;
+			if (dashDiff > 0)
 			{
-				state.p2.pushdown.pop();
+				damagePlayer(b, flux, state, cfg, a->pos, 2);
+				regDamage(state, b->id);
+				a->pushdown.push(PState::Hitstop);
+				a->hitstopCount = cfg->midHitstop;
 			}
-			break;
-		}
-		//PROJECTILES - MOVE AND CHECK FOR COLLISION OR PARRY
-		auto it = state.projs.begin();
-		while (it != state.projs.end())
-		{
-			bool erased = false;
-			it->pos = v2::add(it->pos, it->vel);
-			it->lifetime++;
-			if (v2::length(it->pos) > cfg->arenaRadius)
+			else if (dashDiff < 0)
 			{
-				flux->projs.push_back({ false,it->pos,it->owner });
-				state.projs.erase(it);
-				erased = true;
+				damagePlayer(a, flux, state, cfg, b->pos, 2);
+				regDamage(state, a->id);
+				b->pushdown.push(PState::Hitstop);
+				b->hitstopCount = cfg->midHitstop;
 			}
 			else
 			{
-				switch (it->owner)
-				{
-				case 1:
-					if (state.p2.pushdown.top() == PState::Dashing &&
-						state.p2.dashCount < cfg->dashPerfect &&
-						v2::length(v2::sub(it->pos, state.p2.perfectPos)) < (cfg->playerRadius + cfg->projRadius))
-					{
-						//ayo a parry just happened, send that projectile back
-						it->owner = 2;
-						num_det newSpeed = v2::length(it->vel) * cfg->projCounterMultiply;
-						it->vel = v2::normalizeMult(v2::sub(state.p1.pos, it->pos), newSpeed);
-						state.p2.pushdown.push(PState::Hitstop);
-						state.p2.hitstopCount = cfg->weakHitstop;
-					}
-					else if (!state.p2.stunned && //not stunned
-						(state.p2.pushdown.top() != PState::Dashing || state.p2.dashCount < it->lifetime) && //not dashing, or dashing but dash is "younger"
-						v2::length(v2::sub(it->pos, state.p2.pos)) < (cfg->playerRadius + cfg->projRadius)) //collision happened
-					{
-						damagePlayer(&(state.p2), flux, &state, cfg, it->pos, 1);
-						regDamage(&state, 2);
-						flux->projs.push_back({ false,it->pos,it->owner });
-						state.projs.erase(it);
-						erased = true;
-					}
-					break;
-				case 2:
-					if (state.p1.pushdown.top() == PState::Dashing &&
-						state.p1.dashCount < cfg->dashPerfect &&
-						v2::length(v2::sub(it->pos, state.p1.perfectPos)) < (cfg->playerRadius + cfg->projRadius))
-					{
-						//ayo a parry just happened, send that projectile back
-						it->owner = 1;
-						num_det newSpeed = v2::length(it->vel) * cfg->projCounterMultiply;
-						it->vel = v2::normalizeMult(v2::sub(state.p2.pos, it->pos), newSpeed);
-						state.p1.pushdown.push(PState::Hitstop);
-						state.p1.hitstopCount = cfg->weakHitstop;
-					}
-					else if (
-						!state.p1.stunned && //not stunned
-						(state.p1.pushdown.top() != PState::Dashing || state.p1.dashCount < it->lifetime) && //not dashing, or dashing but dash is "younger"
-						v2::length(v2::sub(it->pos, state.p1.pos)) < (cfg->playerRadius + cfg->projRadius)) //collision happened
-					{
-						damagePlayer(&(state.p1), flux, &state, cfg, it->pos, 1);
-						regDamage(&state, 1);
-						flux->projs.push_back({ false,it->pos,it->owner });
-						state.projs.erase(it);
-						erased = true;
-					}
-					break;
-				}
-			}
-			if (!erased) ++it;
-		}
-		//DASHING
-		bool directColl = v2::length(v2::sub(state.p1.pos, state.p2.pos)) < (cfg->playerRadius + cfg->playerRadius);
-		//BOTH DASHING IN THIS FRAME
-		if (state.p1.pushdown.top() == PState::Dashing && state.p2.pushdown.top() == PState::Dashing)
-		{
-			//DIRECT HIT, MOST RECENT DASH LOSES
-			if (directColl)
-			{
-				int dashDiff = state.p1.dashCount - state.p2.dashCount;
-				if (dashDiff > 0)
-				{
-					damagePlayer(&(state.p2), flux, &state, cfg, state.p1.pos, 2);
-					regDamage(&state, 2);
-					state.p1.pushdown.push(PState::Hitstop);
-					state.p1.hitstopCount = cfg->midHitstop;
-				}
-				else if (dashDiff < 0)
-				{
-					damagePlayer(&(state.p1), flux, &state, cfg, state.p2.pos, 2);
-					regDamage(&state, 1);
-					state.p2.pushdown.push(PState::Hitstop);
-					state.p2.hitstopCount = cfg->midHitstop;
-				}
-				else
-				{
-					damagePlayer(&(state.p1), flux, &state, cfg, state.p2.pos, 2);
-					regDamage(&state, 1);
-					damagePlayer(&(state.p2), flux, &state, cfg, state.p1.pos, 2);
-					regDamage(&state, 2);
-				}
-			}
-			//P2 PERFECT EVADES
-			else if (state.p2.dashCount < cfg->dashPerfect && (v2::length(v2::sub(state.p1.pos, state.p2.perfectPos))) < (cfg->playerRadius + cfg->playerRadius))
-			{
-				damagePlayer(&(state.p1), flux, &state, cfg, state.p2.perfectPos, 2);
-				regDamage(&state, 1);
-				state.p2.pushdown.push(PState::Hitstop);
-				state.p2.hitstopCount = cfg->midHitstop;
-			}
-			//P1 PERFECT EVADES
-			else if (state.p1.dashCount < cfg->dashPerfect && (v2::length(v2::sub(state.p2.pos, state.p1.perfectPos))) < (cfg->playerRadius + cfg->playerRadius))
-			{
-				damagePlayer(&(state.p2), flux, &state, cfg, state.p1.perfectPos, 2);
-				regDamage(&state, 2);
-				state.p1.pushdown.push(PState::Hitstop);
-				state.p1.hitstopCount = cfg->midHitstop;
+				damagePlayer(a, flux, state, cfg, b->pos, 2);
+				regDamage(state, a->id);
+				damagePlayer(b, flux, state, cfg, a->pos, 2);
+				regDamage(state, b->id);
 			}
 		}
-		//P1 HITS P2
-		else if (directColl && !state.p2.stunned && state.p1.pushdown.top() == PState::Dashing)
+		//B PERFECT EVADES
+		else if (b->dashCount < cfg->dashPerfect && (v2::length(v2::sub(a->pos, b->perfectPos))) < (cfg->playerRadius + cfg->playerRadius))
 		{
-			damagePlayer(&(state.p2), flux, &state, cfg, state.p1.pos, 2);
-			regDamage(&state, 2);
-			state.p1.pushdown.push(PState::Hitstop);
-			state.p1.hitstopCount = cfg->midHitstop;
+			damagePlayer(a, flux, state, cfg, b->perfectPos, 2);
+			regDamage(state, a->id);
+			b->pushdown.push(PState::Hitstop);
+			b->hitstopCount = cfg->midHitstop;
 		}
-		//P2 HITS P1
-		else if (directColl && !state.p1.stunned && state.p2.pushdown.top() == PState::Dashing)
+		//A PERFECT EVADES
+		else if (a->dashCount < cfg->dashPerfect && (v2::length(v2::sub(b->pos, a->perfectPos))) < (cfg->playerRadius + cfg->playerRadius))
 		{
-			damagePlayer(&(state.p1), flux, &state, cfg, state.p2.pos, 2);
-			regDamage(&state, 1);
-			state.p2.pushdown.push(PState::Hitstop);
-			state.p2.hitstopCount = cfg->midHitstop;
+			damagePlayer(b, flux, state, cfg, a->perfectPos, 2);
+			regDamage(state, b->id);
+			a->pushdown.push(PState::Hitstop);
+			a->hitstopCount = cfg->midHitstop;
 		}
+	}
+	//A HITS B
+	else if (directColl && !b->stunned && a->pushdown.top() == PState::Dashing)
+	{
+		damagePlayer(b, flux, state, cfg, a->pos, 2);
+		regDamage(state, b->id);
+		a->pushdown.push(PState::Hitstop);
+		a->hitstopCount = cfg->midHitstop;
+	}
+	//B HITS A
+	else if (directColl && !a->stunned && b->pushdown.top() == PState::Dashing)
+	{
+		damagePlayer(a, flux, state, cfg, b->pos, 2);
+		regDamage(state, a->id);
+		b->pushdown.push(PState::Hitstop);
+		b->hitstopCount = cfg->midHitstop;
+	}
+}
 
-		//ALT SHOT
-		if (state.p1.pushdown.top() == PState::Charging && state.p1.chargeCount >= cfg->chargeDuration)
+//dashes, shots and alerts for one player
+void playerAttacks(GameState* state, SecSimFlux* flux, const Config* cfg, Player* player, PlayerInput input)
+{
+	bool damagedThisFrame = state->dmgThisFrame[player->id - 1];
+	if (player->stunned)
+	{
+		//alert: break out of stun at the cost all your stamina
+		if (player->pushdown.top() != PState::Hitstop && //can't alert out of hitstop
+			input.atk == AttackInput::Dash &&
+			!damagedThisFrame && //can't alert out of the same frame you were damaged
+			player->stamina >= cfg->dashCost) //need to have enough stamina for a dash
 		{
-			state.p1.pushdown.pop();
-			altShot(&state, flux, cfg, state.p1.pos, state.p1.dir, 1);
+			player->dashCount = 0;
+			player->dashVel = v2::scalarMult(pickDashDir(player->dir, input.mov), cfg->playerDashSpeed);
+			player->perfectPos = player->pos;
+			player->pushdown.push(PState::Dashing);
+			player->stamina = 0;
+			player->stunned = false;
+			flux->alerts.push_back({ false, player->pos, eventId(state->frame, player->id, 0) });
 		}
-		if (state.p2.pushdown.top() == PState::Charging && state.p2.chargeCount >= cfg->chargeDuration)
+		//cancel your next move nevertheless
+		input.atk = AttackInput::None;
+	}
+	if (player->pushdown.top() == PState::Default)
+	{
+		switch (input.atk)
 		{
-			state.p2.pushdown.pop();
-			altShot(&state, flux, cfg, state.p2.pos, state.p2.dir, 2);
+		case AttackInput::Dash:
+			if (player->stamina < cfg->dashCost) break;
+			player->dashCount = 0;
+			player->dashVel = v2::scalarMult(pickDashDir(player->dir, input.mov), cfg->playerDashSpeed);
+			player->perfectPos = player->pos;
+			player->pushdown.push(PState::Dashing);
+			player->stamina = player->stamina - cfg->dashCost;
+			break;
+		case AttackInput::Shot:
+			if (player->ammo < cfg->shotCost) break;
+			spawnProjectile(&(state->projs), { player->pos, v2::scalarMult(player->dir, cfg->projSpeed), player->id, 0 });
+			player->ammo = player->ammo - cfg->shotCost;
+			break;
+		case AttackInput::AltShot:
+			if (player->ammo < cfg->altShotCost) break;
+			player->chargeCount = 0;
+			player->pushdown.push(PState::Charging);
+			player->ammo = player->ammo - cfg->altShotCost;
+			break;
 		}
+	}
+	//WEAVE A DASH INTO ANOTHER
+	else if (player->pushdown.top() == PState::Dashing &&
+		input.atk == AttackInput::Dash &&
+		player->stamina >= cfg->dashCost)
+	{
+		player->dashCount = 0;
+		player->dashVel = v2::scalarMult(pickDashDir(player->dir, input.mov), cfg->playerDashSpeed);
+		player->perfectPos = player->pos;
+		player->stamina = player->stamina - cfg->dashCost;
+	}
+}
 
-		state.p1.stunned = state.p1.stunned || state.p1DmgThisFrame;
-		state.p2.stunned = state.p2.stunned || state.p2DmgThisFrame;
+//a frame is simulate() in these steps, in this order; BatchSim.hpp runs them itself so it can do the moves of many
+//matches at once
 
-		//PLAYER 1 ATTACKS
-		if (state.p1.stunned)
+//the frame count and the round phases; true if the players and projectiles get stepped this frame, with the inputs
+//they get (the end of a round plays on at half speed with nobody's input)
+bool framePlays(GameState* state, const Config* cfg, InputData* input)
+{
+	state->frame++;
+	state->roundCountdown--;
+	switch (state->phase)
+	{
+	case RoundPhase::Countdown:
+		if (state->roundCountdown <= 0)
 		{
-			//alert: break out of stun at the cost all your stamina
-			if (state.p1.pushdown.top() != PState::Hitstop && //can't alert out of hitstop
-				input.p1Input.atk == AttackInput::Dash &&
-				!state.p1DmgThisFrame && //can't alert out of the same frame you were damaged
-				state.p1.stamina >= cfg->dashCost) //need to have enough stamina for a dash
-			{
-				state.p1.dashCount = 0;
-				state.p1.dashVel = v2::scalarMult(pickDashDir(state.p1.dir, input.p1Input.mov), cfg->playerDashSpeed);
-				state.p1.perfectPos = state.p1.pos;
-				state.p1.pushdown.push(PState::Dashing);
-				state.p1.stamina = 0;
-				state.p1.stunned = false;
-				flux->alerts.push_back({false, state.p1.pos});
-			}
-			//cancel your next move nevertheless
-			input.p1Input.atk = AttackInput::None;
+			state->roundCountdown = cfg->roundTime;
+			state->phase = RoundPhase::Play;
 		}
-		if (state.p1.pushdown.top() == PState::Default)
+		return false;
+	case RoundPhase::End:
+		if (state->roundCountdown <= 0)
 		{
-			switch (input.p1Input.atk)
+			if (!matchWon(state, cfg))
 			{
-			case AttackInput::Dash:
-				if (state.p1.stamina < cfg->dashCost) break;
-				state.p1.dashCount = 0;
-				state.p1.dashVel = v2::scalarMult(pickDashDir(state.p1.dir, input.p1Input.mov), cfg->playerDashSpeed);
-				state.p1.perfectPos = state.p1.pos;
-				state.p1.pushdown.push(PState::Dashing);
-				state.p1.stamina = state.p1.stamina - cfg->dashCost;
-				break;
-			case AttackInput::Shot:
-				if (state.p1.ammo < cfg->shotCost) break;
-				state.projs.push_back({ state.p1.pos, v2::scalarMult(state.p1.dir, cfg->projSpeed), 1, 0 });
-				state.p1.ammo = state.p1.ammo - cfg->shotCost;
-				break;
-			case AttackInput::AltShot:
-				if (state.p1.ammo < cfg->altShotCost) break;
-				state.p1.chargeCount = 0;
-				state.p1.pushdown.push(PState::Charging);
-				state.p1.ammo = state.p1.ammo - cfg->altShotCost;
-				break;
+				state->roundCountdown = cfg->roundCountdown;
+				state->phase = RoundPhase::Countdown;
+				for (int i = 0; i < state->playerCount; i++)
+				{
+					respawnPlayer(&(state->players[i]), cfg, state->players[i].id, state->playerCount);
+					state->health[i] = cfg->playerHealth;
+				}
+				clearProjectiles(&(state->projs));
 			}
+			return false;
 		}
-		//WEAVE A DASH INTO ANOTHER
-		else if (state.p1.pushdown.top() == PState::Dashing &&
-			input.p1Input.atk == AttackInput::Dash &&
-			state.p1.stamina >= cfg->dashCost)
+		// will simulate at half speed
+		else if (state->roundCountdown % 2 == 0)
 		{
-			state.p1.dashCount = 0;
-			state.p1.dashVel = v2::scalarMult(pickDashDir(state.p1.dir, input.p1Input.mov), cfg->playerDashSpeed);
-			state.p1.perfectPos = state.p1.pos;
-			state.p1.stamina = state.p1.stamina - cfg->dashCost;
+			return false;
 		}
-
-		//PLAYER 2 ATTACKS
-		if (state.p2.stunned)
+		for (int i = 0; i < state->playerCount; i++)
 		{
-			//alert: break out of stun at the cost all your stamina
-			if (state.p2.pushdown.top() != PState::Hitstop && //can't alert out of hitstop
-				input.p2Input.atk == AttackInput::Dash &&
-				!state.p2DmgThisFrame && //can't alert out of the same frame you were damaged
-				state.p2.stamina >= cfg->dashCost) //need to have enough stamina for a dash
-			{
-				state.p2.dashCount = 0;
-				state.p2.dashVel = v2::scalarMult(pickDashDir(state.p2.dir, input.p2Input.mov), cfg->playerDashSpeed);
-				state.p2.perfectPos = state.p2.pos;
-				state.p2.pushdown.push(PState::Dashing);
-				state.p2.stamina = 0;
-				state.p2.stunned = false;
-				flux->alerts.push_back({ false, state.p2.pos });
-			}
-			//cancel your next move nevertheless
-			input.p2Input.atk = AttackInput::None;
+			input->players[i] = PlayerInput{};
 		}
-		if (state.p2.pushdown.top() == PState::Default)
+		return true;
+	case RoundPhase::Play:
+		return true;
+	}
+	return false;
+}
+
+//PLAYERS - how far each one moves, into steps; the moves themselves are added on by the caller
+void playerSteps(GameState* state, const Config* cfg, const InputData* input, Vec2* steps)
+{
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		state->dmgThisFrame[i] = false;
+	}
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		steps[i] = playerStep(&(state->players[i]), cfg, input->players[i]);
+	}
+}
+
+//and the rest of their step once they've moved
+void settlePlayers(GameState* state, const Config* cfg)
+{
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		settlePlayer(&(state->players[i]), cfg);
+	}
+}
+
+//a player hit during the projectile walk while holding a full charge lets it go, and that railgun sees the projectiles
+//the walk hasn't got to yet; only while nobody can, the projectiles can all be moved before the walk
+bool chargeReleasable(const GameState* state, const Config* cfg)
+{
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		const Player* player = &(state->players[i]);
+		if (player->pushdown.top() == PState::Charging && player->chargeCount >= cfg->chargeDuration) return true;
+	}
+	return false;
+}
+
+//everything after the players moved; projectilesMoved if the caller already moved every projectile by its velocity,
+//which only gives the same frame while chargeReleasable() is false
+void resolveFrame(GameState* state, SecSimFlux* flux, const Config* cfg, InputData input, bool projectilesMoved)
+{
+	int count = state->playerCount;
+	//BROADPHASE - positions are final for this frame from here on
+	resetCollisionGrid(&collisionGrid, cfg);
+	for (int i = 0; i < count; i++)
+	{
+		markPlayer(&collisionGrid, &(state->players[i]), cfg);
+	}
+
+	//PROJECTILES - MOVE AND CHECK FOR COLLISION OR PARRY
+	//in spawn order, each one moved right before its own check: a railgun let go mid-walk sees the ones after it
+	//where they were last frame, and replays depend on that
+	ProjectilePool* projs = &(state->projs);
+	projslot slot = firstProjectile(projs);
+	while (slot != NO_PROJECTILE)
+	{
+		if (!projectilesMoved) moveProjectile(projs, slot);
+		projs->lifetime[slot]++;
+		collideProjectile(state, flux, cfg, slot);
+		slot = nextProjectile(projs, slot);
+	}
+	//DASHING
+	for (int a = 0; a < count; a++)
+	{
+		for (int b = a + 1; b < count; b++)
 		{
-			switch (input.p2Input.atk)
-			{
-			case AttackInput::Dash:
-				if (state.p2.stamina < cfg->dashCost) break;
-				state.p2.dashCount = 0;
-				state.p2.dashVel = v2::scalarMult(pickDashDir(state.p2.dir, input.p2Input.mov), cfg->playerDashSpeed);
-				state.p2.perfectPos = state.p2.pos;
-				state.p2.pushdown.push(PState::Dashing);
-				state.p2.stamina = state.p2.stamina - cfg->dashCost;
-				break;
-			case AttackInput::Shot:
-				if (state.p2.ammo < cfg->shotCost) break;
-				state.projs.push_back({ state.p2.pos, v2::scalarMult(state.p2.dir, cfg->projSpeed), 2, 0 });
-				state.p2.ammo = state.p2.ammo - cfg->shotCost;
-				break;
-			case AttackInput::AltShot:
-				if (state.p2.ammo < cfg->altShotCost) break;
-				state.p2.chargeCount = 0;
-				state.p2.pushdown.push(PState::Charging);
-				state.p2.ammo = state.p2.ammo - cfg->altShotCost;
-				break;
-			}
+			resolveDashes(state, flux, cfg, &(state->players[a]), &(state->players[b]));
 		}
-		//WEAVE A DASH INTO ANOTHER
-		else if (state.p2.pushdown.top() == PState::Dashing &&
-			input.p2Input.atk == AttackInput::Dash &&
-			state.p2.stamina >= cfg->dashCost)
+	}
+
+	//ALT SHOT
+	for (int i = 0; i < count; i++)
+	{
+		Player* player = &(state->players[i]);
+		if (player->pushdown.top() == PState::Charging && player->chargeCount >= cfg->chargeDuration)
 		{
-			state.p2.dashCount = 0;
-			state.p2.dashVel = v2::scalarMult(pickDashDir(state.p2.dir, input.p2Input.mov), cfg->playerDashSpeed);
-			state.p2.perfectPos = state.p2.pos;
-			state.p2.stamina = state.p2.stamina - cfg->dashCost;
+			player->pushdown.pop();
+			altShot(state, flux, cfg, player->pos, player->dir, player->id);
 		}
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		state->players[i].stunned = state->players[i].stunned || state->dmgThisFrame[i];
+	}
+
+	//ATTACKS
+	for (int i = 0; i < count; i++)
+	{
+		playerAttacks(state, flux, cfg, &(state->players[i]), input.players[i]);
+	}
 
-		//ROUND END
-		if (state.phase == RoundPhase::Play && (state.roundCountdown <= 0 || state.health1 <= 0 || state.health2 <= 0))
+	//ROUND END
+	if (state->phase == RoundPhase::Play && (state->roundCountdown <= 0 || playersStanding(state) <= 1))
+	{
+		//round goes to whoever kept the most health, nobody gets it on a tie at the top
+		int best = 0;
+		bool tied = false;
+		for (int i = 1; i < count; i++)
 		{
-			if (state.health1 > state.health2)
+			if (state->health[i] > state->health[best])
 			{
-				state.rounds1++;
+				best = i;
+				tied = false;
 			}
-			else if (state.health2 > state.health1)
+			else if (state->health[i] == state->health[best])
 			{
-				state.rounds2++;
+				tied = true;
 			}
-			state.roundCountdown = cfg->roundEndTime;
-			state.phase = RoundPhase::End;
 		}
+		if (!tied)
+		{
+			state->rounds[best]++;
+		}
+		state->roundCountdown = cfg->roundEndTime;
+		state->phase = RoundPhase::End;
+	}
+}
 
-		break;
+//advances the state in place, this is what the game loop and GGPO callbacks call every frame
+//every per-player step runs in id order, which is the order the two player version always ran them in
+void simulate(GameState* state, SecSimFlux* flux, const Config* cfg, InputData input)
+{
+	if (!framePlays(state, cfg, &input)) return;
+	Vec2 steps[MAX_PLAYERS];
+	playerSteps(state, cfg, &input, steps);
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		state->players[i].pos = v2::add(state->players[i].pos, steps[i]);
 	}
+	settlePlayers(state, cfg);
+	resolveFrame(state, flux, cfg, input, false);
+}
+
+//by-value variant, kept for callers that want the previous state untouched
+//costs a copy of the whole GameState going in and another one coming out
+GameState simulate(GameState state, SecSimFlux* flux, const Config* cfg, InputData input)
+{
+	simulate(&state, flux, cfg, input);
 	return state;
 }
 
+//double-buffered holder for callers that need the previous frame alongside the current one
+//one copy per frame instead of the two (plus assignment) of the by-value variant
+struct GameStateBuffer
+{
+	GameState states[2];
+	int current = 0;
+};
+
+void resetStateBuffer(GameStateBuffer* buffer, const GameState* state)
+{
+	buffer->states[0] = *state;
+	buffer->states[1] = *state;
+	buffer->current = 0;
+}
+
+inline GameState* currentState(GameStateBuffer* buffer)
+{
+	return &(buffer->states[buffer->current]);
+}
+
+inline GameState* previousState(GameStateBuffer* buffer)
+{
+	return &(buffer->states[buffer->current ^ 1]);
+}
+
+void simulate(GameStateBuffer* buffer, SecSimFlux* flux, const Config* cfg, InputData input)
+{
+	GameState* next = previousState(buffer);
+	*next = *currentState(buffer);
+	simulate(next, flux, cfg, input);
+	buffer->current ^= 1;
+}
+
 bool endCondition(const GameState* state, const Config* cfg)
 {
 	bool phaseIsEnd = state->phase == End;
 	bool countdownEnded = state->roundCountdown <= 0;
-	bool aPlayerWon = state->rounds1 >= cfg->roundsToWin || state->rounds2 >= cfg->roundsToWin;
-	return phaseIsEnd && countdownEnded && aPlayerWon;
+	return phaseIsEnd && countdownEnded && matchWon(state, cfg);
 }
 
 #endif
\ No newline at end of file
@@ -1,10 +1,12 @@
 #ifndef RBST_INPUT_HPP
 #define RBST_INPUT_HPP
 
+#ifndef RBST_HEADLESS
 //Raylib
 #include <raylib.h>
 //TOML++
 #include <toml++/toml.h>
+#endif
 //-----
 #include "Math.hpp"
 
@@ -37,18 +39,35 @@ struct PlayerInput
 	num_det mouse{ 0 };
 };
 
+//one poll of the devices before it becomes a PlayerInput, the mouse still in full precision (radians)
+struct PolledInput
+{
+	AttackInput atk = None;
+	MoveInput mov = Neutral;
+	double mouse = 0;
+};
+
 struct PlayerInputZip
 {
 	char movAtk = 0;
 	int32_t mouseRaw = 0;
 };
 
+//free-for-all lobbies go up to this many, the collision grid keeps one bit per player so 8 is the ceiling
+#ifndef RBST_MAX_PLAYERS
+#define RBST_MAX_PLAYERS 8
+#endif
+const int MAX_PLAYERS = RBST_MAX_PLAYERS;
+static_assert(MAX_PLAYERS >= 2 && MAX_PLAYERS <= 8, "lobbies hold 2 to 8 players");
+
 struct InputData
 {
-	PlayerInput p1Input;
-	PlayerInput p2Input;
+	//indexed by player id - 1, duels only fill the first two
+	PlayerInput players[MAX_PLAYERS];
 };
 
+//polling and bindings need a window, headless builds only deal with already recorded inputs
+#ifndef RBST_HEADLESS
 struct InputBindings
 {
 	num_det sensitivity{ 0 };
@@ -121,8 +140,32 @@ PlayerInput processInput(const InputBindings* inputBind)
 	}
 }
 
+//the same as processInput, for the sampler in SimThread.hpp that polls many times a frame and adds the mouse up itself
+PolledInput pollInput(const InputBindings* inputBind)
+{
+	PolledInput input;
+	if (!IsWindowFocused()) return input;
+
+	input.mouse = static_cast<double>(inputBind->sensitivity) * DEG2RAD * GetMouseDelta().x;
+
+	int8 direction = 5;
+	if (IsKeyDown(inputBind->forward)) direction = direction + 3;
+	if (IsKeyDown(inputBind->back)) direction = direction - 3;
+	if (IsKeyDown(inputBind->left)) --direction;
+	if (IsKeyDown(inputBind->right)) ++direction;
+	input.mov = static_cast<MoveInput>(direction);
+
+	if (IsMouseButtonPressed(inputBind->shotBtn) || IsKeyPressed(inputBind->shotKey)) input.atk = Shot;
+	if (IsMouseButtonPressed(inputBind->altShotBtn) || IsKeyPressed(inputBind->altShotKey)) input.atk = AltShot;
+	if (IsKeyPressed(inputBind->dashKey) || IsMouseButtonPressed(inputBind->dashBtn)) input.atk = Dash;
+
+	return input;
+}
+#endif
+
 //GGPO does some weird shit with existing input to roll predictions
 //if I knew how to override it with this I would
+//(RollbackPeer can, see holdPredictor in InputPredictor.hpp)
 PlayerInput predictInput(PlayerInput prevInput)
 {
 	prevInput.atk = None;
@@ -0,0 +1,118 @@
+#ifndef RBST_INPUTDELAY_HPP
+#define RBST_INPUTDELAY_HPP
+
+//std
+#include <algorithm>
+#include <cmath>
+//-----
+#include "GameState.hpp"
+
+//picks the local input delay for an online match, trading a few frames of delay for shallower rollbacks
+//it moves the delay a frame at a time, only while nobody's inputs count (round countdown and round end),
+//so a change is never felt mid fight
+//a side's rollbacks come from the other side's inputs arriving late, so a side's own delay only shows up in the
+//other side's rollbacks; going by its own rollbacks alone, whichever side raises its delay first sees nothing change
+//and keeps going while the other side comes down. so the delay goes by the ping, which both sides see the same,
+//and the rollbacks measured here only nudge it by a small margin for jitter and loss the ping doesn't show
+
+//the most delay the controller will pick, past this rollbacks are the lesser evil
+const int INPUT_DELAY_MAX = 6;
+//frames between two steps, a countdown is long enough to go all the way up or down
+const int INPUT_DELAY_STEP_FRAMES = 15;
+//real frames measured at a delay before moving the margin
+const int INPUT_DELAY_MIN_SAMPLES = 120;
+//how far the measured rollbacks can move the delay away from what the ping asks for, this bounds how far apart
+//the two sides can end up
+const int INPUT_DELAY_MARGIN_MIN = 0;
+const int INPUT_DELAY_MARGIN_MAX = 1;
+
+struct DelayController
+{
+	//the mean rollback depth to stay under, in frames
+	double target = 2;
+	int maxDelay = INPUT_DELAY_MAX;
+	int delay = 0;
+	//ping smoothed over about a second
+	double pingMs = -1;
+	//since the last change
+	long frames = 0;
+	long rollbacks = 0;
+	long depth = 0;
+	long lastChange = -INPUT_DELAY_STEP_FRAMES;
+	int changes = 0;
+	//frames on top of what the ping asks for
+	int margin = 0;
+};
+
+void resetDelayController(DelayController* ctrl, double target, int maxDelay = INPUT_DELAY_MAX)
+{
+	*ctrl = DelayController{};
+	ctrl->target = std::max(0.0, target);
+	ctrl->maxDelay = std::max(0, maxDelay);
+}
+
+//once per real frame, with how many frames were resimulated in it and the latest ping (negative if unknown)
+void delaySample(DelayController* ctrl, int resimulated, double pingMs)
+{
+	(ctrl->frames)++;
+	if (resimulated > 0)
+	{
+		(ctrl->rollbacks)++;
+		ctrl->depth += resimulated;
+	}
+	if (pingMs >= 0)
+	{
+		ctrl->pingMs = (ctrl->pingMs < 0) ? pingMs : ctrl->pingMs + (pingMs - ctrl->pingMs) / 60;
+	}
+}
+
+inline double meanRollbackDepth(const DelayController* ctrl)
+{
+	return ctrl->rollbacks > 0 ? static_cast<double>(ctrl->depth) / ctrl->rollbacks : 0;
+}
+
+//the delay the ping alone asks for: rollbacks reach back about the one way trip, minus the remote's delay,
+//and the remote going by the same ping picks the same
+int pingDelay(const DelayController* ctrl)
+{
+	if (ctrl->pingMs < 0) return ctrl->delay - ctrl->margin;
+	int oneWay = static_cast<int>(ceil(ctrl->pingMs / 2 / (1000.0 / 60.0)));
+	return std::max(0, oneWay - static_cast<int>(floor(ctrl->target)));
+}
+
+inline void clearDelaySamples(DelayController* ctrl, long frame)
+{
+	ctrl->frames = 0;
+	ctrl->rollbacks = 0;
+	ctrl->depth = 0;
+	ctrl->lastChange = frame;
+}
+
+//call once per real frame after delaySample, true when the delay changed and has to be handed to the netcode
+bool updateInputDelay(DelayController* ctrl, RoundPhase phase, long frame)
+{
+	if (phase == RoundPhase::Play) return false;
+	if (frame - ctrl->lastChange < INPUT_DELAY_STEP_FRAMES) return false;
+	if (ctrl->frames >= INPUT_DELAY_MIN_SAMPLES)
+	{
+		double mean = meanRollbackDepth(ctrl);
+		int margin = ctrl->margin;
+		if (mean > ctrl->target) margin++;
+		//a frame less delay makes rollbacks about a frame deeper, only drop it when that still fits
+		else if (mean + 1 < ctrl->target || ctrl->rollbacks == 0) margin--;
+		margin = std::max(INPUT_DELAY_MARGIN_MIN, std::min(INPUT_DELAY_MARGIN_MAX, margin));
+		if (margin != ctrl->margin)
+		{
+			ctrl->margin = margin;
+			clearDelaySamples(ctrl, frame);
+		}
+	}
+	int wanted = std::max(0, std::min(ctrl->maxDelay, pingDelay(ctrl) + ctrl->margin));
+	if (wanted == ctrl->delay) return false;
+	ctrl->delay += (wanted > ctrl->delay) ? 1 : -1;
+	clearDelaySamples(ctrl, frame);
+	(ctrl->changes)++;
+	return true;
+}
+
+#endif
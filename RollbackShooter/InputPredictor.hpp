@@ -0,0 +1,268 @@
+#ifndef RBST_INPUTPREDICTOR_HPP
+#define RBST_INPUTPREDICTOR_HPP
+
+//std
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+//-----
+#include "Input.hpp"
+
+//guesses a remote player's input for the frames that haven't arrived yet, every wrong guess is a rollback
+//a predictor only sees the remote's confirmed inputs, kept at frame % ringSize the way the peers keep them
+//GGPO predicts inside the library by repeating the last input and has no way to be handed one of these,
+//so they're used by RollbackPeer and measured against replays by rbst_predictbench
+
+inline bool sameInput(PlayerInputZip a, PlayerInputZip b)
+{
+	return a.movAtk == b.movAtk && a.mouseRaw == b.mouseRaw;
+}
+
+//the confirmed inputs a predictor can look back on
+struct InputHistory
+{
+	const PlayerInputZip* ring = NULL;
+	int ringSize = 0;
+	long confirmed = -1;
+};
+
+//frames before the match and ones that fell out of the ring count as doing nothing
+inline PlayerInputZip historyInput(const InputHistory* history, long frame)
+{
+	if (frame < 0 || frame > history->confirmed || frame <= history->confirmed - history->ringSize) return zipInput(PlayerInput{});
+	return history->ring[frame % history->ringSize];
+}
+
+struct InputPredictor
+{
+	const char* name = "";
+	void* context = NULL;
+	//the remote's input at frame, which is past history->confirmed
+	PlayerInputZip (*predict)(void* context, const InputHistory* history, long frame) = NULL;
+};
+
+inline PlayerInputZip predictWith(const InputPredictor* predictor, const InputHistory* history, long frame)
+{
+	return predictor->predict(predictor->context, history, frame);
+}
+
+//GGPO's: the last input again, attack included
+PlayerInputZip predictRepeat(void*, const InputHistory* history, long)
+{
+	return historyInput(history, history->confirmed);
+}
+
+//predictInput from Input.hpp: movement and turning held, attacks are single frame presses so there's none
+PlayerInputZip predictHold(void*, const InputHistory* history, long)
+{
+	return zipInput(predictInput(unzipInput(historyInput(history, history->confirmed))));
+}
+
+//like hold, but the mouse keeps speeding up or slowing down at the rate of the last two frames,
+//and a turn that's slowing down stops instead of going the other way
+PlayerInputZip predictExtrapolate(void*, const InputHistory* history, long frame)
+{
+	PlayerInputZip last = historyInput(history, history->confirmed);
+	PlayerInputZip before = historyInput(history, history->confirmed - 1);
+	PlayerInputZip zip = zipInput(predictInput(unzipInput(last)));
+	std::int64_t ahead = frame - history->confirmed;
+	std::int64_t mouse = last.mouseRaw + ahead * (static_cast<std::int64_t>(last.mouseRaw) - before.mouseRaw);
+	if (last.mouseRaw == 0 || (mouse < 0) != (last.mouseRaw < 0)) mouse = 0;
+	mouse = std::max<std::int64_t>(INT32_MIN, std::min<std::int64_t>(INT32_MAX, mouse));
+	zip.mouseRaw = static_cast<std::int32_t>(mouse);
+	return zip;
+}
+
+inline InputPredictor repeatPredictor()
+{
+	InputPredictor predictor;
+	predictor.name = "repeat (GGPO)";
+	predictor.predict = predictRepeat;
+	return predictor;
+}
+
+inline InputPredictor holdPredictor()
+{
+	InputPredictor predictor;
+	predictor.name = "hold";
+	predictor.predict = predictHold;
+	return predictor;
+}
+
+inline InputPredictor extrapolatePredictor()
+{
+	InputPredictor predictor;
+	predictor.name = "mouse extrapolation";
+	predictor.predict = predictExtrapolate;
+	return predictor;
+}
+
+//N-GRAM
+
+//an n-gram model over symbols that stand for a frame's input next to the ones before it:
+//movement and attack as they are, and whether the mouse stopped, stayed, kept changing at the same rate or did anything else
+//mouse movement comes in whole mouse counts, so the first three happen most frames and can be guessed exactly
+//it learns from replays which symbol tends to come after the last few, falling back to shorter contexts it has seen
+
+const int NGRAM_MAX_ORDER = 5;
+
+enum MouseKind
+{
+	MouseStop = 0,
+	MouseSame = 1,
+	MouseLinear = 2,
+	MouseOther = 3
+};
+
+struct NgramModel
+{
+	//symbols of context, 0 to NGRAM_MAX_ORDER
+	int order = 2;
+	//(context, next symbol) -> times seen, only while learning
+	std::map<std::uint64_t, long> counts;
+	//context -> the most common next symbol
+	std::map<std::uint64_t, std::uint8_t> best;
+};
+
+inline std::int32_t linearMouse(std::int32_t last, std::int32_t before)
+{
+	std::int64_t mouse = 2 * static_cast<std::int64_t>(last) - before;
+	return static_cast<std::int32_t>(std::max<std::int64_t>(INT32_MIN, std::min<std::int64_t>(INT32_MAX, mouse)));
+}
+
+inline std::uint8_t inputSymbol(PlayerInputZip zip, std::int32_t last, std::int32_t before)
+{
+	int kind = MouseOther;
+	if (zip.mouseRaw == 0) kind = MouseStop;
+	else if (zip.mouseRaw == last) kind = MouseSame;
+	else if (zip.mouseRaw == linearMouse(last, before)) kind = MouseLinear;
+	return static_cast<std::uint8_t>(((zip.movAtk & 0x3f) << 2) | kind);
+}
+
+//the input a symbol stands for, MouseOther can't be told apart so it holds
+inline PlayerInputZip symbolInput(std::uint8_t symbol, std::int32_t last, std::int32_t before)
+{
+	PlayerInputZip zip;
+	zip.movAtk = static_cast<char>(symbol >> 2);
+	switch (symbol & 3)
+	{
+	case MouseStop: zip.mouseRaw = 0; break;
+	case MouseLinear: zip.mouseRaw = linearMouse(last, before); break;
+	default: zip.mouseRaw = last; break;
+	}
+	return zip;
+}
+
+//the newest symbol last, order in the top bits so contexts of different lengths never collide
+inline std::uint64_t ngramContext(const std::uint8_t* symbols, int order)
+{
+	std::uint64_t key = static_cast<std::uint64_t>(order) << 40;
+	for (int i = 0; i < order; i++)
+	{
+		key |= static_cast<std::uint64_t>(symbols[i]) << (8 * (order - 1 - i));
+	}
+	return key;
+}
+
+//one player's inputs from a replay, call finishNgram after the last one
+void learnNgram(NgramModel* model, const std::vector<PlayerInputZip>& inputs)
+{
+	std::vector<std::uint8_t> symbols(inputs.size());
+	std::int32_t last = 0, before = 0;
+	for (size_t frame = 0; frame < inputs.size(); frame++)
+	{
+		symbols[frame] = inputSymbol(inputs[frame], last, before);
+		before = last;
+		last = inputs[frame].mouseRaw;
+		for (int order = 0; order <= model->order && static_cast<size_t>(order) <= frame; order++)
+		{
+			std::uint64_t context = ngramContext(&symbols[frame - order], order);
+			(model->counts[(context << 8) | symbols[frame]])++;
+		}
+	}
+}
+
+void finishNgram(NgramModel* model)
+{
+	model->best.clear();
+	//the counts are sorted by context, then by symbol, so ties go to the lower symbol
+	std::uint64_t context = UINT64_MAX;
+	long most = 0;
+	for (auto it = model->counts.cbegin(); it != model->counts.cend(); it++)
+	{
+		if ((it->first >> 8) != context)
+		{
+			context = it->first >> 8;
+			most = 0;
+		}
+		if (it->second > most)
+		{
+			most = it->second;
+			model->best[context] = static_cast<std::uint8_t>(it->first & 0xff);
+		}
+	}
+	model->counts.clear();
+}
+
+//the longest context the model has seen, the caller makes sure a model that learned nothing isn't asked
+inline std::uint8_t ngramNext(const NgramModel* model, const std::uint8_t* symbols, int available)
+{
+	for (int order = std::min(model->order, available); order > 0; order--)
+	{
+		auto found = model->best.find(ngramContext(symbols + available - order, order));
+		if (found != model->best.end()) return found->second;
+	}
+	return model->best.find(ngramContext(symbols, 0))->second;
+}
+
+//rebuilds the context from the confirmed inputs, then walks it forward a predicted frame at a time up to frame
+PlayerInputZip predictNgram(void* context, const InputHistory* history, long frame)
+{
+	const NgramModel* model = static_cast<const NgramModel*>(context);
+	if (model->best.empty()) return predictHold(NULL, history, frame);
+	long ahead = frame - history->confirmed;
+	std::uint8_t symbols[NGRAM_MAX_ORDER + 1];
+	int available = 0;
+	long from = std::max(0L, history->confirmed - model->order + 1);
+	std::int32_t last = historyInput(history, from - 1).mouseRaw;
+	std::int32_t before = historyInput(history, from - 2).mouseRaw;
+	for (long f = from; f <= history->confirmed; f++)
+	{
+		PlayerInputZip zip = historyInput(history, f);
+		symbols[available++] = inputSymbol(zip, last, before);
+		before = last;
+		last = zip.mouseRaw;
+	}
+	PlayerInputZip zip = historyInput(history, history->confirmed);
+	for (long step = 0; step < ahead; step++)
+	{
+		std::uint8_t next = ngramNext(model, symbols, available);
+		zip = symbolInput(next, last, before);
+		before = last;
+		last = zip.mouseRaw;
+		//order 0 keeps no context, so there is nothing to shift out
+		if (available > 0 && available == model->order)
+		{
+			for (int i = 1; i < available; i++)
+			{
+				symbols[i - 1] = symbols[i];
+			}
+			available--;
+		}
+		if (model->order > 0) symbols[available++] = next;
+	}
+	return zip;
+}
+
+//the model has to stay where it is while the predictor is in use
+inline InputPredictor ngramPredictor(NgramModel* model)
+{
+	InputPredictor predictor;
+	predictor.name = "n-gram";
+	predictor.context = model;
+	predictor.predict = predictNgram;
+	return predictor;
+}
+
+#endif
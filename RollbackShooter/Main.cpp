@@ -1,3 +1,6 @@
+//std
+#include <cstdlib>
+#include <new>
 //Raylib
 #include <raylib.h>
 //TOML++
@@ -11,8 +14,32 @@
 #include "SecondarySim.hpp"
 #include "GameState.hpp"
 #include "Presentation.hpp"
+#include "FrameArena.hpp"
 #include "GGPOController.hpp"
 
+#ifdef RBST_COUNT_ALLOCATIONS
+//see FrameArena.hpp
+thread_local long threadAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+	threadAllocations++;
+	void* memory = std::malloc(size > 0 ? size : 1);
+	if (memory == NULL) throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+#endif
+
 int main(int argc, char* argv[])
 {
 	InitWindow(screenWidth, screenHeight, "RBST");
@@ -26,6 +53,15 @@ int main(int argc, char* argv[])
 	auto homeFile = toml::parse_file("RBST_home.toml");
 	home.remoteAddress = homeFile["Network"]["remoteAddress"].value_or("127.0.0.1");
 	unsigned short port = homeFile["Network"]["port"].value_or(8001);
+	checksumInterval = homeFile["Network"]["checksumInterval"].value_or(1);
+	rollbackTarget = homeFile["Network"]["rollbackTarget"].value_or(2.0);
+	std::string pacing = homeFile["Network"]["pacing"].value_or("spread");
+	pacingMode = (pacing == "penalty") ? PacingMode::Penalty : PacingMode::Spread;
+	maxStretchMs = homeFile["Network"]["maxStretchMs"].value_or(PACER_MAX_STRETCH_MS);
+	std::string particles = homeFile["Network"]["particles"].value_or("reconcile");
+	particleMode = (particles == "derive") ? ParticleMode::Derive : ParticleMode::Reconcile;
+	hostRelay = homeFile["Spectate"]["hostRelay"].value_or(false);
+	relayPort = homeFile["Spectate"]["relayPort"].value_or(8002);
 	int demos = homeFile["HomeScreen"]["demoFiles"].as_array()->size();
 
 	Config demoCfg;
@@ -46,7 +82,9 @@ int main(int argc, char* argv[])
 	
 	POV demoPOV = Spectator;
 	Camera3D demoCam = initialCamera();
-	std::ostringstream demoOSS;
+	reserveFlux(&demoFlux);
+	FrameArena demoArena;
+	FrameAllocCheck demoAllocCheck;
 
 	home.bgTarget = LoadRenderTexture(screenWidth, screenHeight);
 	home.bgShader = LoadShader(0, "shader/bg.fs");
@@ -87,6 +125,7 @@ int main(int argc, char* argv[])
 			{
 				home.remoteAddress = std::string(GetClipboardText());
 				home.freshUpdate = 1;
+				unsteadyFrame(&demoAllocCheck);
 			}
 			else if (IsKeyPressed(KEY_F1))
 			{
@@ -94,6 +133,7 @@ int main(int argc, char* argv[])
 				NetworkedMain(&sprs, home.remoteAddress, port, 1);
 				//back from match
 				EnableCursor();
+				unsteadyFrame(&demoAllocCheck);
 			}
 			else if (IsKeyPressed(KEY_F2))
 			{
@@ -101,49 +141,52 @@ int main(int argc, char* argv[])
 				NetworkedMain(&sprs, home.remoteAddress, port, 2);
 				//back from match
 				EnableCursor();
+				unsteadyFrame(&demoAllocCheck);
+			}
+			else if (IsKeyPressed(KEY_F3))
+			{
+				SpectatorMain(&sprs, home.remoteAddress, relayPort);
+				unsteadyFrame(&demoAllocCheck);
 			}
 		}
 		if (replayFileEnd(&replayR))
 		{
 			closeReplayFile(&replayR);
-			demoParticles.projs.clear();
-			demoParticles.combos.clear();
-			demoParticles.grazes.clear();
-			demoParticles.alerts.clear();
-			demoParticles.hitscans.clear();
+			clearSecSim(&demoParticles);
 			//repeat
 			openReplayFile(&replayR, &demoCfg, newDemo.c_str());
 			demoState = initialState(&demoCfg);
+			unsteadyFrame(&demoAllocCheck);
 		}
 		InputData input = readReplayFile(&replayR);
 		//simulation
-		demoState = simulate(demoState, &demoFlux, &demoCfg, input);
+		simulate(&demoState, &demoFlux, &demoCfg, input);
 		//secondary simulation
 		increaseParticleLifetime(&demoParticles);
 		currentFrameSecSim(&demoFlux, &demoParticles, demoState.frame);
-		demoFlux.projs.clear();
-		demoFlux.combos.clear();
-		demoFlux.grazes.clear();
-		demoFlux.alerts.clear();
-		demoFlux.hitscans.clear();
+		clearFlux(&demoFlux);
 
 		int currentFps = GetFPS();
-		demoOSS.str("");
-		demoOSS << "FPS: " << currentFps << std::endl;
-		if (home.homeScreen)
+		resetArena(&demoArena);
+		FrameString demoInfo = frameString(&demoArena);
+		if (!cleanMode)
 		{
-			demoOSS << std::endl << "/// A game by Thiago da Fonte ///" << std::endl;
-		}
-		else
-		{
-			demoOSS << "Press F1 and F2 for player POVs," << std::endl;
-			demoOSS << "F3 for spectator POV," << std::endl;
-			demoOSS << "C for (clean? camera? cinematic?) mode," << std::endl;
-			demoOSS << "or F4 to go back to menu." << std::endl;
+			appendf(&demoInfo, "FPS: %d\n", currentFps);
+			if (home.homeScreen)
+			{
+				demoInfo += "\n/// A game by Thiago da Fonte ///\n";
+			}
+			else
+			{
+				demoInfo += "Press F1 and F2 for player POVs,\n";
+				demoInfo += "F3 for spectator POV,\n";
+				demoInfo += "C for (clean? camera? cinematic?) mode,\n";
+				demoInfo += "or F4 to go back to menu.\n";
+			}
 		}
-		if (cleanMode) demoOSS.str("");
 		//presentation
-		presentMenu(demoPOV, &demoState, &demoParticles, &demoCfg, &demoCam, &sprs, &demoOSS, &home);
+		presentMenu(demoPOV, &demoState, &demoParticles, &demoCfg, &demoCam, &sprs, demoInfo.c_str(), &home);
+		checkFrameAllocations(&demoAllocCheck);
 	}
 	UnloadRenderTexture(home.bgTarget);
 	UnloadShader(home.bgShader);
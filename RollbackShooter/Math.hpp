@@ -4,8 +4,12 @@
 //fpm
 #include <fpm/fixed.hpp>
 #include <fpm/math.hpp>
+//std
+#include <cstdint>
+#ifndef RBST_HEADLESS
 //Raylib
 #include <raylib.h>
+#endif
 
 using num_det = fpm::fixed<std::int32_t, std::int64_t, 16>;
 using int8 = std::int8_t;
@@ -17,6 +21,113 @@ struct Vec2
 	num_det y;
 };
 
+//table-driven sin and cos, giving the exact same bits as fpm::sin and fpm::cos
+//fpm folds the angle into [0..1] (in quarter turns) and evaluates a fifth-order polynomial there,
+//so the table holds that polynomial for every one of the 65537 raw values of the folded angle,
+//computed at compile time with integer math that mirrors fpm's fixed point rounding
+//error bound is fpm's own: under 0.0005 absolute against the real sine (rbst_trigbench measures it)
+namespace trig
+{
+	const int TABLE_SIZE = (1 << 16) + 1;
+
+	//fpm multiply: through int64, halving with the last bit rounded away from zero
+	constexpr std::int32_t mulRaw(std::int32_t a, std::int32_t b)
+	{
+		std::int64_t value = (static_cast<std::int64_t>(a) * b) / (std::int64_t{ 1 } << 15);
+		return static_cast<std::int32_t>((value / 2) + (value % 2));
+	}
+
+	//fpm's polynomial, x = folded angle in [0..1], positive sign
+	constexpr std::int32_t polyRaw(std::int32_t x)
+	{
+		const std::int32_t one = 1 << 16;
+		const std::int32_t pi = num_det::pi().raw_value();
+		const std::int32_t twoPi = num_det::two_pi().raw_value();
+		std::int32_t x2 = mulRaw(x, x);
+		std::int32_t inner = (twoPi - 5 * one) - mulRaw(x2, pi - 3 * one);
+		return mulRaw(x, pi - mulRaw(x2, inner)) / 2;
+	}
+
+	struct SinTable
+	{
+		std::int32_t raw[TABLE_SIZE];
+	};
+
+	constexpr SinTable makeSinTable()
+	{
+		SinTable table = {};
+		for (int i = 0; i < TABLE_SIZE; i++)
+		{
+			table.raw[i] = polyRaw(i);
+		}
+		return table;
+	}
+
+	inline constexpr SinTable SIN_TABLE = makeSinTable();
+
+	//same folding steps as fpm::sin, then the table instead of the polynomial
+	inline num_det sin(num_det angle)
+	{
+		num_det x = fpm::fmod(angle, num_det::two_pi());
+		x = x / num_det::half_pi();
+		if (x < num_det{ 0 })
+		{
+			x += num_det{ 4 };
+		}
+		bool negative = false;
+		if (x > num_det{ 2 })
+		{
+			negative = true;
+			x -= num_det{ 2 };
+		}
+		if (x > num_det{ 1 })
+		{
+			x = num_det{ 2 } - x;
+		}
+		std::int32_t raw = SIN_TABLE.raw[x.raw_value()];
+		return num_det::from_raw_value(negative ? -raw : raw);
+	}
+
+	inline num_det cos(num_det angle)
+	{
+		return sin(num_det::half_pi() + angle);
+	}
+
+	//precomputed cos/sin pair, for rotating by constant angles without any lookup
+	struct Rotation
+	{
+		num_det cos;
+		num_det sin;
+	};
+
+	//compile-time version of the folding in trig::sin, only for angles within [-2pi..2pi]
+	constexpr std::int32_t sinRaw(std::int32_t angle)
+	{
+		const std::int32_t one = 1 << 16;
+		const std::int64_t halfPi = num_det::half_pi().raw_value();
+		std::int32_t folded = angle % num_det::two_pi().raw_value();
+		std::int64_t value = (static_cast<std::int64_t>(folded) * one * 2) / halfPi;
+		std::int32_t x = static_cast<std::int32_t>((value / 2) + (value % 2));
+		if (x < 0) x += 4 * one;
+		bool negative = false;
+		if (x > 2 * one)
+		{
+			negative = true;
+			x -= 2 * one;
+		}
+		if (x > one) x = 2 * one - x;
+		return negative ? -polyRaw(x) : polyRaw(x);
+	}
+
+	constexpr Rotation rotation(std::int32_t angleRaw)
+	{
+		return Rotation{
+			num_det::from_raw_value(sinRaw(num_det::half_pi().raw_value() + angleRaw)),
+			num_det::from_raw_value(sinRaw(angleRaw))
+		};
+	}
+}
+
 namespace v2
 {
 	inline Vec2 zero()
@@ -101,12 +212,20 @@ namespace v2
 	//positive rotates counter-clockwise
 	Vec2 rotate(Vec2 v, num_det angle)
 	{
-		num_det cos = fpm::cos(angle);
-		num_det sin = fpm::sin(angle);
+		num_det cos = trig::cos(angle);
+		num_det sin = trig::sin(angle);
 		num_det x = (v.x * cos) - (v.y * sin);
 		num_det y = (v.x * sin) + (v.y * cos);
 		return Vec2{ x, y };
 	}
+
+	//for angles known ahead of time, see trig::rotation
+	inline Vec2 rotate(Vec2 v, trig::Rotation rot)
+	{
+		num_det x = (v.x * rot.cos) - (v.y * rot.sin);
+		num_det y = (v.x * rot.sin) + (v.y * rot.cos);
+		return Vec2{ x, y };
+	}
 	
 	//projection of a on b
 	Vec2 projection(Vec2 a, Vec2 b)
@@ -138,6 +257,8 @@ namespace v2
 	}
 }
 
+//conversions to raylib types, not available in headless builds
+#ifndef RBST_HEADLESS
 inline Vector3 fromDetVec2(Vec2 vec, float height = 0.0f)
 {
 	return Vector3{ static_cast<float>(vec.x), height, static_cast<float>(vec.y) };
@@ -158,5 +279,6 @@ inline float angleFromDetVec2(Vec2 vec)
 {
 	return atan2(static_cast<float>(vec.y), static_cast<float>(vec.x));
 }
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#ifndef RBST_NETEMULATOR_HPP
+#define RBST_NETEMULATOR_HPP
+
+//std
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+//-----
+#include "Transport.hpp"
+
+//two transports joined in memory, with the delay, jitter, reordering and loss of a real connection made up on the way
+//time only moves when advanceEmulator is called and the randomness comes from a seed,
+//so a given profile and seed always loses and delays the very same packets
+
+struct NetProfile
+{
+	const char* name = "";
+	//one way
+	double delayMs = 0;
+	//each packet's delay is off by up to this much either way
+	double jitterMs = 0;
+	//0 to 1
+	double lossChance = 0;
+	//0 to 1, a reordered packet gets held back an extra reorderMs behind whatever is sent after it
+	double reorderChance = 0;
+	double reorderMs = 0;
+};
+
+struct EmulatedPacket
+{
+	double deliverAt = 0;
+	//breaks ties so packets due at the same time keep their send order
+	long sequence = 0;
+	size_t size = 0;
+	std::uint8_t bytes[MAX_DATAGRAM_BYTES];
+};
+
+//one direction of the connection
+struct EmulatedLink
+{
+	std::vector<EmulatedPacket> inFlight;
+	std::uint32_t seed = 1;
+	long sequence = 0;
+	long sent = 0;
+	long dropped = 0;
+	long delivered = 0;
+};
+
+struct NetEmulator;
+
+struct EmulatorEndpoint
+{
+	NetEmulator* emulator = NULL;
+	int side = 0;
+};
+
+//links[0] carries side 0 to side 1, links[1] the way back
+struct NetEmulator
+{
+	NetProfile profile;
+	double nowMs = 0;
+	EmulatedLink links[2];
+	EmulatorEndpoint endpoints[2];
+};
+
+inline double emulatorRandom(EmulatedLink* link)
+{
+	link->seed = link->seed * 1664525u + 1013904223u;
+	return (link->seed >> 8) / static_cast<double>(1u << 24);
+}
+
+bool emulatorSend(void* context, const std::uint8_t* bytes, size_t size)
+{
+	EmulatorEndpoint* endpoint = static_cast<EmulatorEndpoint*>(context);
+	NetEmulator* emulator = endpoint->emulator;
+	EmulatedLink* link = &(emulator->links[endpoint->side]);
+	if (size > MAX_DATAGRAM_BYTES) return false;
+	(link->sent)++;
+	if (emulatorRandom(link) < emulator->profile.lossChance)
+	{
+		(link->dropped)++;
+		return true;
+	}
+	EmulatedPacket packet;
+	double jitter = (emulatorRandom(link) * 2 - 1) * emulator->profile.jitterMs;
+	packet.deliverAt = emulator->nowMs + std::max(0.0, emulator->profile.delayMs + jitter);
+	if (emulatorRandom(link) < emulator->profile.reorderChance) packet.deliverAt += emulator->profile.reorderMs;
+	packet.sequence = (link->sequence)++;
+	packet.size = size;
+	memcpy(packet.bytes, bytes, size);
+	link->inFlight.push_back(packet);
+	return true;
+}
+
+size_t emulatorReceive(void* context, std::uint8_t* bytes, size_t capacity)
+{
+	EmulatorEndpoint* endpoint = static_cast<EmulatorEndpoint*>(context);
+	NetEmulator* emulator = endpoint->emulator;
+	EmulatedLink* link = &(emulator->links[endpoint->side ^ 1]);
+	//the earliest packet that is due by now
+	auto due = link->inFlight.end();
+	for (auto it = link->inFlight.begin(); it != link->inFlight.end(); it++)
+	{
+		if (it->deliverAt > emulator->nowMs) continue;
+		if (due == link->inFlight.end() ||
+			it->deliverAt < due->deliverAt ||
+			(it->deliverAt == due->deliverAt && it->sequence < due->sequence))
+			due = it;
+	}
+	if (due == link->inFlight.end()) return 0;
+	size_t size = std::min(capacity, due->size);
+	memcpy(bytes, due->bytes, size);
+	link->inFlight.erase(due);
+	(link->delivered)++;
+	return size;
+}
+
+void resetEmulator(NetEmulator* emulator, const NetProfile* profile, std::uint32_t seed)
+{
+	emulator->profile = *profile;
+	emulator->nowMs = 0;
+	for (int side = 0; side < 2; side++)
+	{
+		emulator->links[side] = EmulatedLink{};
+		emulator->links[side].seed = seed * 2 + side + 1;
+		emulator->endpoints[side].emulator = emulator;
+		emulator->endpoints[side].side = side;
+	}
+}
+
+//the emulator has to stay where it is while either transport is in use
+Transport emulatorTransport(NetEmulator* emulator, int side)
+{
+	Transport transport;
+	transport.context = &(emulator->endpoints[side]);
+	transport.send = emulatorSend;
+	transport.receive = emulatorReceive;
+	return transport;
+}
+
+inline void advanceEmulator(NetEmulator* emulator, double ms)
+{
+	emulator->nowMs += ms;
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef RBST_PARTICLEPOOL_HPP
+#define RBST_PARTICLEPOOL_HPP
+
+//std
+#include <cstdint>
+#include <cstring>
+#ifndef RBST_HEADLESS
+//raylib
+#include <raylib.h>
+#else
+#include <cstdlib>
+//headless builds have no raylib, but sub particles still need somewhere to live
+struct Vector4
+{
+	float x; float y; float z; float w;
+};
+inline int GetRandomValue(int min, int max)
+{
+	return min + (std::rand() % (max - min + 1));
+}
+#endif
+//-----
+#include "Math.hpp"
+#include "Player.hpp"
+
+//particles of one kind alive at once; a match rarely has more than a handful, stress builds can raise it
+#ifndef RBST_MAX_PARTICLES
+#define RBST_MAX_PARTICLES 256
+#endif
+const int MAX_PARTICLES = RBST_MAX_PARTICLES;
+static_assert(MAX_PARTICLES < 0xffff, "sub particle slots are 16 bit");
+//frames a particle stays up for
+const int PARTICLE_LIFETIME = 60;
+//the bits an effect bursts into
+const int SUB_PARTS = 10;
+
+using subslot = std::uint16_t;
+const subslot NO_SUB_PARTS = 0xffff;
+
+//fixed capacity particle storage for one kind, one array per field, the live ones packed at the front
+//removing swaps the last one into the hole, so nothing is ever shifted and the order isn't kept
+//a full pool drops new particles, it's only visuals
+struct ParticlePool
+{
+	//the frame its event happened on
+	long frame[MAX_PARTICLES];
+	//frames it has been shown for
+	int lifetime[MAX_PARTICLES];
+	Vec2 pos[MAX_PARTICLES];
+	//projectiles and hitscans only
+	playerid owner[MAX_PARTICLES];
+	//hitscans only
+	Vec2 dir[MAX_PARTICLES];
+	//grazes and alerts only, where their sub particles are in SubPartPool
+	subslot sub[MAX_PARTICLES];
+	//the event it shows, see eventId()
+	std::uint64_t id[MAX_PARTICLES];
+	int count = 0;
+};
+
+//the sub particles of every effect, whatever kind: direction (x, y), height and size
+//slots don't move once handed out, the effect's particle keeps the slot wherever it gets swapped to
+struct SubPartPool
+{
+	Vector4 parts[2 * MAX_PARTICLES][SUB_PARTS];
+	//slots given back, reused last in first out
+	subslot freeSlots[2 * MAX_PARTICLES];
+	int freeCount = 0;
+	//slots from here on haven't been handed out since the last clear
+	int highWater = 0;
+};
+
+void clearParticles(ParticlePool* pool)
+{
+	pool->count = 0;
+}
+
+void clearSubParts(SubPartPool* subs)
+{
+	subs->freeCount = 0;
+	subs->highWater = 0;
+}
+
+//NO_SUB_PARTS if they're all taken
+subslot takeSubParts(SubPartPool* subs)
+{
+	if (subs->freeCount > 0) return subs->freeSlots[--(subs->freeCount)];
+	if (subs->highWater < 2 * MAX_PARTICLES) return static_cast<subslot>((subs->highWater)++);
+	return NO_SUB_PARTS;
+}
+
+inline void giveSubParts(SubPartPool* subs, subslot slot)
+{
+	if (slot != NO_SUB_PARTS) subs->freeSlots[(subs->freeCount)++] = slot;
+}
+
+//where the new particle went, -1 if the pool is full; everything but frame, pos and id is left to the caller
+int addParticle(ParticlePool* pool, long frame, Vec2 pos, std::uint64_t id)
+{
+	if (pool->count == MAX_PARTICLES) return -1;
+	int i = (pool->count)++;
+	pool->frame[i] = frame;
+	pool->lifetime[i] = 0;
+	pool->pos[i] = pos;
+	pool->owner[i] = 0;
+	pool->dir[i] = v2::zero();
+	pool->sub[i] = NO_SUB_PARTS;
+	pool->id[i] = id;
+	return i;
+}
+
+//the last one takes its place, so a loop removing while it walks forward shouldn't step past i
+void removeParticle(ParticlePool* pool, SubPartPool* subs, int i)
+{
+	giveSubParts(subs, pool->sub[i]);
+	int last = --(pool->count);
+	if (i == last) return;
+	pool->frame[i] = pool->frame[last];
+	pool->lifetime[i] = pool->lifetime[last];
+	pool->pos[i] = pool->pos[last];
+	pool->owner[i] = pool->owner[last];
+	pool->dir[i] = pool->dir[last];
+	pool->sub[i] = pool->sub[last];
+	pool->id[i] = pool->id[last];
+}
+
+//a frame older: one pass adding to every lifetime, which the compiler can vectorize, then the expired ones go
+//walking backwards, so whatever gets swapped in has already been looked at
+void ageParticles(ParticlePool* pool, SubPartPool* subs)
+{
+	int* lifetime = pool->lifetime;
+	int count = pool->count;
+	for (int i = 0; i < count; i++) lifetime[i]++;
+	for (int i = count - 1; i >= 0; i--)
+	{
+		if (lifetime[i] > PARTICLE_LIFETIME) removeParticle(pool, subs, i);
+	}
+}
+
+//only what's alive, for handing particles to another thread without copying every slot
+void copyParticles(ParticlePool* dst, const ParticlePool* src)
+{
+	int count = src->count;
+	std::memcpy(dst->frame, src->frame, count * sizeof(src->frame[0]));
+	std::memcpy(dst->lifetime, src->lifetime, count * sizeof(src->lifetime[0]));
+	std::memcpy(dst->pos, src->pos, count * sizeof(src->pos[0]));
+	std::memcpy(dst->owner, src->owner, count * sizeof(src->owner[0]));
+	std::memcpy(dst->dir, src->dir, count * sizeof(src->dir[0]));
+	std::memcpy(dst->sub, src->sub, count * sizeof(src->sub[0]));
+	std::memcpy(dst->id, src->id, count * sizeof(src->id[0]));
+	dst->count = count;
+}
+
+void copySubParts(SubPartPool* dst, const SubPartPool* src)
+{
+	std::memcpy(dst->parts, src->parts, src->highWater * sizeof(src->parts[0]));
+	std::memcpy(dst->freeSlots, src->freeSlots, src->freeCount * sizeof(src->freeSlots[0]));
+	dst->freeCount = src->freeCount;
+	dst->highWater = src->highWater;
+}
+
+#endif
@@ -10,6 +10,16 @@
 
 using playerid = std::uint8_t;
 
+//the seven compass turns walking and dashing use, relative to where the player faces
+//the angles are the same values the movement code always rotated by, so results stay bit-identical
+constexpr std::int32_t QUARTER_PI_RAW = num_det::pi().raw_value() / 4;
+constexpr trig::Rotation COMPASS_FOR_LEFT = trig::rotation(-QUARTER_PI_RAW);
+constexpr trig::Rotation COMPASS_LEFT = trig::rotation(-num_det::half_pi().raw_value());
+constexpr trig::Rotation COMPASS_BACK_LEFT = trig::rotation(num_det::pi().raw_value() + QUARTER_PI_RAW);
+constexpr trig::Rotation COMPASS_BACK_RIGHT = trig::rotation(num_det::pi().raw_value() - QUARTER_PI_RAW);
+constexpr trig::Rotation COMPASS_RIGHT = trig::rotation(num_det::half_pi().raw_value());
+constexpr trig::Rotation COMPASS_FOR_RIGHT = trig::rotation(QUARTER_PI_RAW);
+
 enum PState
 {
 	Standby,
@@ -40,19 +50,29 @@ struct Player
 	bool stunned = false;
 };
 
-void respawnPlayer(Player* player, const Config* cfg, playerid id)
+void respawnPlayer(Player* player, const Config* cfg, playerid id, int playerCount = 2)
 {
 	player->id = id;
-	switch (id)
+	if (playerCount == 2)
 	{
-	case 1:
-		player->pos = v2::scalarMult(v2::left(), cfg->spawnRadius);
-		player->dir = v2::right();
-		break;
-	case 2:
-		player->pos = v2::scalarMult(v2::right(), cfg->spawnRadius);
-		player->dir = v2::left();
-		break;
+		switch (id)
+		{
+		case 1:
+			player->pos = v2::scalarMult(v2::left(), cfg->spawnRadius);
+			player->dir = v2::right();
+			break;
+		case 2:
+			player->pos = v2::scalarMult(v2::right(), cfg->spawnRadius);
+			player->dir = v2::left();
+			break;
+		}
+	}
+	else
+	{
+		//evenly spread around the spawn circle starting from the left, everyone facing the middle
+		num_det turn = num_det::two_pi() / num_det{ playerCount };
+		player->pos = v2::rotate(v2::scalarMult(v2::left(), cfg->spawnRadius), turn * num_det{ id - 1 });
+		player->dir = v2::normalize(v2::scalarMult(player->pos, num_det{ -1 }));
 	}
 	player->vel = v2::zero();
 	player->ammo = cfg->ammoMax;
@@ -71,11 +91,13 @@ void respawnPlayer(Player* player, const Config* cfg, playerid id)
 	player->pushdown.push(PState::Default);
 }
 
-void movePlayer(Player* player, const Config* cfg, PlayerInput input)
+//turning, speeding up and slowing down for this frame, and how far that takes the player; pos is left as it was
+//so the move itself can be added on later, one player at a time or many at once
+Vec2 playerStep(Player* player, const Config* cfg, PlayerInput input)
 {
 	num_det speed = v2::length(player->vel);
 	Vec2 impulse = v2::scalarMult(player->dir, cfg->playerWalkAccel);
-	num_det quarter_pi = speed.pi() / 4;
+	Vec2 step = v2::zero();
 	switch (player->pushdown.top())
 	{
 	case PState::Standby:
@@ -107,25 +129,25 @@ void movePlayer(Player* player, const Config* cfg, PlayerInput input)
 			}
 			break;
 		case MoveInput::ForLeft:
-			impulse = v2::rotate(impulse, -quarter_pi);
+			impulse = v2::rotate(impulse, COMPASS_FOR_LEFT);
 			break;
 		case MoveInput::Left:
-			impulse = v2::rotate(impulse, -speed.half_pi());
+			impulse = v2::rotate(impulse, COMPASS_LEFT);
 			break;
 		case MoveInput::BackLeft:
-			impulse = v2::rotate(impulse, speed.pi() + quarter_pi);
+			impulse = v2::rotate(impulse, COMPASS_BACK_LEFT);
 			break;
 		case MoveInput::Back:
 			impulse = v2::scalarMult(impulse, num_det{ -1 });
 			break;
 		case MoveInput::BackRight:
-			impulse = v2::rotate(impulse, speed.pi() - quarter_pi);
+			impulse = v2::rotate(impulse, COMPASS_BACK_RIGHT);
 			break;
 		case MoveInput::Right:
-			impulse = v2::rotate(impulse, speed.half_pi());
+			impulse = v2::rotate(impulse, COMPASS_RIGHT);
 			break;
 		case MoveInput::ForRight:
-			impulse = v2::rotate(impulse, quarter_pi);
+			impulse = v2::rotate(impulse, COMPASS_FOR_RIGHT);
 			break;
 		}
 		//if player is backpedaling, turn directly opposite force into friction
@@ -141,7 +163,7 @@ void movePlayer(Player* player, const Config* cfg, PlayerInput input)
 		}
 
 		//NORMAL WALKING MOVEMENT - DISPLACEMENT
-		player->pos = v2::add(player->pos, player->vel);
+		step = player->vel;
 		break;
 	case PState::Dashing:
 		player->dir = v2::rotate(player->dir, input.mouse);
@@ -149,18 +171,21 @@ void movePlayer(Player* player, const Config* cfg, PlayerInput input)
 		if (player->dashCount < cfg->dashPhase)
 		{
 			num_det alpha = num_det{ player->dashCount } / num_det{ cfg->dashPhase };
-			Vec2 displace = v2::lerp(player->vel, player->dashVel, alpha);
-			player->pos = v2::add(player->pos, displace);
+			step = v2::lerp(player->vel, player->dashVel, alpha);
 		}
 		else
 		{
-			player->pos = v2::add(player->pos, player->dashVel);
+			step = player->dashVel;
 			player->vel = player->dashVel;
 		}
 		break;
 	}
+	return step;
+}
 
-	//CORRECT TO WITHIN ARENA
+//CORRECT TO WITHIN ARENA
+void keepInArena(Player* player, const Config* cfg)
+{
 	if (v2::length(player->pos) > cfg->arenaRadius)
 	{
 		player->pos = v2::normalizeMult(player->pos, cfg->arenaRadius);
@@ -1,6 +1,8 @@
 #ifndef RBST_PRESENTATION_HPP
 #define RBST_PRESENTATION_HPP
 
+//std
+#include <cstdio>
 //Raylib
 #include <raylib.h>
 //TOML++
@@ -9,6 +11,7 @@
 #include "Math.hpp"
 #include "SecondarySim.hpp"
 #include "GameState.hpp"
+#include "RollbackProfiler.hpp"
 
 const int screenWidth = 1280;
 const int screenHeight = 720;
@@ -289,16 +292,16 @@ void setCamera(Camera3D* cam, Vec2* lazyCam, const GameState* state, POV pov)
 	switch (pov)
 	{
 	case Player1:
-		cam->position = fromDetVec2(v2::add(state->p1.pos, v2::scalarMult(state->p1.dir, camBack)), camHeight);
-		cam->target = fromDetVec2(v2::add(state->p1.pos, v2::scalarMult(state->p1.dir, tgtFront)), tgtHeight);
+		cam->position = fromDetVec2(v2::add(state->players[0].pos, v2::scalarMult(state->players[0].dir, camBack)), camHeight);
+		cam->target = fromDetVec2(v2::add(state->players[0].pos, v2::scalarMult(state->players[0].dir, tgtFront)), tgtHeight);
 		break;
 	case Player2:
-		cam->position = fromDetVec2(v2::add(state->p2.pos, v2::scalarMult(state->p2.dir, camBack)), camHeight);
-		cam->target = fromDetVec2(v2::add(state->p2.pos, v2::scalarMult(state->p2.dir, tgtFront)), tgtHeight);
+		cam->position = fromDetVec2(v2::add(state->players[1].pos, v2::scalarMult(state->players[1].dir, camBack)), camHeight);
+		cam->target = fromDetVec2(v2::add(state->players[1].pos, v2::scalarMult(state->players[1].dir, tgtFront)), tgtHeight);
 		break;
 	case Spectator:
-		Vec2 midDist = v2::scalarDiv(v2::sub(state->p1.pos, state->p2.pos), num_det{ 2 });
-		Vec2 actionCenter = v2::add(state->p2.pos, midDist);
+		Vec2 midDist = v2::scalarDiv(v2::sub(state->players[0].pos, state->players[1].pos), num_det{ 2 });
+		Vec2 actionCenter = v2::add(state->players[1].pos, midDist);
 		Vec2 standBack = v2::rotate(v2::scalarMult(midDist, standBackMult), -camBack.half_pi());
 		if (v2::length(standBack) < fpm::abs(camBack))
 			standBack = v2::normalizeMult(standBack, fpm::abs(camBack));
@@ -350,31 +353,31 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 			float p1Shake = 0, p2Shake = 0;
 			int p1State = 0, p2State = 0;
 			bool p1Mirror = false, p2Mirror = false;
-			if (state->p1.stunned)
+			if (state->players[0].stunned)
 			{
 				p1State = 2;
-				p1Shake = state->p1.hitstopCount * GetRandomValue(-10, 10) / 300.0f;
-				p1Mirror = v2::dot(camRight, state->p1.vel) < num_det{ 0 };
+				p1Shake = state->players[0].hitstopCount * GetRandomValue(-10, 10) / 300.0f;
+				p1Mirror = v2::dot(camRight, state->players[0].vel) < num_det{ 0 };
 			}
-			else if (state->p1.pushdown.top() == Dashing)
+			else if (state->players[0].pushdown.top() == Dashing)
 			{
 				p1State = 1;
-				p1Mirror = v2::dot(camRight, state->p1.dashVel) < num_det{ 0 };
+				p1Mirror = v2::dot(camRight, state->players[0].dashVel) < num_det{ 0 };
 			}
-			else p1Mirror = (!pov == Player1) && v2::dot(camRight, state->p1.dir) < num_det{ 0 };
+			else p1Mirror = (!pov == Player1) && v2::dot(camRight, state->players[0].dir) < num_det{ 0 };
 
-			if (state->p2.stunned)
+			if (state->players[1].stunned)
 			{
 				p2State = 2;
-				p2Shake = state->p2.hitstopCount * GetRandomValue(-10, 10) / 300.0f;
-				p2Mirror = v2::dot(camRight, state->p2.vel) < num_det{ 0 };
+				p2Shake = state->players[1].hitstopCount * GetRandomValue(-10, 10) / 300.0f;
+				p2Mirror = v2::dot(camRight, state->players[1].vel) < num_det{ 0 };
 			}
-			else if (state->p2.pushdown.top() == Dashing)
+			else if (state->players[1].pushdown.top() == Dashing)
 			{
 				p2State = 1;
-				p2Mirror = v2::dot(camRight, state->p2.dashVel) < num_det{ 0 };
+				p2Mirror = v2::dot(camRight, state->players[1].dashVel) < num_det{ 0 };
 			}
-			else p2Mirror = (!pov == Player2) && v2::dot(camRight, state->p2.dir) < num_det{ 0 };
+			else p2Mirror = (!pov == Player2) && v2::dot(camRight, state->players[1].dir) < num_det{ 0 };
 
 			//player sprites
 			BeginShaderMode(sprs->mask.shader);
@@ -385,7 +388,7 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 			DrawBillboardPro(*cam,
 				(sprs->chars.atlas),
 				CharAtlas(sprs, 1, (pov == Player1), p1Mirror, p1State),
-				fromDetVec2WithShake(state->p1.pos, camRight, fromDetNum(cfg->playerRadius) * 1.5, p1Shake),
+				fromDetVec2WithShake(state->players[0].pos, camRight, fromDetNum(cfg->playerRadius) * 1.5, p1Shake),
 				Vector3{ 0,1,0 },
 				Vector2{ fromDetNum(cfg->playerRadius) * 3, fromDetNum(cfg->playerRadius) * 3 },
 				Vector2{ 0.0f, 0.0f },
@@ -400,7 +403,7 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 			DrawBillboardPro(*cam,
 				(sprs->chars.atlas),
 				CharAtlas(sprs, 2, (pov == Player2), p2Mirror, p2State),
-				fromDetVec2WithShake(state->p2.pos, camRight, fromDetNum(cfg->playerRadius) * 1.5, p2Shake),
+				fromDetVec2WithShake(state->players[1].pos, camRight, fromDetNum(cfg->playerRadius) * 1.5, p2Shake),
 				Vector3{ 0,1,0 },
 				Vector2{ fromDetNum(cfg->playerRadius) * 3, fromDetNum(cfg->playerRadius) * 3 },
 				Vector2{ 0.0f, 0.0f },
@@ -416,61 +419,61 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 			//player radius
 			DrawModel(
 				sprs->circle.radius.plane,
-				fromDetVec2(state->p1.pos, .01f),
+				fromDetVec2(state->players[0].pos, .01f),
 				fromDetNum(cfg->playerRadius) * 2,
 				WHITE);
 			DrawModel(
 				sprs->circle.radius.plane,
-				fromDetVec2(state->p2.pos, .01f),
+				fromDetVec2(state->players[1].pos, .01f),
 				fromDetNum(cfg->playerRadius) * 2,
 				WHITE);
 
 			//charge paths
-			if (state->p1.pushdown.top() == PState::Charging)
+			if (state->players[0].pushdown.top() == PState::Charging)
 			{
-				float angle = RAD2DEG * angleFromDetVec2(state->p1.dir);
-				float divert = 1.0f - (static_cast<float>(state->p1.chargeCount) / static_cast<float>(cfg->chargeDuration));
+				float angle = RAD2DEG * angleFromDetVec2(state->players[0].dir);
+				float divert = 1.0f - (static_cast<float>(state->players[0].chargeCount) / static_cast<float>(cfg->chargeDuration));
 				float scroll = (divert * divert);
 				SetShaderValue(sprs->path.charge.shader, sprs->path.charge.scroll, &scroll, SHADER_UNIFORM_FLOAT);
 				DrawModelEx(sprs->path.charge.path,
-					fromDetVec2(state->p1.pos, .01f),
+					fromDetVec2(state->players[0].pos, .01f),
 					Vector3{ 0,-1,0 },
 					angle,
 					Vector3{ 1,1,.25 },
 					WHITE);
 				DrawModelEx(sprs->path.charge.path,
-					fromDetVec2(state->p1.pos, .005f),
+					fromDetVec2(state->players[0].pos, .005f),
 					Vector3{ 0,-1,0 },
 					angle + (divert * 30),
 					Vector3{ 1,1,.1 },
 					WHITE);
 				DrawModelEx(sprs->path.charge.path,
-					fromDetVec2(state->p1.pos, .005f),
+					fromDetVec2(state->players[0].pos, .005f),
 					Vector3{ 0,-1,0 },
 					angle - (divert * 30),
 					Vector3{ 1,1,.1 },
 					WHITE);
 			}
-			if (state->p2.pushdown.top() == PState::Charging)
+			if (state->players[1].pushdown.top() == PState::Charging)
 			{
-				float angle = RAD2DEG * angleFromDetVec2(state->p2.dir);
-				float divert = 1.0f - (static_cast<float>(state->p2.chargeCount) / static_cast<float>(cfg->chargeDuration));
+				float angle = RAD2DEG * angleFromDetVec2(state->players[1].dir);
+				float divert = 1.0f - (static_cast<float>(state->players[1].chargeCount) / static_cast<float>(cfg->chargeDuration));
 				float scroll = (divert * divert);
 				SetShaderValue(sprs->path.charge.shader, sprs->path.charge.scroll, &scroll, SHADER_UNIFORM_FLOAT);
 				DrawModelEx(sprs->path.charge.path,
-					fromDetVec2(state->p2.pos, .01f),
+					fromDetVec2(state->players[1].pos, .01f),
 					Vector3{ 0,-1,0 },
 					angle,
 					Vector3{ 1,1,.25 },
 					WHITE);
 				DrawModelEx(sprs->path.charge.path,
-					fromDetVec2(state->p2.pos, .005f),
+					fromDetVec2(state->players[1].pos, .005f),
 					Vector3{ 0,-1,0 },
 					angle + (divert * 30),
 					Vector3{ 1,1,.1 },
 					WHITE);
 				DrawModelEx(sprs->path.charge.path,
-					fromDetVec2(state->p2.pos, .005f),
+					fromDetVec2(state->players[1].pos, .005f),
 					Vector3{ 0,-1,0 },
 					angle - (divert * 30),
 					Vector3{ 1,1,.1 },
@@ -485,41 +488,42 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 			switch (pov)
 			{
 			case Player1:
-				showCombos = state->p1.ammo >= cfg->altShotCost;
-				framesToAltShot = state->p1.pushdown.top() == Charging ? (cfg->chargeDuration - state->p1.chargeCount) : cfg->chargeDuration;
+				showCombos = state->players[0].ammo >= cfg->altShotCost;
+				framesToAltShot = state->players[0].pushdown.top() == Charging ? (cfg->chargeDuration - state->players[0].chargeCount) : cfg->chargeDuration;
 				break;
 			case Player2:
-				showCombos = state->p2.ammo >= cfg->altShotCost;
-				framesToAltShot = state->p2.pushdown.top() == Charging ? (cfg->chargeDuration - state->p2.chargeCount) : cfg->chargeDuration;
+				showCombos = state->players[1].ammo >= cfg->altShotCost;
+				framesToAltShot = state->players[1].pushdown.top() == Charging ? (cfg->chargeDuration - state->players[1].chargeCount) : cfg->chargeDuration;
 				break;
 			}
-			for (auto it = state->projs.begin(); it != state->projs.end(); ++it)
+			for (projslot slot = firstProjectile(&state->projs); slot != NO_PROJECTILE; slot = nextProjectile(&state->projs, slot))
 			{
-				Vec2 futurePos = v2::add(it->pos, v2::scalarMult(it->vel, num_det{ framesToAltShot }));
+				Projectile proj = getProjectile(&state->projs, slot);
+				Vec2 futurePos = v2::add(proj.pos, v2::scalarMult(proj.vel, num_det{ framesToAltShot }));
 				bool withinReach = pov != Spectator && v2::length(futurePos) < cfg->arenaRadius;
 				//draw projectile
-				switch (it->owner)
+				switch (proj.owner)
 				{
 				case 1:
 					DrawBillboardPro(*cam,
 						sprs->projs.atlas,
 						sprs->projs.red, //source rect
-						fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2), //world pos
+						fromDetVec2(proj.pos, fromDetNum(cfg->playerRadius) * 2), //world pos
 						Vector3{ 0.0f,1.0f,0.0f }, //up vector
 						Vector2{ fromDetNum(cfg->projRadius) * 4, fromDetNum(cfg->projRadius) * 4 }, //size (proj size is defined by circle with half dimensions of sprite)
 						Vector2{ 0.0f, 0.0f }, //anchor for rotation and scaling
-						12 * it->lifetime, //rotation (degrees per frame)
+						12 * proj.lifetime, //rotation (degrees per frame)
 						WHITE);
 					break;
 				case 2:
 					DrawBillboardPro(*cam,
 						sprs->projs.atlas,
 						sprs->projs.blue, //source rect
-						fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2), //world pos
+						fromDetVec2(proj.pos, fromDetNum(cfg->playerRadius) * 2), //world pos
 						Vector3{ 0.0f,1.0f,0.0f }, //up vector
 						Vector2{ fromDetNum(cfg->projRadius) * 4, fromDetNum(cfg->projRadius) * 4 }, //size (proj size is defined by circle with half dimensions of sprite)
 						Vector2{ 0.0f, 0.0f }, //anchor for rotation and scaling
-						12 * it->lifetime, //rotation (degrees per frame)
+						12 * proj.lifetime, //rotation (degrees per frame)
 						WHITE);
 					break;
 				}
@@ -559,7 +563,7 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 				//draw ground radius
 				DrawModel(
 					sprs->circle.radius.plane,
-					fromDetVec2(it->pos, .01f),
+					fromDetVec2(proj.pos, .01f),
 					fromDetNum(cfg->projRadius) * 2,
 					WHITE);
 			}
@@ -567,50 +571,53 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 		
 		//DRAW PARTICLES
 		//projectile collisions
-		for (auto it = particles->projs.cbegin(); it != particles->projs.cend(); it++)
+		for (int i = 0; i < particles->projs.count; i++)
 		{
-			float lifetime_in_secs = it->lifetime / 60.0f;
+			const ParticlePool* parts = &(particles->projs);
+			float lifetime_in_secs = parts->lifetime[i] / 60.0f;
 			float size = std::max(0.0f, -12 * lifetime_in_secs * lifetime_in_secs + 4 * lifetime_in_secs + 1) * fromDetNum(cfg->projRadius) * 4;
-			switch (it->owner)
+			switch (parts->owner[i])
 			{
 			case 1:
 				DrawBillboardPro(*cam,
 					sprs->projs.atlas,
 					sprs->projs.red, //source rect
-					fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2), //world pos
+					fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2), //world pos
 					Vector3{ 0.0f,1.0f,0.0f }, //up vector
 					Vector2{ size, size }, //size (proj size is defined by circle with half dimensions of sprite)
 					Vector2{ 0.0f, 0.0f }, //anchor for rotation and scaling
-					24 * it->lifetime, //rotation (degrees per frame)
+					24 * parts->lifetime[i], //rotation (degrees per frame)
 					WHITE);
 				break;
 			case 2:
 				DrawBillboardPro(*cam,
 					sprs->projs.atlas,
 					sprs->projs.blue, //source rect
-					fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2), //world pos
+					fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2), //world pos
 					Vector3{ 0.0f,1.0f,0.0f }, //up vector
 					Vector2{ size, size }, //size (proj size is defined by circle with half dimensions of sprite)
 					Vector2{ 0.0f, 0.0f }, //anchor for rotation and scaling
-					24 * it->lifetime, //rotation (degrees per frame)
+					24 * parts->lifetime[i], //rotation (degrees per frame)
 					WHITE);
 				break;
 			}
 		}
 		//grazes
-		for (auto it = particles->grazes.cbegin(); it != particles->grazes.cend(); it++)
+		for (int i = 0; i < particles->grazes.count; i++)
 		{
-			float fadeAlpha = std::max(0.0f, 1.0f - it->lifetime / 60.0f);
+			const ParticlePool* parts = &(particles->grazes);
+			float fadeAlpha = std::max(0.0f, 1.0f - parts->lifetime[i] / 60.0f);
 			Color fade{255,255,255,255.0*fadeAlpha};
-			for (auto subIt = it->subParts.cbegin(); subIt != it->subParts.cend(); subIt++)
+			const Vector4* subParts = particles->subParts.parts[parts->sub[i]];
+			for (const Vector4* subIt = subParts; subIt != subParts + SUB_PARTS; subIt++)
 			{
 				float size = subIt->w * fromDetNum(cfg->projRadius) * 2;
-				float x = std::min(it->lifetime / 60.0f, 1.0f);
+				float x = std::min(parts->lifetime[i] / 60.0f, 1.0f);
 				float leap = -x*x + 2*x;
 				Vector3 pos{
-					fromDetNum(it->pos.x) + subIt->x * leap,
+					fromDetNum(parts->pos[i].x) + subIt->x * leap,
 					subIt->z * fromDetNum(cfg->playerRadius) * 2,
-					fromDetNum(it->pos.y) + subIt->y * leap
+					fromDetNum(parts->pos[i].y) + subIt->y * leap
 				};
 				DrawBillboardPro(*cam,
 					sprs->effects.atlas,
@@ -624,19 +631,21 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 			}
 		}
 		//alerts
-		for (auto it = particles->alerts.cbegin(); it != particles->alerts.cend(); it++)
+		for (int i = 0; i < particles->alerts.count; i++)
 		{
-			float fadeAlpha = std::max(0.0f, 1.0f - (it->lifetime * 1.0f) / 60.0f);
+			const ParticlePool* parts = &(particles->alerts);
+			float fadeAlpha = std::max(0.0f, 1.0f - (parts->lifetime[i] * 1.0f) / 60.0f);
 			Color fade{ 255,255,255,255.0 * fadeAlpha };
-			for (auto subIt = it->subParts.cbegin(); subIt != it->subParts.cend(); subIt++)
+			const Vector4* subParts = particles->subParts.parts[parts->sub[i]];
+			for (const Vector4* subIt = subParts; subIt != subParts + SUB_PARTS; subIt++)
 			{
 				float size = subIt->w * fromDetNum(cfg->projRadius) * 2;
-				float x = std::min(it->lifetime / 60.0f, 1.0f);
+				float x = std::min(parts->lifetime[i] / 60.0f, 1.0f);
 				float leap = 2*(-x * x + 2 * x);
 				Vector3 pos{
-					fromDetNum(it->pos.x) + subIt->x * leap,
+					fromDetNum(parts->pos[i].x) + subIt->x * leap,
 					subIt->z * fromDetNum(cfg->playerRadius) * 2,
-					fromDetNum(it->pos.y) + subIt->y * leap
+					fromDetNum(parts->pos[i].y) + subIt->y * leap
 				};
 				DrawBillboardPro(*cam,
 					sprs->effects.atlas,
@@ -650,17 +659,18 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 			}
 		}
 		//hitscan trails
-		for (auto it = particles->hitscans.cbegin(); it != particles->hitscans.cend(); it++)
+		for (int i = 0; i < particles->hitscans.count; i++)
 		{
-			float angle = RAD2DEG * angleFromDetVec2(it->dir);
-			float lifetime_in_secs = it->lifetime / 60.0f;
+			const ParticlePool* parts = &(particles->hitscans);
+			float angle = RAD2DEG * angleFromDetVec2(parts->dir[i]);
+			float lifetime_in_secs = parts->lifetime[i] / 60.0f;
 			float size = std::max(0.0f, -12 * lifetime_in_secs * lifetime_in_secs + 4 * lifetime_in_secs + 1) * fromDetNum(cfg->projRadius) * 3;
 			Color fade{ 255,255,255,std::min(255.0f, 255.0f * size) };
-			switch (it->owner)
+			switch (parts->owner[i])
 			{
 			case 1:
 				DrawModelEx(sprs->path.hitscanRed.path,
-					fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2),
+					fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2),
 					Vector3{ 0,-1,0 },
 					angle,
 					Vector3{ 1,1,.15 },
@@ -668,16 +678,16 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 				DrawBillboardPro(*cam,
 					sprs->projs.atlas,
 					sprs->projs.red, //source rect
-					fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2), //world pos
+					fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2), //world pos
 					Vector3{ 0.0f,1.0f,0.0f }, //up vector
 					Vector2{ size, size }, //size (proj size is defined by circle with half dimensions of sprite)
 					Vector2{ 0.0f, 0.0f }, //anchor for rotation and scaling
-					6 * it->lifetime, //rotation (degrees per frame)
+					6 * parts->lifetime[i], //rotation (degrees per frame)
 					WHITE);
 				break;
 			case 2:
 				DrawModelEx(sprs->path.hitscanBlue.path,
-					fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2),
+					fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2),
 					Vector3{ 0,-1,0 },
 					angle,
 					Vector3{ 1,1,.15 },
@@ -685,33 +695,34 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 				DrawBillboardPro(*cam,
 					sprs->projs.atlas,
 					sprs->projs.blue, //source rect
-					fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2), //world pos
+					fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2), //world pos
 					Vector3{ 0.0f,1.0f,0.0f }, //up vector
 					Vector2{ size, size }, //size (proj size is defined by circle with half dimensions of sprite)
 					Vector2{ 0.0f, 0.0f }, //anchor for rotation and scaling
-					12 * it->lifetime, //rotation (degrees per frame)
+					12 * parts->lifetime[i], //rotation (degrees per frame)
 					WHITE);
 				break;
 			}
 		}
 		//combos
-		for (auto it = particles->combos.cbegin(); it != particles->combos.cend(); it++)
+		for (int i = 0; i < particles->combos.count; i++)
 		{
+			const ParticlePool* parts = &(particles->combos);
 			float filter = 1.0f;
-			float pos[2] = { fromDetNum(it->pos.x), fromDetNum(it->pos.y) };
-			float fade = it->lifetime / 30.0f;
+			float pos[2] = { fromDetNum(parts->pos[i].x), fromDetNum(parts->pos[i].y) };
+			float fade = parts->lifetime[i] / 30.0f;
 			SetShaderValue(sprs->combo.shader, sprs->combo.filter, &filter, SHADER_UNIFORM_FLOAT);
 			SetShaderValue(sprs->combo.shader, sprs->combo.pos, pos, SHADER_UNIFORM_VEC2);
 			SetShaderValue(sprs->combo.shader, sprs->combo.fade, &fade, SHADER_UNIFORM_FLOAT);
 			DrawModel(sprs->combo.model,
-				fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2),
+				fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2),
 				fromDetNum(cfg->comboRadius),
 				WHITE);
 			SetShaderValue(sprs->combo.invert.shader, sprs->combo.invert.filter, &filter, SHADER_UNIFORM_FLOAT);
 			SetShaderValue(sprs->combo.invert.shader, sprs->combo.invert.pos, pos, SHADER_UNIFORM_VEC2);
 			SetShaderValue(sprs->combo.invert.shader, sprs->combo.invert.fade, &fade, SHADER_UNIFORM_FLOAT);
 			DrawModel(sprs->combo.invert.model,
-				fromDetVec2(it->pos, fromDetNum(cfg->playerRadius) * 2),
+				fromDetVec2(parts->pos[i], fromDetNum(cfg->playerRadius) * 2),
 				fromDetNum(cfg->comboRadius),
 				WHITE);
 		}
@@ -724,7 +735,45 @@ void gameScene(POV pov, const GameState* state, const SecSimParticles* particles
 //MATCH PRESENTATION
 
 //returns semaphore idle time
-double present(POV pov, const GameState* state, const SecSimParticles* particles, const Config* cfg, Camera3D* cam, const Sprites* sprs, std::ostringstream* gameInfoOSS)
+//one bar per bin, scaled to the fullest bin, with the mean and worst sample underneath
+void drawHistogram(const ProfileHistogram* hist, int x, int y)
+{
+	const int barWidth = 10;
+	const int height = 60;
+	long fullest = 1;
+	for (int i = 0; i < PROFILE_BINS; i++)
+	{
+		fullest = std::max(fullest, hist->counts[i]);
+	}
+	DrawRectangle(x, y, barWidth * PROFILE_BINS, height, Color{ 0,0,0,64 });
+	for (int i = 0; i < PROFILE_BINS; i++)
+	{
+		int barHeight = static_cast<int>(height * hist->counts[i] / fullest);
+		DrawRectangle(x + barWidth * i + 1, y + height - barHeight, barWidth - 2, barHeight, (i == PROFILE_BINS - 1) ? RED : DARKGRAY);
+	}
+	char label[128];
+	if (hist->origin != 0)
+		snprintf(label, sizeof(label), "%s (%.2f%s bins from %.2f%s)", hist->name, hist->binWidth, hist->unit, hist->origin, hist->unit);
+	else
+		snprintf(label, sizeof(label), "%s (%.2f%s bins)", hist->name, hist->binWidth, hist->unit);
+	DrawText(label, x, y - 14, 10, DARKGRAY);
+	snprintf(label, sizeof(label), "mean %.2f%s, sd %.2f, worst %.2f%s", histogramMean(hist), hist->unit, histogramStdDev(hist), hist->worst, hist->unit);
+	DrawText(label, x, y + height + 4, 10, DARKGRAY);
+}
+
+void drawProfiler(const ProfileView* profile)
+{
+	const int perColumn = 6;
+	int y = 150;
+	for (int i = 0; i < PROFILE_VIEW_HISTOGRAMS; i++)
+	{
+		int x = screenWidth - (5 + 10 * PROFILE_BINS) * (i / perColumn + 1);
+		drawHistogram(&profile->hists[i], x, y + 90 * (i % perColumn));
+	}
+}
+
+//the profiler histograms get drawn when there are some
+double present(POV pov, const GameState* state, const SecSimParticles* particles, const Config* cfg, Camera3D* cam, const Sprites* sprs, const char* gameInfo, const ProfileView* profile = NULL)
 {
 	setCamera(cam, NULL, state, pov);
 	
@@ -735,7 +784,7 @@ double present(POV pov, const GameState* state, const SecSimParticles* particles
 	gameScene(pov, state, particles, cfg, cam, sprs);
 
 	float size = 6;
-	for (int i = 0; i < state->health1; i++)
+	for (int i = 0; i < state->health[0]; i++)
 	{
 		DrawTexturePro(sprs->hearts.atlas,
 			sprs->hearts.heartRed,
@@ -747,7 +796,7 @@ double present(POV pov, const GameState* state, const SecSimParticles* particles
 			},
 			Vector2{ 0,0 }, 0.0f, WHITE);
 	}
-	for (int i = 0; i < state->health2; i++)
+	for (int i = 0; i < state->health[1]; i++)
 	{
 		DrawTexturePro(sprs->hearts.atlas,
 			sprs->hearts.heartBlue,
@@ -762,7 +811,7 @@ double present(POV pov, const GameState* state, const SecSimParticles* particles
 	for (int i = 0; i < cfg->roundsToWin; i++)
 	{
 		DrawTexturePro(sprs->hearts.atlas,
-			(i + 1 <= state->rounds1 ? sprs->hearts.roundYes : sprs->hearts.roundNo),
+			(i + 1 <= state->rounds[0] ? sprs->hearts.roundYes : sprs->hearts.roundNo),
 			Rectangle{
 				5 + 8 * size * i,
 				5 + 8 * size,
@@ -771,7 +820,7 @@ double present(POV pov, const GameState* state, const SecSimParticles* particles
 			},
 			Vector2{ 0,0 }, 0.0f, WHITE);
 		DrawTexturePro(sprs->hearts.atlas,
-			(i + 1 <= state->rounds2 ? sprs->hearts.roundYes : sprs->hearts.roundNo),
+			(i + 1 <= state->rounds[1] ? sprs->hearts.roundYes : sprs->hearts.roundNo),
 			Rectangle{
 				screenWidth - 5 - 8 * size * (i + 1),
 				5 + 8 * size,
@@ -803,31 +852,33 @@ double present(POV pov, const GameState* state, const SecSimParticles* particles
 		3.f, RED);
 
 	if (pov == Player1)
-		drawBars(&state->p1, cfg);
+		drawBars(&state->players[0], cfg);
 	else if (pov == Player2)
-		drawBars(&state->p2, cfg);
+		drawBars(&state->players[1], cfg);
 
+	char countdown[16];
 	switch (state->phase)
 	{
 	case Countdown:
-		DrawText(std::to_string(static_cast<int>(ceil(state->roundCountdown / 60.0))).c_str(),
-			screenWidth / 2 - 50, screenHeight / 2 - 100, 150, BLACK);
+		snprintf(countdown, sizeof(countdown), "%d", static_cast<int>(ceil(state->roundCountdown / 60.0)));
+		DrawText(countdown, screenWidth / 2 - 50, screenHeight / 2 - 100, 150, BLACK);
 		break;
 	case Play:
-		DrawText(std::to_string(state->roundCountdown / 60).c_str(),
-			screenWidth / 2 - 40, 5, 60, BLACK);
+		snprintf(countdown, sizeof(countdown), "%d", static_cast<int>(state->roundCountdown / 60));
+		DrawText(countdown, screenWidth / 2 - 40, 5, 60, BLACK);
 		break;
 	case End:
-		if (state->health1 > state->health2)
+		if (state->health[0] > state->health[1])
 			DrawText("P1 WIN!", screenWidth / 2 - 200, screenHeight / 2 - 100, 150, RED);
-		else if (state->health1 < state->health2)
+		else if (state->health[0] < state->health[1])
 			DrawText("P2 WIN!", screenWidth / 2 - 200, screenHeight / 2 - 100, 150, BLUE);
 		else
 			DrawText("It's a tie.", screenWidth / 2 - 240, screenHeight / 2 - 100, 150, BLACK);
 		break;
 	}
 
-	DrawText(gameInfoOSS->str().c_str(), 5, 5 + 16 * size, 20, GRAY);
+	DrawText(gameInfo, 5, 5 + 16 * size, 20, GRAY);
+	if (profile) drawProfiler(profile);
 
 	//I figure this is also the timing semaphore
 	double beforeSemaphore = GetTime();
@@ -847,7 +898,7 @@ struct HomeInfo
 	Shader bgShader;
 };
 
-void presentMenu(POV pov, const GameState* state, const SecSimParticles* particles, const Config* cfg, Camera3D* cam, const Sprites* sprs, std::ostringstream* gameInfoOSS, HomeInfo* home)
+void presentMenu(POV pov, const GameState* state, const SecSimParticles* particles, const Config* cfg, Camera3D* cam, const Sprites* sprs, const char* gameInfo, HomeInfo* home)
 {
 	setCamera(cam, &home->lazyCam, state, pov);
 
@@ -921,6 +972,7 @@ void presentMenu(POV pov, const GameState* state, const SecSimParticles* particl
 
 
 		DrawText("Press F4 to show background demo", 880, 5, 20, BLACK);
+		DrawText("Press F3 to spectate the remote address", 820, 30, 20, BLACK);
 	}
 	else
 	{
@@ -930,7 +982,7 @@ void presentMenu(POV pov, const GameState* state, const SecSimParticles* particl
 			Vector2{ 0, 0 }, WHITE);
 	}
 
-	DrawText(gameInfoOSS->str().c_str(), 5, 5, 20, BLACK);
+	DrawText(gameInfo, 5, 5, 20, BLACK);
 
 	EndDrawing();
 }
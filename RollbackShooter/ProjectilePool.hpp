@@ -0,0 +1,209 @@
+#ifndef RBST_PROJECTILEPOOL_HPP
+#define RBST_PROJECTILEPOOL_HPP
+
+//std
+#include <cstdint>
+//-----
+#include "Math.hpp"
+#include "Player.hpp"
+#include "VecBatch.hpp"
+
+//the game ships with 16, stress builds can raise it
+#ifndef RBST_MAX_PROJECTILES
+#define RBST_MAX_PROJECTILES 16
+#endif
+const size_t MAX_PROJECTILES = RBST_MAX_PROJECTILES;
+static_assert(MAX_PROJECTILES < 0xffff, "projectile slots are 16 bit");
+
+using projslot = std::uint16_t;
+const projslot NO_PROJECTILE = 0xffff;
+
+//one projectile as a plain value, for spawning and for reading one back out of the pool
+struct Projectile
+{
+	Vec2 pos = v2::zero();
+	Vec2 vel = v2::zero();
+	playerid owner = 0;
+	int16 lifetime;
+};
+
+//refers to one projectile until it is removed, even after its slot gets reused
+struct ProjectileHandle
+{
+	projslot slot = NO_PROJECTILE;
+	std::uint16_t generation = 0;
+};
+
+//fixed capacity projectile storage, one array per field
+//removing is O(1): the slot goes back on the free list and nothing else moves
+//live projectiles are also chained in spawn order, and that chain is what the simulation walks,
+//so the order hits get resolved in never depends on which slots happened to be free
+//everything is plain arrays, GameState can still be saved with a memcpy
+struct ProjectilePool
+{
+	num_det posX[MAX_PROJECTILES] = {};
+	num_det posY[MAX_PROJECTILES] = {};
+	num_det velX[MAX_PROJECTILES] = {};
+	num_det velY[MAX_PROJECTILES] = {};
+	playerid owner[MAX_PROJECTILES] = {};
+	int16 lifetime[MAX_PROJECTILES] = {};
+	std::uint16_t generation[MAX_PROJECTILES] = {};
+	//spawn count the projectile got, what its events are known by since its slot can change (snapshots respawn from 0)
+	std::uint16_t serial[MAX_PROJECTILES] = {};
+	std::uint64_t alive[(MAX_PROJECTILES + 63) / 64] = {};
+	//spawn order chain
+	projslot next[MAX_PROJECTILES] = {};
+	projslot prev[MAX_PROJECTILES] = {};
+	projslot first = NO_PROJECTILE;
+	projslot last = NO_PROJECTILE;
+	//slots given back since the last clear, reused last in first out
+	projslot freeSlots[MAX_PROJECTILES] = {};
+	projslot freeCount = 0;
+	//slots from here on haven't been handed out since the last clear
+	projslot highWater = 0;
+	projslot count = 0;
+	//projectiles spawned this match, wraps around
+	std::uint16_t spawned = 0;
+};
+
+inline bool slotAlive(const ProjectilePool* pool, projslot slot)
+{
+	return (pool->alive[slot / 64] >> (slot % 64)) & 1;
+}
+
+inline bool projectileAlive(const ProjectilePool* pool, ProjectileHandle handle)
+{
+	return handle.slot < MAX_PROJECTILES &&
+		slotAlive(pool, handle.slot) &&
+		pool->generation[handle.slot] == handle.generation;
+}
+
+inline size_t projectileCount(const ProjectilePool* pool)
+{
+	return pool->count;
+}
+
+inline Vec2 projectilePos(const ProjectilePool* pool, projslot slot)
+{
+	return Vec2{ pool->posX[slot], pool->posY[slot] };
+}
+
+inline Vec2 projectileVel(const ProjectilePool* pool, projslot slot)
+{
+	return Vec2{ pool->velX[slot], pool->velY[slot] };
+}
+
+inline void setProjectileVel(ProjectilePool* pool, projslot slot, Vec2 vel)
+{
+	pool->velX[slot] = vel.x;
+	pool->velY[slot] = vel.y;
+}
+
+Projectile getProjectile(const ProjectilePool* pool, projslot slot)
+{
+	return Projectile{ projectilePos(pool, slot), projectileVel(pool, slot), pool->owner[slot], pool->lifetime[slot] };
+}
+
+//a full pool hands back an empty handle and the shot just doesn't happen
+ProjectileHandle spawnProjectile(ProjectilePool* pool, Projectile proj)
+{
+	projslot slot;
+	if (pool->freeCount > 0)
+	{
+		slot = pool->freeSlots[--(pool->freeCount)];
+	}
+	else if (pool->highWater < MAX_PROJECTILES)
+	{
+		slot = (pool->highWater)++;
+	}
+	else
+	{
+		return ProjectileHandle{};
+	}
+	pool->posX[slot] = proj.pos.x;
+	pool->posY[slot] = proj.pos.y;
+	pool->velX[slot] = proj.vel.x;
+	pool->velY[slot] = proj.vel.y;
+	pool->owner[slot] = proj.owner;
+	pool->lifetime[slot] = proj.lifetime;
+	pool->serial[slot] = (pool->spawned)++;
+	pool->alive[slot / 64] |= std::uint64_t{ 1 } << (slot % 64);
+	//append to the spawn order chain
+	pool->next[slot] = NO_PROJECTILE;
+	pool->prev[slot] = pool->last;
+	if (pool->last != NO_PROJECTILE) pool->next[pool->last] = slot; else pool->first = slot;
+	pool->last = slot;
+	(pool->count)++;
+	return ProjectileHandle{ slot, pool->generation[slot] };
+}
+
+void removeProjectile(ProjectilePool* pool, projslot slot)
+{
+	if (!slotAlive(pool, slot)) return;
+	projslot before = pool->prev[slot];
+	projslot after = pool->next[slot];
+	if (before != NO_PROJECTILE) pool->next[before] = after; else pool->first = after;
+	if (after != NO_PROJECTILE) pool->prev[after] = before; else pool->last = before;
+	//next[slot] is left pointing where it did on purpose, see nextProjectile
+	pool->alive[slot / 64] &= ~(std::uint64_t{ 1 } << (slot % 64));
+	//no velocity, so moving the whole pool at once leaves dead slots where they are
+	pool->velX[slot] = num_det{ 0 };
+	pool->velY[slot] = num_det{ 0 };
+	(pool->generation[slot])++;
+	pool->freeSlots[(pool->freeCount)++] = slot;
+	(pool->count)--;
+}
+
+inline void removeProjectile(ProjectilePool* pool, ProjectileHandle handle)
+{
+	if (projectileAlive(pool, handle)) removeProjectile(pool, handle.slot);
+}
+
+void clearProjectiles(ProjectilePool* pool)
+{
+	while (pool->first != NO_PROJECTILE)
+	{
+		removeProjectile(pool, pool->first);
+	}
+	pool->freeCount = 0;
+	pool->highWater = 0;
+}
+
+//oldest live projectile, NO_PROJECTILE when there are none
+inline projslot firstProjectile(const ProjectilePool* pool)
+{
+	return pool->first;
+}
+
+//the live projectile spawned right after this one
+//slot may have been removed since the walk got to it (a railgun fired mid-walk can take out any projectile):
+//a removed slot still points at what came after it back then, so following those links lands on the next live one
+//that only holds while nothing spawns, so don't spawn in the middle of a walk
+inline projslot nextProjectile(const ProjectilePool* pool, projslot slot)
+{
+	projslot after = pool->next[slot];
+	while (after != NO_PROJECTILE && !slotAlive(pool, after))
+	{
+		after = pool->next[after];
+	}
+	return after;
+}
+
+inline void moveProjectile(ProjectilePool* pool, projslot slot)
+{
+	pool->posX[slot] += pool->velX[slot];
+	pool->posY[slot] += pool->velY[slot];
+}
+
+//every projectile moves by its velocity in one straight pass over the arrays
+//simulate() moves them one at a time during its walk instead, see chargeReleasable()
+void integrateProjectiles(ProjectilePool* pool)
+{
+	v2batch::add(
+		ConstVec2Columns(pool->posX, pool->posY),
+		ConstVec2Columns(pool->velX, pool->velY),
+		Vec2Columns{ pool->posX, pool->posY },
+		pool->highWater);
+}
+
+#endif
@@ -1,20 +1,111 @@
 #ifndef RBST_REPLAY_HPP
 #define RBST_REPLAY_HPP
 
+//std
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <vector>
+//-----
+#include "Config.hpp"
 #include "Input.hpp"
 
 //since GGPO as-is does not make transparent which is the earliest confirm frame saved
 //here's a hardcoded window size from the latest confirm frame backwards
 //as 15f = 250ms, you'll be fine even at a ping of 500ms
 const int REPLAY_ROLLBACK_WINDOW = 15;
+//one frame of a duel takes 2 to 10 bytes
+const size_t REPLAY_INPUT_MAX_BYTES = 10;
+
+//INPUT ENCODING
+//the same bytes go to replay files and to spectators
+
+//a byte per player with move and attack, plus the mouse when it moved since the last frame written
+//a keyframe writes both mice regardless, so it can be read without the frames before it
+size_t packReplayInput(InputData input, int32_t* p1LastMouse, int32_t* p2LastMouse, char* bytes, bool keyframe = false)
+{
+	//only store mouse when it moves
+	int32_t p1MouseRaw = input.players[0].mouse.raw_value(), p2MouseRaw = input.players[1].mouse.raw_value();
+	bool p1MouseMoved = keyframe || *p1LastMouse != p1MouseRaw, p2MouseMoved = keyframe || *p2LastMouse != p2MouseRaw;
+	//move and attack inputs get always stored since they fit packed in a byte
+	//and since together they take 6 bits, in goes a bit on whether mouse moved
+	bytes[0] = (int(p1MouseMoved) << 6) |
+		(static_cast<char>(input.players[0].mov) << 2) |
+		static_cast<char>(input.players[0].atk);
+	bytes[1] = (int(p2MouseMoved) << 6) |
+		(static_cast<char>(input.players[1].mov) << 2) |
+		static_cast<char>(input.players[1].atk);
+	size_t size = 2;
+	if (p1MouseMoved)
+	{
+		memcpy(bytes + size, &p1MouseRaw, sizeof(p1MouseRaw));
+		size += sizeof(p1MouseRaw);
+		*p1LastMouse = p1MouseRaw;
+	}
+	if (p2MouseMoved)
+	{
+		memcpy(bytes + size, &p2MouseRaw, sizeof(p2MouseRaw));
+		size += sizeof(p2MouseRaw);
+		*p2LastMouse = p2MouseRaw;
+	}
+	return size;
+}
+
+//how many bytes the frame starting with these 2 header bytes takes
+inline size_t replayInputSize(const char* headers)
+{
+	char mouseMask = 0b01000000;
+	return 2 + ((headers[0] & mouseMask) ? 4 : 0) + ((headers[1] & mouseMask) ? 4 : 0);
+}
+
+//bytes read, 0 when size falls short of a whole frame
+size_t unpackReplayInput(const char* bytes, size_t size, int32_t* p1LastMouse, int32_t* p2LastMouse, InputData* input)
+{
+	if (size < 2 || size < replayInputSize(bytes)) return 0;
+	PlayerInput p1, p2;
+	char movMask   = 0b00111100;
+	char atkMask   = 0b00000011;
+	char mouseMask = 0b01000000;
+
+	p1.atk = static_cast<AttackInput>(bytes[0] & atkMask);
+	p1.mov = static_cast<MoveInput>((bytes[0] & movMask) >> 2);
+	p2.atk = static_cast<AttackInput>(bytes[1] & atkMask);
+	p2.mov = static_cast<MoveInput>((bytes[1] & movMask) >> 2);
+
+	size_t read = 2;
+	if (bytes[0] & mouseMask)
+	{
+		memcpy(p1LastMouse, bytes + read, sizeof(*p1LastMouse));
+		read += sizeof(*p1LastMouse);
+	}
+	if (bytes[1] & mouseMask)
+	{
+		memcpy(p2LastMouse, bytes + read, sizeof(*p2LastMouse));
+		read += sizeof(*p2LastMouse);
+	}
+
+	p1.mouse = p1.mouse.from_raw_value(*p1LastMouse);
+	p2.mouse = p2.mouse.from_raw_value(*p2LastMouse);
+
+	*input = InputData{ p1,p2 };
+	return read;
+}
+
+//REPLAY WRITING
 
 struct ReplayWriter
 {
 	long confirmFrame;
 	std::vector<InputData> inputBuffer;
 	std::ofstream fileStream;
+	//date stamp the file is named after, without the extension
+	std::string baseName;
 	int32_t p1LastMouse;
 	int32_t p2LastMouse;
+	//optionally told about every input as it gets confirmed and written, e.g. to relay it to spectators
+	void* confirmedContext = NULL;
+	void (*confirmed)(void* context, long frame, InputData input) = NULL;
 };
 
 void openReplayFile(ReplayWriter* replay, Config* cfg)
@@ -27,10 +118,15 @@ void openReplayFile(ReplayWriter* replay, Config* cfg)
 	struct tm currDate;
 	time_t currTime;
 	time(&currTime);
+#if defined(_WIN32)
 	localtime_s(&currDate, &currTime);
+#else
+	localtime_r(&currTime, &currDate);
+#endif
 	std::ostringstream fileNameOSS("");
 	fileNameOSS << currDate.tm_year + 1900 << "-" << currDate.tm_mon + 1 << "-" << currDate.tm_mday << "_";
 	fileNameOSS << currDate.tm_hour << "-" << currDate.tm_min << "-" << currDate.tm_sec;
+	replay->baseName = fileNameOSS.str();
 	fileNameOSS << ".rbst";
 	replay->fileStream.open(fileNameOSS.str().c_str(), std::fstream::out | std::fstream::binary);
 	//configs at the time of match get saved along with following inputs
@@ -54,29 +150,10 @@ void consumeReplayInput(ReplayWriter* replay, long confFrame)
 	while (replay->confirmFrame < (confFrame-REPLAY_ROLLBACK_WINDOW))
 	{
 		InputData input = replay->inputBuffer.front();
-		char zipHeaders[2] = { 0 };
-		//only store mouse when it moves
-		int32_t p1MouseRaw = input.p1Input.mouse.raw_value(), p2MouseRaw = input.p2Input.mouse.raw_value();
-		bool p1MouseMoved = replay->p1LastMouse != p1MouseRaw, p2MouseMoved = replay->p2LastMouse != p2MouseRaw;
-		//move and attack inputs get always stored since they fit packed in a byte
-		//and since together they take 6 bits, in goes a bit on whether mouse moved
-		zipHeaders[0] = (int(p1MouseMoved) << 6) |
-			(static_cast<char>(input.p1Input.mov) << 2) |
-			static_cast<char>(input.p1Input.atk);
-		zipHeaders[1] = (int(p2MouseMoved) << 6) |
-			(static_cast<char>(input.p2Input.mov) << 2) |
-			static_cast<char>(input.p2Input.atk);
-		replay->fileStream.write(zipHeaders, 2);
-		if (p1MouseMoved)
-		{
-			replay->fileStream.write((char*)&p1MouseRaw, sizeof(p1MouseRaw));
-			replay->p1LastMouse = p1MouseRaw;
-		}
-		if (p2MouseMoved)
-		{
-			replay->fileStream.write((char*)&p2MouseRaw, sizeof(p2MouseRaw));
-			replay->p2LastMouse = p2MouseRaw;
-		}
+		char bytes[REPLAY_INPUT_MAX_BYTES];
+		size_t size = packReplayInput(input, &replay->p1LastMouse, &replay->p2LastMouse, bytes);
+		replay->fileStream.write(bytes, size);
+		if (replay->confirmed) replay->confirmed(replay->confirmedContext, replay->confirmFrame, input);
 		replay->inputBuffer.erase(replay->inputBuffer.begin());
 		replay->confirmFrame++;
 	}
@@ -116,38 +193,14 @@ bool replayFileEnd(ReplayReader* replay)
 
 InputData readReplayFile(ReplayReader* replay)
 {
-	PlayerInput p1, p2;
-	int32_t p1MouseRaw = 0, p2MouseRaw = 0;
-	char movMask   = 0b00111100;
-	char atkMask   = 0b00000011;
-	char mouseMask = 0b01000000;
-
-	char zipHeaders[2];
-	replay->fileStream.read(zipHeaders, 2);
-
-	p1.atk = static_cast<AttackInput>(zipHeaders[0] & atkMask);
-	p1.mov = static_cast<MoveInput>((zipHeaders[0] & movMask) >> 2);
-	p2.atk = static_cast<AttackInput>(zipHeaders[1] & atkMask);
-	p2.mov = static_cast<MoveInput>((zipHeaders[1] & movMask) >> 2);
-
-	if (zipHeaders[0] & mouseMask)
-	{
-		replay->fileStream.read((char*)&p1MouseRaw, sizeof(p1MouseRaw));
-		replay->p1LastMouse = p1MouseRaw;
-	}
-	else p1MouseRaw = replay->p1LastMouse;
-
-	if (zipHeaders[1] & mouseMask)
-	{
-		replay->fileStream.read((char*)&p2MouseRaw, sizeof(p2MouseRaw));
-		replay->p2LastMouse = p2MouseRaw;
-	}
-	else p2MouseRaw = replay->p2LastMouse;
-
-	p1.mouse = p1.mouse.from_raw_value(p1MouseRaw);
-	p2.mouse = p2.mouse.from_raw_value(p2MouseRaw);
-
-	return InputData{ p1,p2 };
+	char bytes[REPLAY_INPUT_MAX_BYTES];
+	replay->fileStream.read(bytes, 2);
+	size_t size = replayInputSize(bytes);
+	replay->fileStream.read(bytes + 2, size - 2);
+
+	InputData input;
+	unpackReplayInput(bytes, size, &replay->p1LastMouse, &replay->p2LastMouse, &input);
+	return input;
 }
 
 void closeReplayFile(ReplayReader* replay)
@@ -0,0 +1,237 @@
+#ifndef RBST_ROLLBACKPEER_HPP
+#define RBST_ROLLBACKPEER_HPP
+
+//std
+#include <algorithm>
+#include <cstdint>
+//-----
+#include "Config.hpp"
+#include "Input.hpp"
+#include "InputPredictor.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "Snapshot.hpp"
+#include "Transport.hpp"
+
+//one side of a two player rollback match without GGPO, talking through a Transport
+//it does what GGPO does for us online, cut down to what headless tools need: send local inputs (every unacknowledged one,
+//every tick, so losses heal on their own), predict the remote player (by repeating their last input like GGPO unless it's
+//given another InputPredictor), and when the real input
+//turns out different, load the snapshot from that frame and simulate back up to the present
+//no presentation and no secondary sim, those only matter on screen
+
+//how many frames a peer may run ahead of the last remote input it has, GGPO's default too
+const int PEER_MAX_PREDICTION = 8;
+//frames of inputs and snapshots kept around, a lot more than a rollback can reach back
+const int PEER_RING = 64;
+//inputs per packet, the oldest unacknowledged ones go first
+const int PEER_MAX_PACKET_INPUTS = 32;
+const std::uint8_t PEER_INPUT_PACKET = 'I';
+
+struct PeerStats
+{
+	long rollbacks = 0;
+	long resimulated = 0;
+	long worstRollback = 0;
+	//ticks the peer had to wait on the remote instead of advancing
+	long stalls = 0;
+	long packetsSent = 0;
+	long packetsReceived = 0;
+};
+
+struct RollbackPeer
+{
+	//0 plays as player 1, 1 as player 2
+	int localSide = 0;
+	const Config* cfg = NULL;
+	Transport transport;
+	GameState state;
+	SecSimFlux flux;
+	//everything per frame is kept at frame % PEER_RING
+	PlayerInputZip localInputs[PEER_RING];
+	PlayerInputZip remoteInputs[PEER_RING];
+	//what the remote player was simulated with, confirmed or predicted
+	PlayerInputZip usedRemote[PEER_RING];
+	std::uint8_t saved[PEER_RING][MAX_SNAPSHOT_BYTES];
+	size_t savedSize[PEER_RING];
+	long lastLocalInput = -1;
+	//local inputs go this many frames ahead of the frame being simulated, like ggpo_set_frame_delay
+	int inputDelay = 0;
+	//every remote input up to and including this frame has arrived
+	long remoteConfirmed = -1;
+	//the remote has every local input up to and including this frame
+	long localAcked = -1;
+	//earliest frame simulated with a wrong prediction, -1 when there's none
+	long firstMispredicted = -1;
+	//set after resetPeer to predict some other way
+	InputPredictor predictor;
+	PeerStats stats;
+};
+
+void resetPeer(RollbackPeer* peer, const Config* cfg, int localSide, Transport transport)
+{
+	peer->localSide = localSide;
+	peer->cfg = cfg;
+	peer->transport = transport;
+	peer->state = initialState(cfg);
+	peer->flux = SecSimFlux{};
+	peer->lastLocalInput = -1;
+	peer->inputDelay = 0;
+	peer->remoteConfirmed = -1;
+	peer->localAcked = -1;
+	peer->firstMispredicted = -1;
+	peer->predictor = repeatPredictor();
+	peer->stats = PeerStats{};
+}
+
+inline PlayerInputZip predictRemote(const RollbackPeer* peer, long frame)
+{
+	InputHistory history{ peer->remoteInputs, PEER_RING, peer->remoteConfirmed };
+	return predictWith(&peer->predictor, &history, frame);
+}
+
+InputData peerFrameInput(RollbackPeer* peer, long frame)
+{
+	int index = frame % PEER_RING;
+	PlayerInputZip remote = (frame <= peer->remoteConfirmed) ? peer->remoteInputs[index] : predictRemote(peer, frame);
+	peer->usedRemote[index] = remote;
+	InputData input;
+	input.players[peer->localSide] = unzipInput(peer->localInputs[index]);
+	input.players[peer->localSide ^ 1] = unzipInput(remote);
+	return input;
+}
+
+//saves the state the frame starts from, then simulates it
+void stepPeer(RollbackPeer* peer)
+{
+	long frame = peer->state.frame;
+	int index = frame % PEER_RING;
+	peer->savedSize[index] = encodeSnapshot(&peer->state, peer->saved[index], MAX_SNAPSHOT_BYTES);
+	simulate(&peer->state, &peer->flux, peer->cfg, peerFrameInput(peer, frame));
+	clearFlux(&peer->flux);
+}
+
+//start frame, acknowledged frame + 1, count, then count inputs (movAtk, mouse)
+void sendPeerInputs(RollbackPeer* peer)
+{
+	std::uint8_t bytes[MAX_DATAGRAM_BYTES];
+	SnapshotWriter writer{ bytes, sizeof(bytes) };
+	long start = peer->localAcked + 1;
+	long count = std::max(0L, std::min(static_cast<long>(PEER_MAX_PACKET_INPUTS), peer->lastLocalInput - start + 1));
+	putByte(&writer, PEER_INPUT_PACKET);
+	putInt(&writer, static_cast<std::uint32_t>(start), 4);
+	putInt(&writer, static_cast<std::uint32_t>(peer->remoteConfirmed + 1), 4);
+	putByte(&writer, static_cast<std::uint8_t>(count));
+	for (long frame = start; frame < start + count; frame++)
+	{
+		PlayerInputZip zip = peer->localInputs[frame % PEER_RING];
+		putByte(&writer, static_cast<std::uint8_t>(zip.movAtk));
+		putInt(&writer, static_cast<std::uint32_t>(zip.mouseRaw), 4);
+	}
+	transportSend(&peer->transport, bytes, writer.size);
+	(peer->stats.packetsSent)++;
+}
+
+void receivePeerInputs(RollbackPeer* peer)
+{
+	std::uint8_t bytes[MAX_DATAGRAM_BYTES];
+	size_t size;
+	while ((size = transportReceive(&peer->transport, bytes, sizeof(bytes))) > 0)
+	{
+		SnapshotReader reader{ bytes, size };
+		if (getByte(&reader) != PEER_INPUT_PACKET) continue;
+		long start = static_cast<long>(getInt(&reader, 4));
+		long acked = static_cast<long>(getInt(&reader, 4)) - 1;
+		int count = getByte(&reader);
+		if (reader.underflow) continue;
+		(peer->stats.packetsReceived)++;
+		peer->localAcked = std::max(peer->localAcked, std::min(acked, peer->lastLocalInput));
+		for (long frame = start; frame < start + count; frame++)
+		{
+			PlayerInputZip zip;
+			zip.movAtk = static_cast<char>(getByte(&reader));
+			zip.mouseRaw = static_cast<std::int32_t>(getInt(&reader, 4));
+			if (reader.underflow) break;
+			//older ones are already in, newer ones can't be past a gap since packets always start at the first unacknowledged input
+			if (frame != peer->remoteConfirmed + 1) continue;
+			int index = frame % PEER_RING;
+			peer->remoteInputs[index] = zip;
+			peer->remoteConfirmed = frame;
+			bool simulated = frame < peer->state.frame;
+			if (simulated && !sameInput(peer->usedRemote[index], zip) &&
+				(peer->firstMispredicted < 0 || frame < peer->firstMispredicted))
+				peer->firstMispredicted = frame;
+		}
+	}
+}
+
+//back to the first wrong frame and forward again to where the peer was
+void rollbackPeer(RollbackPeer* peer)
+{
+	if (peer->firstMispredicted < 0) return;
+	long target = peer->state.frame;
+	long from = peer->firstMispredicted;
+	int index = from % PEER_RING;
+	decodeSnapshot(peer->saved[index], peer->savedSize[index], &peer->state);
+	while (peer->state.frame < target)
+	{
+		stepPeer(peer);
+	}
+	peer->firstMispredicted = -1;
+	(peer->stats.rollbacks)++;
+	peer->stats.resimulated += target - from;
+	peer->stats.worstRollback = std::max(peer->stats.worstRollback, target - from);
+}
+
+inline bool peerCanAdvance(const RollbackPeer* peer)
+{
+	return peer->state.frame - (peer->remoteConfirmed + 1) < PEER_MAX_PREDICTION;
+}
+
+//whether the next local input is due, it goes to frame lastLocalInput + 1
+//right after the delay goes up more than one is due, right after it goes down none is for a frame or more
+inline bool peerWantsLocalInput(const RollbackPeer* peer)
+{
+	return peer->lastLocalInput < peer->state.frame + peer->inputDelay;
+}
+
+inline void peerAddLocalInput(RollbackPeer* peer, const PlayerInput* local)
+{
+	long frame = peer->lastLocalInput + 1;
+	peer->localInputs[frame % PEER_RING] = zipInput(*local);
+	peer->lastLocalInput = frame;
+}
+
+//one tick of the peer's loop: take in what arrived, fix mispredictions, advance a frame with the local input if the
+//prediction window allows, and send inputs out
+//with input delay the local input goes to a later frame, and fills every frame that's due when the delay just went up
+//local can be NULL to only keep the connection going (e.g. once the local side is done); true if a frame was simulated
+bool peerTick(RollbackPeer* peer, const PlayerInput* local)
+{
+	receivePeerInputs(peer);
+	rollbackPeer(peer);
+	bool advanced = false;
+	if (local)
+	{
+		if (peerCanAdvance(peer))
+		{
+			while (peerWantsLocalInput(peer))
+			{
+				peerAddLocalInput(peer, local);
+			}
+			stepPeer(peer);
+			advanced = true;
+		}
+		else (peer->stats.stalls)++;
+	}
+	sendPeerInputs(peer);
+	return advanced;
+}
+
+//at frame and nothing left unconfirmed, so the state is final
+inline bool peerSettled(const RollbackPeer* peer, long frame)
+{
+	return peer->state.frame == frame && peer->remoteConfirmed >= frame - 1 && peer->firstMispredicted < 0;
+}
+
+#endif
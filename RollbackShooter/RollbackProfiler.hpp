@@ -0,0 +1,199 @@
+#ifndef RBST_ROLLBACKPROFILER_HPP
+#define RBST_ROLLBACKPROFILER_HPP
+
+//std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <string>
+//-----
+
+//where the time goes on the rollback path of a networked match, one sample per real frame
+//each quantity gets a histogram for the F4 overlay, and every frame is also written as a row of a per-match CSV
+//so a hitch can be found again afterwards by its frame number
+
+const int PROFILE_BINS = 16;
+
+//fixed width bins from the origin, anything outside lands in the first or last bin
+struct ProfileHistogram
+{
+	const char* name = "";
+	const char* unit = "";
+	double binWidth = 1;
+	double origin = 0;
+	long counts[PROFILE_BINS] = {};
+	long samples = 0;
+	double total = 0;
+	double totalSquares = 0;
+	double worst = 0;
+};
+
+void addSample(ProfileHistogram* hist, double value)
+{
+	int bin = std::min(PROFILE_BINS - 1, std::max(0, static_cast<int>((value - hist->origin) / hist->binWidth)));
+	(hist->counts[bin])++;
+	(hist->samples)++;
+	hist->total += value;
+	hist->totalSquares += value * value;
+	hist->worst = std::max(hist->worst, value);
+}
+
+inline double histogramMean(const ProfileHistogram* hist)
+{
+	return hist->samples > 0 ? hist->total / hist->samples : 0;
+}
+
+inline double histogramStdDev(const ProfileHistogram* hist)
+{
+	if (hist->samples == 0) return 0;
+	double mean = histogramMean(hist);
+	return sqrt(std::max(0.0, hist->totalSquares / hist->samples - mean * mean));
+}
+
+void clearHistogram(ProfileHistogram* hist)
+{
+	std::fill(hist->counts, hist->counts + PROFILE_BINS, 0);
+	hist->samples = 0;
+	hist->total = 0;
+	hist->totalSquares = 0;
+	hist->worst = 0;
+}
+
+using ProfileClock = std::chrono::steady_clock;
+
+struct RollbackProfiler
+{
+	//this frame so far
+	int resimulated = 0;
+	double idleMs = 0;
+	double advanceMs = 0;
+	double secSimMs = 0;
+	int confirmLag = 0;
+	//stays until changed
+	int inputDelay = 0;
+	//the last frame from start to start as it really came out, 0 when nothing measures it (headless sessions)
+	double frameMs = 0;
+	//how far behind its schedule the frame started
+	double tickLateMs = 0;
+	//how long the samples the frame's input was made of waited for it to start, negative when the input didn't change
+	double inputLatencyMs = -1;
+	//this side's lead on the other, as GGPO measures it
+	double framesAhead = 0;
+	//the whole match
+	ProfileHistogram resimHist{ "resimulated", "f", 1 };
+	ProfileHistogram idleHist{ "ggpo_idle", "ms", 0.5 };
+	ProfileHistogram advanceHist{ "advance", "ms", 0.25 };
+	ProfileHistogram secSimHist{ "rollbackSecSim", "ms", 0.05 };
+	ProfileHistogram lagHist{ "confirm lag", "f", 1 };
+	//only the frames that rolled back, since the input delay last changed
+	ProfileHistogram delayDepthHist{ "depth at this delay", "f", 1 };
+	//from 13.67ms, 60 FPS is the 7th bin and 50 FPS the 13th
+	ProfileHistogram frameHist{ "frame time", "ms", 0.5, 13.67 };
+	ProfileHistogram aheadHist{ "frames ahead", "f", 0.5 };
+	ProfileHistogram lateHist{ "tick late", "ms", 0.25 };
+	ProfileHistogram inputHist{ "input latency", "ms", 1 };
+	std::ofstream csv;
+};
+
+const int PROFILE_VIEW_HISTOGRAMS = 10;
+
+//the histograms as the overlay draws them, copied out so another thread can draw them while the profiler goes on
+struct ProfileView
+{
+	ProfileHistogram hists[PROFILE_VIEW_HISTOGRAMS];
+};
+
+void viewProfiler(const RollbackProfiler* profiler, ProfileView* view)
+{
+	const ProfileHistogram* hists[PROFILE_VIEW_HISTOGRAMS] = {
+		&profiler->resimHist,
+		&profiler->idleHist,
+		&profiler->advanceHist,
+		&profiler->secSimHist,
+		&profiler->lagHist,
+		&profiler->delayDepthHist,
+		&profiler->frameHist,
+		&profiler->aheadHist,
+		&profiler->lateHist,
+		&profiler->inputHist };
+	for (int i = 0; i < PROFILE_VIEW_HISTOGRAMS; i++)
+	{
+		view->hists[i] = *hists[i];
+	}
+}
+
+inline ProfileClock::time_point profileStart()
+{
+	return ProfileClock::now();
+}
+
+//adds the milliseconds since start onto an accumulator
+inline void profileStop(double* ms, ProfileClock::time_point start)
+{
+	*ms += std::chrono::duration<double, std::milli>(ProfileClock::now() - start).count();
+}
+
+void openProfiler(RollbackProfiler* profiler, const std::string& fileName)
+{
+	clearHistogram(&profiler->resimHist);
+	clearHistogram(&profiler->idleHist);
+	clearHistogram(&profiler->advanceHist);
+	clearHistogram(&profiler->secSimHist);
+	clearHistogram(&profiler->lagHist);
+	clearHistogram(&profiler->delayDepthHist);
+	clearHistogram(&profiler->frameHist);
+	clearHistogram(&profiler->aheadHist);
+	clearHistogram(&profiler->lateHist);
+	clearHistogram(&profiler->inputHist);
+	profiler->resimulated = 0;
+	profiler->idleMs = 0;
+	profiler->advanceMs = 0;
+	profiler->secSimMs = 0;
+	profiler->confirmLag = 0;
+	profiler->inputDelay = 0;
+	profiler->frameMs = 0;
+	profiler->framesAhead = 0;
+	profiler->tickLateMs = 0;
+	profiler->inputLatencyMs = -1;
+	profiler->csv.open(fileName.c_str(), std::fstream::out);
+	profiler->csv << "frame,resimulated,idle_ms,advance_ms,rollback_secsim_ms,confirm_lag_frames,input_delay,frame_ms,frames_ahead,tick_late_ms,input_latency_ms" << std::endl;
+}
+
+//call once per real frame after the rollback work, it files this frame's numbers and starts the next
+void endProfileFrame(RollbackProfiler* profiler, long frame)
+{
+	addSample(&profiler->resimHist, profiler->resimulated);
+	addSample(&profiler->idleHist, profiler->idleMs);
+	addSample(&profiler->advanceHist, profiler->advanceMs);
+	addSample(&profiler->secSimHist, profiler->secSimMs);
+	addSample(&profiler->lagHist, profiler->confirmLag);
+	if (profiler->resimulated > 0) addSample(&profiler->delayDepthHist, profiler->resimulated);
+	if (profiler->frameMs > 0)
+	{
+		addSample(&profiler->frameHist, profiler->frameMs);
+		addSample(&profiler->lateHist, profiler->tickLateMs);
+	}
+	addSample(&profiler->aheadHist, profiler->framesAhead);
+	if (profiler->inputLatencyMs >= 0) addSample(&profiler->inputHist, profiler->inputLatencyMs);
+	if (profiler->csv.is_open())
+	{
+		profiler->csv << frame << ',' << profiler->resimulated << ','
+			<< profiler->idleMs << ',' << profiler->advanceMs << ',' << profiler->secSimMs << ','
+			<< profiler->confirmLag << ',' << profiler->inputDelay << ','
+			<< profiler->frameMs << ',' << profiler->framesAhead << ',' << profiler->tickLateMs << ','
+			<< profiler->inputLatencyMs << '\n';
+	}
+	profiler->resimulated = 0;
+	profiler->idleMs = 0;
+	profiler->advanceMs = 0;
+	profiler->secSimMs = 0;
+	profiler->inputLatencyMs = -1;
+}
+
+void closeProfiler(RollbackProfiler* profiler)
+{
+	if (profiler->csv.is_open()) profiler->csv.close();
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef RBST_SAVESTATEPOOL_HPP
+#define RBST_SAVESTATEPOOL_HPP
+
+//std
+#include <algorithm>
+#include <cstdlib>
+//-----
+#include "GameState.hpp"
+#include "Snapshot.hpp"
+
+//GGPO asks for a saved state every frame and frees each one once it falls out of its window
+//GGPO keeps MAX_PREDICTION_FRAMES + 2 (8 + 2) saved states alive at most, the rest is slack
+const int SAVE_STATE_SLOTS = 16;
+
+//a save is a snapshot (Snapshot.hpp), so a slot only needs room for the biggest one, not a whole GameState
+//saves stay full snapshots rather than deltas against the frame before: GGPO loads whichever saved frame it rolls back
+//to and frees the oldest ones on its own, so a delta could be left with its base already freed, and loading one would
+//mean decoding a chain back to some keyframe on every rollback instead of one pass over a few hundred bytes
+//cache line aligned, so a slot never shares a line with its neighbour
+struct alignas(64) SaveStateSlot
+{
+	unsigned char bytes[MAX_SNAPSHOT_BYTES];
+};
+
+//every slot is allocated once up front, saving and freeing just moves an index on or off the free list
+//if GGPO ever holds more states than there are slots, saves fall back to malloc and get counted
+struct SaveStatePool
+{
+	SaveStateSlot slots[SAVE_STATE_SLOTS];
+	int freeSlots[SAVE_STATE_SLOTS];
+	int freeCount = 0;
+	int inUse = 0;
+	int peak = 0;
+	long saves = 0;
+	long fallbacks = 0;
+};
+
+void resetSaveStatePool(SaveStatePool* pool)
+{
+	//handed out lowest slot first
+	for (int i = 0; i < SAVE_STATE_SLOTS; i++)
+	{
+		pool->freeSlots[i] = SAVE_STATE_SLOTS - 1 - i;
+	}
+	pool->freeCount = SAVE_STATE_SLOTS;
+	pool->inUse = 0;
+	pool->peak = 0;
+	pool->saves = 0;
+	pool->fallbacks = 0;
+}
+
+inline bool saveStatePoolOwns(const SaveStatePool* pool, const void* buffer)
+{
+	const SaveStateSlot* slot = static_cast<const SaveStateSlot*>(buffer);
+	return slot >= pool->slots && slot < pool->slots + SAVE_STATE_SLOTS;
+}
+
+//room for MAX_SNAPSHOT_BYTES, NULL only if the pool is full and malloc fails too
+unsigned char* acquireSaveState(SaveStatePool* pool)
+{
+	unsigned char* buffer;
+	if (pool->freeCount > 0)
+	{
+		buffer = pool->slots[pool->freeSlots[--(pool->freeCount)]].bytes;
+	}
+	else
+	{
+		buffer = static_cast<unsigned char*>(malloc(MAX_SNAPSHOT_BYTES));
+		if (!buffer) return NULL;
+		(pool->fallbacks)++;
+	}
+	(pool->saves)++;
+	(pool->inUse)++;
+	pool->peak = std::max(pool->peak, pool->inUse);
+	return buffer;
+}
+
+void releaseSaveState(SaveStatePool* pool, void* buffer)
+{
+	if (!buffer) return;
+	if (saveStatePoolOwns(pool, buffer))
+	{
+		int slot = static_cast<int>(static_cast<SaveStateSlot*>(buffer) - pool->slots);
+		pool->freeSlots[(pool->freeCount)++] = slot;
+	}
+	else free(buffer);
+	(pool->inUse)--;
+}
+
+#endif
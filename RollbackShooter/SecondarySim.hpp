@@ -6,27 +6,34 @@
 
 #include <iostream>
 //std
-#include <array>
-#include <map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <vector>
-//raylib
-#include <raylib.h>
 //-----
 #include "Math.hpp"
+#include "ParticlePool.hpp"
+#include "ProjectilePool.hpp"
 
-const float POSITION_FORGIVENESS = 0.5f;
+//every event simulate() leaves for the secondary sim carries who caused it: the frame of the action, its owner and a
+//sequence number telling apart the events one action causes; the same thing happening again after a rollback gets
+//the same id, so rollbackSecSim matches particles to events by id instead of by how close they are
+inline std::uint64_t eventId(long frame, std::uint8_t owner, std::uint16_t seq)
+{
+	return (static_cast<std::uint64_t>(frame & 0xffffffff) << 24) | (static_cast<std::uint64_t>(owner) << 16) | seq;
+}
 
 struct BasicFlux
 {
-	bool associated; Vec2 pos;
+	bool associated; Vec2 pos; std::uint64_t id;
 };
 struct SidedFlux
 {
-	bool associated; Vec2 pos; std::uint8_t owner;
+	bool associated; Vec2 pos; std::uint8_t owner; std::uint64_t id;
 };
 struct HitscanFlux
 {
-	bool associated; Vec2 pos; Vec2 dir; std::uint8_t owner;
+	bool associated; Vec2 pos; Vec2 dir; std::uint8_t owner; std::uint64_t id;
 };
 
 struct SecSimFlux
@@ -38,230 +45,276 @@ struct SecSimFlux
 	std::vector<HitscanFlux> hitscans;
 };
 
-using SecSimFluxHistory = std::map<long, SecSimFlux>;
-
-struct BasicParticle
+enum class FluxKind
 {
-	long frame; int lifetime; Vec2 pos;
+	Proj,
+	Combo,
+	Graze,
+	Alert,
+	Hitscan
 };
-struct SidedParticle
+
+//one event of the frames being rolled back over, found by kind and id
+struct FluxRef
 {
-	long frame; int lifetime; Vec2 pos; std::uint8_t owner;
+	std::uint64_t key = 0;
+	long frame = 0;
+	//NULL for an empty table slot
+	bool* associated = NULL;
+	const Vec2* pos = NULL;
+	//hitscans only
+	const Vec2* dir = NULL;
 };
-struct HitscanParticle
+
+//the flux of the last few frames, for rollbackSecSim to go back over, or for deriveSecSim to make every particle
+//still on screen from
+//a ring indexed by frame: GGPO never rolls back further than its prediction window (8 frames), but derived particles
+//need a whole particle lifetime of events, and every slot keeps the capacity of its vectors, so once a match is going
+//nothing here allocates
+const int FLUX_HISTORY_FRAMES = 64;
+static_assert(FLUX_HISTORY_FRAMES > PARTICLE_LIFETIME, "deriveSecSim needs every event a particle could still show");
+//rollbacks up to this deep, twice GGPO's window, fit in the event index without it growing
+const int FLUX_ROLLBACK_FRAMES = 16;
+//the most events of each kind simulate() can record in one frame, so no slot ever has to grow:
+//every projectile gone at once, either way; one alt shot per player, each a hitscan plus one more if it's parried;
+//a graze for everyone else on each of those shots; an alert per player
+const size_t FLUX_PROJ_RESERVE = MAX_PROJECTILES;
+const size_t FLUX_COMBO_RESERVE = MAX_PROJECTILES;
+const size_t FLUX_HITSCAN_RESERVE = 2 * MAX_PLAYERS;
+const size_t FLUX_GRAZE_RESERVE = MAX_PLAYERS * (MAX_PLAYERS - 1);
+const size_t FLUX_ALERT_RESERVE = MAX_PLAYERS;
+//events a rolled back frame usually adds to the index, busier rollbacks grow it
+const size_t FLUX_INDEX_FRAME_EVENTS = 32;
+
+struct SecSimFluxHistory
 {
-	long frame; int lifetime; Vec2 pos; Vec2 dir; std::uint8_t owner;
+	SecSimFlux slots[FLUX_HISTORY_FRAMES];
+	//the frame each slot holds
+	long frames[FLUX_HISTORY_FRAMES] = {};
+	//the newest frame recorded, -1 before any
+	long newest = -1;
+	//open addressing table of the events rolled back over, rebuilt by every rollbackSecSim
+	std::vector<FluxRef> index;
 };
-struct EffectParticle
+
+void clearFlux(SecSimFlux* flux)
 {
-	long frame; int lifetime; Vec2 pos; std::array<Vector4,10> subParts;
-};
+	flux->projs.clear();
+	flux->combos.clear();
+	flux->grazes.clear();
+	flux->alerts.clear();
+	flux->hitscans.clear();
+}
+
+//room for a busy frame up front, so recording one doesn't allocate
+void reserveFlux(SecSimFlux* flux)
+{
+	flux->projs.reserve(FLUX_PROJ_RESERVE);
+	flux->combos.reserve(FLUX_COMBO_RESERVE);
+	flux->grazes.reserve(FLUX_GRAZE_RESERVE);
+	flux->alerts.reserve(FLUX_ALERT_RESERVE);
+	flux->hitscans.reserve(FLUX_HITSCAN_RESERVE);
+}
+
+void resetFluxHistory(SecSimFluxHistory* fluxHist)
+{
+	for (int slot = 0; slot < FLUX_HISTORY_FRAMES; slot++)
+	{
+		clearFlux(&(fluxHist->slots[slot]));
+		reserveFlux(&(fluxHist->slots[slot]));
+		fluxHist->frames[slot] = -1;
+	}
+	fluxHist->newest = -1;
+	fluxHist->index.clear();
+	fluxHist->index.reserve(FLUX_INDEX_FRAME_EVENTS * FLUX_ROLLBACK_FRAMES);
+}
+
+//where the flux of that frame is, -1 if it isn't kept (never recorded, or too old)
+int historySlot(const SecSimFluxHistory* fluxHist, long frame)
+{
+	if (frame < 0 || frame > fluxHist->newest || frame <= fluxHist->newest - FLUX_HISTORY_FRAMES) return -1;
+	int slot = static_cast<int>(frame % FLUX_HISTORY_FRAMES);
+	return (fluxHist->frames[slot] == frame) ? slot : -1;
+}
+
+SecSimFlux* historyFlux(SecSimFluxHistory* fluxHist, long frame)
+{
+	int slot = historySlot(fluxHist, frame);
+	return (slot >= 0) ? &(fluxHist->slots[slot]) : NULL;
+}
+
+const SecSimFlux* historyFlux(const SecSimFluxHistory* fluxHist, long frame)
+{
+	int slot = historySlot(fluxHist, frame);
+	return (slot >= 0) ? &(fluxHist->slots[slot]) : NULL;
+}
+
+//an empty slot to simulate that frame into, in place of what it held (the same frame before a rollback, or an old one)
+SecSimFlux* recordFlux(SecSimFluxHistory* fluxHist, long frame)
+{
+	int slot = static_cast<int>(frame % FLUX_HISTORY_FRAMES);
+	SecSimFlux* flux = &(fluxHist->slots[slot]);
+	clearFlux(flux);
+	fluxHist->frames[slot] = frame;
+	fluxHist->newest = std::max(fluxHist->newest, frame);
+	return flux;
+}
+
+//ids are frame << 24 | owner << 16 | seq, the kind goes above them
+inline std::uint64_t fluxKey(FluxKind kind, std::uint64_t id)
+{
+	return (static_cast<std::uint64_t>(kind) << 56) ^ id;
+}
+
+inline size_t fluxKeySlot(std::uint64_t key, size_t size)
+{
+	//fibonacci hashing, the keys themselves are anything but spread out
+	return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (size - 1);
+}
+
+void indexFlux(SecSimFluxHistory* fluxHist, FluxKind kind, std::uint64_t id, long frame, bool* associated, const Vec2* pos, const Vec2* dir = NULL)
+{
+	size_t size = fluxHist->index.size();
+	FluxRef ref{ fluxKey(kind, id), frame, associated, pos, dir };
+	size_t slot = fluxKeySlot(ref.key, size);
+	while (fluxHist->index[slot].associated != NULL) slot = (slot + 1) & (size - 1);
+	fluxHist->index[slot] = ref;
+}
 
-std::array<Vector4, 10> createSubParts()
+//every event from firstFrame on, in a table at most half full
+void indexFluxHistory(SecSimFluxHistory* fluxHist, long firstFrame)
 {
-	std::array<Vector4, 10> subParts;
-	for (int i = 0; i < 10; i++)
+	size_t events = 0;
+	for (long frame = firstFrame; frame <= fluxHist->newest; frame++)
+	{
+		const SecSimFlux* flux = historyFlux(fluxHist, frame);
+		if (flux == NULL) continue;
+		events += flux->projs.size() + flux->combos.size() + flux->grazes.size() + flux->alerts.size() + flux->hitscans.size();
+	}
+	size_t size = 16;
+	while (size < 2 * events) size *= 2;
+	fluxHist->index.assign(size, FluxRef{});
+	for (long frame = firstFrame; frame <= fluxHist->newest; frame++)
+	{
+		SecSimFlux* flux = historyFlux(fluxHist, frame);
+		if (flux == NULL) continue;
+		for (SidedFlux& event : flux->projs) indexFlux(fluxHist, FluxKind::Proj, event.id, frame, &event.associated, &event.pos);
+		for (BasicFlux& event : flux->combos) indexFlux(fluxHist, FluxKind::Combo, event.id, frame, &event.associated, &event.pos);
+		for (BasicFlux& event : flux->grazes) indexFlux(fluxHist, FluxKind::Graze, event.id, frame, &event.associated, &event.pos);
+		for (BasicFlux& event : flux->alerts) indexFlux(fluxHist, FluxKind::Alert, event.id, frame, &event.associated, &event.pos);
+		for (HitscanFlux& event : flux->hitscans) indexFlux(fluxHist, FluxKind::Hitscan, event.id, frame, &event.associated, &event.pos, &event.dir);
+	}
+}
+
+//the first event of that kind and id no particle has taken yet, NULL if there's none
+FluxRef* findFlux(SecSimFluxHistory* fluxHist, FluxKind kind, std::uint64_t id)
+{
+	std::uint64_t key = fluxKey(kind, id);
+	size_t size = fluxHist->index.size();
+	for (size_t slot = fluxKeySlot(key, size); fluxHist->index[slot].associated != NULL; slot = (slot + 1) & (size - 1))
+	{
+		FluxRef* ref = &(fluxHist->index[slot]);
+		if (ref->key == key && !*(ref->associated)) return ref;
+	}
+	return NULL;
+}
+
+//fills one effect's worth of sub particles
+void createSubParts(Vector4* subParts)
+{
+	for (int i = 0; i < SUB_PARTS; i++)
 	{
 		float angle = GetRandomValue(0, 359);
 		float height = GetRandomValue(5, 15) / 20.0f;
 		float size = GetRandomValue(8, 12) / 10.0f;
 		subParts[i] = Vector4{
-			cos(angle),sin(angle),height,size
+			static_cast<float>(cos(angle)),static_cast<float>(sin(angle)),height,size
 		};
 	}
-	return subParts;
 }
 
 struct SecSimParticles
 {
-	std::vector<SidedParticle> projs;
-	std::vector<BasicParticle> combos;
-	std::vector<EffectParticle> grazes;
-	std::vector<EffectParticle> alerts;
-	std::vector<HitscanParticle> hitscans;
+	ParticlePool projs;
+	ParticlePool combos;
+	ParticlePool grazes;
+	ParticlePool alerts;
+	ParticlePool hitscans;
+	//the grazes' and alerts'
+	SubPartPool subParts;
 };
 
-void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currFrame);
+void clearSecSim(SecSimParticles* particles)
+{
+	clearParticles(&particles->projs);
+	clearParticles(&particles->combos);
+	clearParticles(&particles->grazes);
+	clearParticles(&particles->alerts);
+	clearParticles(&particles->hitscans);
+	clearSubParts(&particles->subParts);
+}
 
-//Call this after the last frame of a rollback, but not after simulating the current frame
-void rollbackSecSim(SecSimFluxHistory* fluxHist, SecSimParticles* particles, long rollbackFrame)
+//what's alive and nothing else
+void copySecSim(SecSimParticles* dst, const SecSimParticles* src)
 {
-	//Compare particles to flux
-	//PROJECTILE COLLISIONS
-	//can have slight variations in frame and position if collided with player
-	for (int it = 0; it < particles->projs.size();)
-	{
-		//particle is within flux
-		if (particles->projs.at(it).frame > rollbackFrame)
-		{
-			bool exists = false;
-			std::vector<SidedFlux>::iterator fluxIt;
-			//check frames from history
-			for (auto histIt = fluxHist->begin(); histIt != fluxHist->end(); histIt++)
-			{
-				//only the ones within flux
-				if (histIt->first <= rollbackFrame) continue;
-				fluxIt = histIt->second.projs.begin();
-				for (; fluxIt != histIt->second.projs.end(); fluxIt++)
-				{
-					//don't compare with an already associated flux
-					if (fluxIt->associated) continue;
-					exists = (fpm::abs(particles->projs.at(it).pos.x - fluxIt->pos.x) + fpm::abs(particles->projs.at(it).pos.y - fluxIt->pos.y)) < num_det{ POSITION_FORGIVENESS };
-					if (exists)
-					{
-						fluxIt->associated = true;
-						particles->projs.at(it).pos = fluxIt->pos;
-						particles->projs.at(it).frame = histIt->first;
-						break;
-					}
-				}
-				//break out of wider loop
-				if (exists) break;
-			}
-			if (!exists)
-			{
-				particles->projs.erase(particles->projs.begin() + it);
-				continue;
-			}
-		}
+	copyParticles(&dst->projs, &src->projs);
+	copyParticles(&dst->combos, &src->combos);
+	copyParticles(&dst->grazes, &src->grazes);
+	copyParticles(&dst->alerts, &src->alerts);
+	copyParticles(&dst->hitscans, &src->hitscans);
+	copySubParts(&dst->subParts, &src->subParts);
+}
 
-		it++;
-	}
-	//COMBOS
-	//if it did not happen in that frame at that position, it did not happen
-	for (int it = 0; it < particles->combos.size();)
-	{
-		//particle is within flux
-		if (particles->combos.at(it).frame > rollbackFrame)
-		{
-			bool exists = false;
-			auto fluxIt = fluxHist->at(particles->combos.at(it).frame).combos.begin();
-			for (; fluxIt != fluxHist->at(particles->combos.at(it).frame).combos.end(); fluxIt++)
-			{
-				//don't compare with an already associated flux
-				if (fluxIt->associated) continue;
-				exists = v2::equal(particles->combos.at(it).pos, fluxIt->pos);
-				if (exists)
-				{
-					fluxIt->associated = true;
-					break;
-				}
-			}
-			if (!exists)
-			{
-				particles->combos.erase(particles->combos.begin() + it);
-				continue;
-			}
-		}
+inline long particleCount(const SecSimParticles* particles)
+{
+	return particles->projs.count + particles->combos.count + particles->grazes.count + particles->alerts.count + particles->hitscans.count;
+}
 
-		it++;
-	}
-	//GRAZES
-	//if it did not happen in that frame and NEAR that position, it did not happen
-	for (int it = 0; it < particles->grazes.size();)
-	{
-		//particle is within flux
-		if (particles->grazes.at(it).frame > rollbackFrame)
-		{
-			long exactFrame = particles->grazes.at(it).frame;
-			bool exists = false;
-			auto fluxIt = fluxHist->at(exactFrame).grazes.begin();
-			for (; fluxIt != fluxHist->at(exactFrame).grazes.end(); fluxIt++)
-			{
-				//don't compare with an already associated flux
-				if (fluxIt->associated) continue;
-				exists = (fpm::abs(particles->grazes.at(it).pos.x - fluxIt->pos.x) + fpm::abs(particles->grazes.at(it).pos.y - fluxIt->pos.y)) < num_det{ POSITION_FORGIVENESS };
-				if (exists)
-				{
-					fluxIt->associated = true;
-					particles->grazes.at(it).pos = fluxIt->pos;
-					break;
-				}
-			}
-			if (!exists)
-			{
-				particles->grazes.erase(particles->grazes.begin() + it);
-				continue;
-			}
-		}
+void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currFrame);
 
-		it++;
-	}
-	//ALERTS
-	//can have slight variations in frame and position depending on when player inputted
-	for (int it = 0; it < particles->alerts.size();)
+//the particles of one kind from the frames rolled back over, against the index of their events
+void reconcileParticles(SecSimFluxHistory* fluxHist, ParticlePool* pool, SubPartPool* subs, FluxKind kind, long rollbackFrame)
+{
+	for (int i = 0; i < pool->count;)
 	{
 		//particle is within flux
-		if (particles->alerts.at(it).frame > rollbackFrame)
+		if (pool->frame[i] > rollbackFrame)
 		{
-			bool exists = false;
-			std::vector<BasicFlux>::iterator fluxIt;
-			//check frames from history
-			for (auto histIt = fluxHist->begin(); histIt != fluxHist->end(); histIt++)
+			FluxRef* ref = findFlux(fluxHist, kind, pool->id[i]);
+			if (ref == NULL)
 			{
-				//only the ones within flux
-				if (histIt->first <= rollbackFrame) continue;
-				fluxIt = histIt->second.alerts.begin();
-				for (; fluxIt != histIt->second.alerts.end(); fluxIt++)
-				{
-					//don't compare with an already associated flux
-					if (fluxIt->associated) continue;
-					exists = (fpm::abs(particles->alerts.at(it).pos.x - fluxIt->pos.x) + fpm::abs(particles->alerts.at(it).pos.y - fluxIt->pos.y)) < num_det{ POSITION_FORGIVENESS };
-					if (exists)
-					{
-						fluxIt->associated = true;
-						particles->alerts.at(it).pos = fluxIt->pos;
-						particles->alerts.at(it).frame = histIt->first;
-						break;
-					}
-				}
-				//break out of wider loop
-				if (exists) break;
-			}
-			if (!exists)
-			{
-				particles->alerts.erase(particles->alerts.begin() + it);
+				removeParticle(pool, subs, i);
 				continue;
 			}
+			*(ref->associated) = true;
+			pool->frame[i] = ref->frame;
+			pool->pos[i] = *(ref->pos);
+			if (ref->dir != NULL) pool->dir[i] = *(ref->dir);
 		}
-
-		it++;
+		i++;
 	}
-	//HITSCANS
-	//if it did not happen in that frame at that position, it did not happen
-	for (int it = 0; it < particles->hitscans.size();)
-	{
-		//particle is within flux
-		if (particles->hitscans.at(it).frame > rollbackFrame)
-		{
-			bool exists = false;
-			auto fluxIt = fluxHist->at(particles->hitscans.at(it).frame).hitscans.begin();
-			for (; fluxIt != fluxHist->at(particles->hitscans.at(it).frame).hitscans.end(); fluxIt++)
-			{
-				//don't compare with an already associated flux
-				if (fluxIt->associated) continue;
-				exists = v2::equal(particles->hitscans.at(it).pos, fluxIt->pos);
-				if (exists)
-				{
-					fluxIt->associated = true;
-					break;
-				}
-			}
-			if (!exists)
-			{
-				particles->hitscans.erase(particles->hitscans.begin() + it);
-				continue;
-			}
-		}
+}
 
-		it++;
-	}
+//Call this after the last frame of a rollback, but not after simulating the current frame
+//a particle from the frames rolled back over stays if its event happened again (moved to where and when it did this
+//time), and goes if it didn't; events no particle took get new ones
+void rollbackSecSim(SecSimFluxHistory* fluxHist, SecSimParticles* particles, long rollbackFrame)
+{
+	//only the frames that were rolled back over are looked at
+	long firstFrame = std::max(rollbackFrame + 1, fluxHist->newest - FLUX_HISTORY_FRAMES + 1);
+	indexFluxHistory(fluxHist, firstFrame);
+
+	reconcileParticles(fluxHist, &particles->projs, &particles->subParts, FluxKind::Proj, rollbackFrame);
+	reconcileParticles(fluxHist, &particles->combos, &particles->subParts, FluxKind::Combo, rollbackFrame);
+	reconcileParticles(fluxHist, &particles->grazes, &particles->subParts, FluxKind::Graze, rollbackFrame);
+	reconcileParticles(fluxHist, &particles->alerts, &particles->subParts, FluxKind::Alert, rollbackFrame);
+	reconcileParticles(fluxHist, &particles->hitscans, &particles->subParts, FluxKind::Hitscan, rollbackFrame);
 
 	//Add particles of non-associated flux
-	for (auto it = fluxHist->begin(); it != fluxHist->end(); it++)
+	for (long frame = firstFrame; frame <= fluxHist->newest; frame++)
 	{
-		if (it->first <= rollbackFrame) continue;
-		currentFrameSecSim(&it->second, particles, it->first);
+		SecSimFlux* flux = historyFlux(fluxHist, frame);
+		if (flux != NULL) currentFrameSecSim(flux, particles, frame);
 	}
 }
 
@@ -269,47 +322,26 @@ void rollbackSecSim(SecSimFluxHistory* fluxHist, SecSimParticles* particles, lon
 //also this function is necessary for demo playback
 void increaseParticleLifetime(SecSimParticles* particles)
 {
-	//in case you're thinking iterating like this is weird C++ forced my hand (aka things go wrong and I don't know why)
-	for (int it = 0; it < particles->projs.size();)
-	{
-		particles->projs.at(it).lifetime++;
-		if (particles->projs.at(it).lifetime > 60)
-			particles->projs.erase(particles->projs.begin() + it);
-		else
-			it++;
-	}
-	for (int it = 0; it < particles->combos.size();)
-	{
-		particles->combos.at(it).lifetime++;
-		if (particles->combos.at(it).lifetime > 60)
-			particles->combos.erase(particles->combos.begin() + it);
-		else
-			it++;
-	}
-	for (int it = 0; it < particles->grazes.size();)
-	{
-		particles->grazes.at(it).lifetime++;
-		if (particles->grazes.at(it).lifetime > 60)
-			particles->grazes.erase(particles->grazes.begin() + it);
-		else
-			it++;
-	}
-	for (int it = 0; it < particles->alerts.size();)
-	{
-		particles->alerts.at(it).lifetime++;
-		if (particles->alerts.at(it).lifetime > 60)
-			particles->alerts.erase(particles->alerts.begin() + it);
-		else
-			it++;
-	}
-	for (int it = 0; it < particles->hitscans.size();)
+	ageParticles(&particles->projs, &particles->subParts);
+	ageParticles(&particles->combos, &particles->subParts);
+	ageParticles(&particles->grazes, &particles->subParts);
+	ageParticles(&particles->alerts, &particles->subParts);
+	ageParticles(&particles->hitscans, &particles->subParts);
+}
+
+//a graze or an alert, with its sub particles; none if they're all taken
+void addEffect(ParticlePool* pool, SubPartPool* subs, long frame, Vec2 pos, std::uint64_t id)
+{
+	subslot sub = takeSubParts(subs);
+	if (sub == NO_SUB_PARTS) return;
+	int i = addParticle(pool, frame, pos, id);
+	if (i < 0)
 	{
-		particles->hitscans.at(it).lifetime++;
-		if (particles->hitscans.at(it).lifetime > 60)
-			particles->hitscans.erase(particles->hitscans.begin() + it);
-		else
-			it++;
+		giveSubParts(subs, sub);
+		return;
 	}
+	pool->sub[i] = sub;
+	createSubParts(subs->parts[sub]);
 }
 
 void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currFrame)
@@ -318,8 +350,8 @@ void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currF
 	{
 		if (!fluxIt->associated)
 		{
-			SidedParticle part = { currFrame, 0, fluxIt->pos, fluxIt->owner };
-			particles->projs.push_back(part);
+			int i = addParticle(&particles->projs, currFrame, fluxIt->pos, fluxIt->id);
+			if (i >= 0) particles->projs.owner[i] = fluxIt->owner;
 			fluxIt->associated = true;
 		}
 	}
@@ -327,8 +359,7 @@ void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currF
 	{
 		if (!fluxIt->associated)
 		{
-			BasicParticle part = { currFrame, 0, fluxIt->pos };
-			particles->combos.push_back(part);
+			addParticle(&particles->combos, currFrame, fluxIt->pos, fluxIt->id);
 			fluxIt->associated = true;
 		}
 	}
@@ -336,8 +367,7 @@ void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currF
 	{
 		if (!fluxIt->associated)
 		{
-			EffectParticle part = { currFrame, 0, fluxIt->pos, createSubParts() };
-			particles->grazes.push_back(part);
+			addEffect(&particles->grazes, &particles->subParts, currFrame, fluxIt->pos, fluxIt->id);
 			fluxIt->associated = true;
 		}
 	}
@@ -345,8 +375,7 @@ void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currF
 	{
 		if (!fluxIt->associated)
 		{
-			EffectParticle part = { currFrame, 0, fluxIt->pos, createSubParts() };
-			particles->alerts.push_back(part);
+			addEffect(&particles->alerts, &particles->subParts, currFrame, fluxIt->pos, fluxIt->id);
 			fluxIt->associated = true;
 		}
 	}
@@ -354,11 +383,105 @@ void currentFrameSecSim(SecSimFlux* flux, SecSimParticles* particles, long currF
 	{
 		if (!fluxIt->associated)
 		{
-			HitscanParticle part = { currFrame, 0, fluxIt->pos, fluxIt->dir, fluxIt->owner };
-			particles->hitscans.push_back(part);
+			int i = addParticle(&particles->hitscans, currFrame, fluxIt->pos, fluxIt->id);
+			if (i >= 0)
+			{
+				particles->hitscans.owner[i] = fluxIt->owner;
+				particles->hitscans.dir[i] = fluxIt->dir;
+			}
 			fluxIt->associated = true;
 		}
 	}
 }
 
-#endif
\ No newline at end of file
+//STATELESS PARTICLES
+//the other way to do the secondary sim: no particles are kept from frame to frame, every one on screen is made again
+//for each frame drawn from the events of the last PARTICLE_LIFETIME frames of the history, confirmed or predicted,
+//and how long ago they happened
+//a rollback only rewrites the history, there's nothing to reconcile, so how deep it goes costs the effects nothing;
+//what it costs instead is going over every event still on screen once a frame, however few rollbacks there are
+
+enum class ParticleMode
+{
+	//particles kept, fixed by rollbackSecSim after every rollback
+	Reconcile,
+	//particles made from the history by deriveSecSim
+	Derive
+};
+
+//splitmix64 steps, so an effect gets the same sub particles every time it's made from the same event
+inline std::uint64_t nextEventRandom(std::uint64_t* state)
+{
+	std::uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+//createSubParts, from the event's id instead of GetRandomValue
+void eventSubParts(std::uint64_t id, Vector4* subParts)
+{
+	std::uint64_t state = id;
+	for (int i = 0; i < SUB_PARTS; i++)
+	{
+		float angle = static_cast<float>(nextEventRandom(&state) % 360);
+		float height = (5 + nextEventRandom(&state) % 11) / 20.0f;
+		float size = (8 + nextEventRandom(&state) % 5) / 10.0f;
+		subParts[i] = Vector4{
+			std::cos(angle),std::sin(angle),height,size
+		};
+	}
+}
+
+//addEffect, sub particles from the id
+void deriveEffect(ParticlePool* pool, SubPartPool* subs, long frame, int lifetime, Vec2 pos, std::uint64_t id)
+{
+	subslot sub = takeSubParts(subs);
+	if (sub == NO_SUB_PARTS) return;
+	int i = addParticle(pool, frame, pos, id);
+	if (i < 0)
+	{
+		giveSubParts(subs, sub);
+		return;
+	}
+	pool->lifetime[i] = lifetime;
+	pool->sub[i] = sub;
+	eventSubParts(id, subs->parts[sub]);
+}
+
+//every particle that shows on currFrame, as increaseParticleLifetime and currentFrameSecSim would have left them
+//without a rollback; whatever particles held before is gone
+void deriveSecSim(const SecSimFluxHistory* fluxHist, SecSimParticles* particles, long currFrame)
+{
+	clearSecSim(particles);
+	for (long frame = std::max(0L, currFrame - PARTICLE_LIFETIME); frame <= currFrame; frame++)
+	{
+		const SecSimFlux* flux = historyFlux(fluxHist, frame);
+		if (flux == NULL) continue;
+		int lifetime = static_cast<int>(currFrame - frame);
+		for (const SidedFlux& event : flux->projs)
+		{
+			int i = addParticle(&particles->projs, frame, event.pos, event.id);
+			if (i < 0) continue;
+			particles->projs.lifetime[i] = lifetime;
+			particles->projs.owner[i] = event.owner;
+		}
+		for (const BasicFlux& event : flux->combos)
+		{
+			int i = addParticle(&particles->combos, frame, event.pos, event.id);
+			if (i >= 0) particles->combos.lifetime[i] = lifetime;
+		}
+		for (const BasicFlux& event : flux->grazes) deriveEffect(&particles->grazes, &particles->subParts, frame, lifetime, event.pos, event.id);
+		for (const BasicFlux& event : flux->alerts) deriveEffect(&particles->alerts, &particles->subParts, frame, lifetime, event.pos, event.id);
+		for (const HitscanFlux& event : flux->hitscans)
+		{
+			int i = addParticle(&particles->hitscans, frame, event.pos, event.id);
+			if (i < 0) continue;
+			particles->hitscans.lifetime[i] = lifetime;
+			particles->hitscans.owner[i] = event.owner;
+			particles->hitscans.dir[i] = event.dir;
+		}
+	}
+}
+
+#endif
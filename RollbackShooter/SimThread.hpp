@@ -0,0 +1,236 @@
+#ifndef RBST_SIMTHREAD_HPP
+#define RBST_SIMTHREAD_HPP
+
+//std
+#include <atomic>
+#include <chrono>
+#include <thread>
+//-----
+#include "Input.hpp"
+
+//what it takes to run the simulation and the netcode on their own thread at a fixed 60Hz, away from the render thread:
+//a triple buffer to hand finished frames to the renderer, a clock for the ticks, and a queue for the inputs the
+//renderer samples
+
+//TRIPLE BUFFER
+
+//three slots of whatever the frames are, kept by the owner; the writer always has one to fill, the reader always has
+//one to look at, and the newest finished frame waits in the third, so neither side ever waits on the other
+//a frame the reader holds doesn't change until it asks for a newer one
+const int TRIPLE_FRESH = 4;
+
+struct TripleBuffer
+{
+	//the slot with the newest published frame, TRIPLE_FRESH set until the reader takes it
+	std::atomic<int> middle{ 1 };
+	//only ever touched by the writer
+	int writing = 0;
+	//only ever touched by the reader
+	int reading = 2;
+};
+
+inline int tripleWriteSlot(const TripleBuffer* buffer)
+{
+	return buffer->writing;
+}
+
+inline int tripleReadSlot(const TripleBuffer* buffer)
+{
+	return buffer->reading;
+}
+
+//the writer's slot is done, it becomes the newest and the writer moves on to the one it replaced
+void triplePublish(TripleBuffer* buffer)
+{
+	int old = buffer->middle.exchange(buffer->writing | TRIPLE_FRESH, std::memory_order_acq_rel);
+	buffer->writing = old & (TRIPLE_FRESH - 1);
+}
+
+//swaps the reader's slot for the newest frame, false if nothing was published since the last time
+bool tripleRead(TripleBuffer* buffer)
+{
+	if ((buffer->middle.load(std::memory_order_relaxed) & TRIPLE_FRESH) == 0) return false;
+	int old = buffer->middle.exchange(buffer->reading, std::memory_order_acq_rel);
+	buffer->reading = old & (TRIPLE_FRESH - 1);
+	return true;
+}
+
+//TICKS
+
+using SimClock = std::chrono::steady_clock;
+
+struct SimTicker
+{
+	SimClock::time_point due;
+	SimClock::time_point last;
+};
+
+//past this late the ticker gives up on catching up (a debugger break, the machine sleeping) and starts over from now
+const double TICKER_RESYNC_MS = 250;
+
+void startTicker(SimTicker* ticker)
+{
+	ticker->due = SimClock::now();
+	ticker->last = ticker->due;
+}
+
+//until the next tick is due, negative once it's late
+inline double tickerMsLeft(const SimTicker* ticker)
+{
+	return std::chrono::duration<double, std::milli>(ticker->due - SimClock::now()).count();
+}
+
+//sleeps the rest of the way, the last bit yielding instead since sleeps overshoot
+void tickerWait(const SimTicker* ticker)
+{
+	double left;
+	while ((left = tickerMsLeft(ticker)) > 0)
+	{
+		if (left > 1.5) std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(left - 1));
+		else std::this_thread::yield();
+	}
+}
+
+//the tick starts now: how late it is and how long since the last one started, then the next one is due frameMs after
+//this one was supposed to start, so a late tick doesn't push every tick after it back
+void tickerTick(SimTicker* ticker, double frameMs, double* lateMs, double* intervalMs)
+{
+	SimClock::time_point now = SimClock::now();
+	*lateMs = std::chrono::duration<double, std::milli>(now - ticker->due).count();
+	*intervalMs = std::chrono::duration<double, std::milli>(now - ticker->last).count();
+	ticker->last = now;
+	if (*lateMs > TICKER_RESYNC_MS) ticker->due = now;
+	ticker->due += std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double, std::milli>(frameMs));
+}
+
+//INPUT
+
+//only the thread that owns the window can poll (raylib, and GLFW under it), so that's the sampler: it polls every
+//millisecond, between the frames it draws too, and queues each poll with when it was taken
+//the sim thread drains the queue right before each tick and makes one PlayerInput out of it, so an input waits at
+//most a millisecond to be seen instead of up to a whole frame, and a press between two frames isn't lost to another
+const double INPUT_SAMPLE_MS = 1;
+//a bit over 4 ticks of samples
+const unsigned INPUT_QUEUE_SIZE = 256;
+
+struct InputSample
+{
+	SimClock::time_point at;
+	PolledInput input;
+};
+
+//lock-free, one thread pushes and one pops; the counters only grow and wrap, which the size being a power of 2 allows
+struct InputQueue
+{
+	InputSample samples[INPUT_QUEUE_SIZE];
+	//only stored by the consumer
+	std::atomic<unsigned> head{ 0 };
+	//only stored by the producer
+	std::atomic<unsigned> tail{ 0 };
+};
+
+bool pushSample(InputQueue* queue, const InputSample* sample)
+{
+	unsigned tail = queue->tail.load(std::memory_order_relaxed);
+	if (tail - queue->head.load(std::memory_order_acquire) == INPUT_QUEUE_SIZE) return false;
+	queue->samples[tail % INPUT_QUEUE_SIZE] = *sample;
+	queue->tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+bool popSample(InputQueue* queue, InputSample* sample)
+{
+	unsigned head = queue->head.load(std::memory_order_relaxed);
+	if (head == queue->tail.load(std::memory_order_acquire)) return false;
+	*sample = queue->samples[head % INPUT_QUEUE_SIZE];
+	queue->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+//the producer's side
+struct InputSampler
+{
+	//what didn't fit while the queue was full (the sim thread stuck), merged into until it does
+	InputSample held;
+	bool holding = false;
+};
+
+void queueSample(InputSampler* sampler, InputQueue* queue, PolledInput polled)
+{
+	InputSample sample{ SimClock::now(), polled };
+	if (sampler->holding)
+	{
+		//keeps the time of the oldest, that's how long it really waited
+		sampler->held.input.mov = polled.mov;
+		if (sampler->held.input.atk == None) sampler->held.input.atk = polled.atk;
+		sampler->held.input.mouse += polled.mouse;
+		sample = sampler->held;
+	}
+	sampler->holding = !pushSample(queue, &sample);
+	if (sampler->holding) sampler->held = sample;
+}
+
+//the consumer's side, what carries over from tick to tick
+struct InputCollector
+{
+	//the keys held, as of the last sample
+	MoveInput mov = Neutral;
+	//mouse movement finer than a num_det step, added to the next tick's
+	double mouseCarry = 0;
+	//a second attack pressed within one tick goes out on the next one instead of replacing the first
+	AttackInput carriedAtk = None;
+	SimClock::time_point carriedAt;
+	//samples taken in total, for the rate
+	long samples = 0;
+};
+
+//everything queued since the last tick as the input of the tick about to start
+//latencyMs is how long ago, on average, the samples that changed something were taken, negative if none did
+PlayerInput collectInput(InputCollector* collector, InputQueue* queue, double* latencyMs)
+{
+	SimClock::time_point now = SimClock::now();
+	double ageMs = 0;
+	int changed = 0;
+	PlayerInput input;
+	if (collector->carriedAtk != None)
+	{
+		input.atk = collector->carriedAtk;
+		ageMs += std::chrono::duration<double, std::milli>(now - collector->carriedAt).count();
+		changed++;
+		collector->carriedAtk = None;
+	}
+	double mouse = collector->mouseCarry;
+	InputSample sample;
+	while (popSample(queue, &sample))
+	{
+		(collector->samples)++;
+		bool counts = sample.input.mouse != 0 || sample.input.mov != collector->mov;
+		if (sample.input.atk != None)
+		{
+			if (input.atk == None)
+			{
+				input.atk = sample.input.atk;
+				counts = true;
+			}
+			else if (collector->carriedAtk == None)
+			{
+				collector->carriedAtk = sample.input.atk;
+				collector->carriedAt = sample.at;
+			}
+		}
+		if (counts)
+		{
+			ageMs += std::chrono::duration<double, std::milli>(now - sample.at).count();
+			changed++;
+		}
+		collector->mov = sample.input.mov;
+		mouse += sample.input.mouse;
+	}
+	input.mov = collector->mov;
+	input.mouse = num_det{ mouse };
+	collector->mouseCarry = mouse - static_cast<double>(input.mouse);
+	*latencyMs = (changed > 0) ? ageMs / changed : -1;
+	return input;
+}
+
+#endif
@@ -0,0 +1,334 @@
+#ifndef RBST_SNAPSHOT_HPP
+#define RBST_SNAPSHOT_HPP
+
+//std
+#include <cstddef>
+#include <cstdint>
+//-----
+#include "Math.hpp"
+#include "Input.hpp"
+#include "Player.hpp"
+#include "ProjectilePool.hpp"
+#include "GameState.hpp"
+
+//GameState as a compact byte string: every field at its own width in a fixed order, little endian,
+//players past playerCount and dead projectile slots left out, and a version tag up front
+//meant for anything that has to keep or send whole states: rollback saves, replay keyframes, resuming, spectators joining
+//a snapshot decodes into the same match, not the same bytes: projectiles come back in spawn order from slot 0,
+//keeping their spawn serials so their event ids don't change
+
+//bump whenever the layout below changes, old snapshots then fail to decode instead of decoding wrong
+const std::uint8_t SNAPSHOT_VERSION = 2;
+const std::uint8_t SNAPSHOT_MAGIC[2] = { 'R', 'S' };
+const std::uint8_t SNAPSHOT_DELTA_MAGIC[2] = { 'R', 'D' };
+
+const size_t SNAPSHOT_HEADER_BYTES = 3 + 4 + 2 + 1 + 1;
+const size_t SNAPSHOT_PLAYER_BYTES = 1 + 1 + 4 + 5 * 8 + 5 * 2 + 1 + 2 + 2 + 1;
+const size_t SNAPSHOT_PROJECTILE_BYTES = 4 * 4 + 1 + 2 + 2;
+const size_t MAX_SNAPSHOT_BYTES = SNAPSHOT_HEADER_BYTES +
+	MAX_PLAYERS * SNAPSHOT_PLAYER_BYTES +
+	2 + 2 + MAX_PROJECTILES * SNAPSHOT_PROJECTILE_BYTES;
+
+//writes stop counting once the buffer is full, so running out of room only has to be checked at the end
+struct SnapshotWriter
+{
+	std::uint8_t* bytes;
+	size_t capacity;
+	size_t size = 0;
+	bool overflow = false;
+};
+
+struct SnapshotReader
+{
+	const std::uint8_t* bytes;
+	size_t size;
+	size_t read = 0;
+	bool underflow = false;
+};
+
+inline void putByte(SnapshotWriter* writer, std::uint8_t value)
+{
+	if (writer->size >= writer->capacity)
+	{
+		writer->overflow = true;
+		return;
+	}
+	writer->bytes[(writer->size)++] = value;
+}
+
+inline void putInt(SnapshotWriter* writer, std::uint32_t value, int width)
+{
+	for (int i = 0; i < width; i++)
+	{
+		putByte(writer, static_cast<std::uint8_t>(value >> (8 * i)));
+	}
+}
+
+inline void putNum(SnapshotWriter* writer, num_det value)
+{
+	putInt(writer, static_cast<std::uint32_t>(value.raw_value()), 4);
+}
+
+inline void putVec(SnapshotWriter* writer, Vec2 value)
+{
+	putNum(writer, value.x);
+	putNum(writer, value.y);
+}
+
+inline std::uint8_t getByte(SnapshotReader* reader)
+{
+	if (reader->read >= reader->size)
+	{
+		reader->underflow = true;
+		return 0;
+	}
+	return reader->bytes[(reader->read)++];
+}
+
+inline std::uint32_t getInt(SnapshotReader* reader, int width)
+{
+	std::uint32_t value = 0;
+	for (int i = 0; i < width; i++)
+	{
+		value |= static_cast<std::uint32_t>(getByte(reader)) << (8 * i);
+	}
+	return value;
+}
+
+inline int16 getInt16(SnapshotReader* reader)
+{
+	return static_cast<int16>(static_cast<std::uint16_t>(getInt(reader, 2)));
+}
+
+inline num_det getNum(SnapshotReader* reader)
+{
+	return num_det::from_raw_value(static_cast<std::int32_t>(getInt(reader, 4)));
+}
+
+inline Vec2 getVec(SnapshotReader* reader)
+{
+	Vec2 value;
+	value.x = getNum(reader);
+	value.y = getNum(reader);
+	return value;
+}
+
+//pushdown goes bottom up, padded to its max size
+void putPlayer(SnapshotWriter* writer, const Player* player)
+{
+	etl::stack<PState, 4> pushdown = player->pushdown;
+	std::uint8_t states[4] = { 0 };
+	size_t depth = pushdown.size();
+	for (size_t i = depth; i > 0; i--)
+	{
+		states[i - 1] = static_cast<std::uint8_t>(pushdown.top());
+		pushdown.pop();
+	}
+	putByte(writer, player->id);
+	putByte(writer, static_cast<std::uint8_t>(depth));
+	for (int i = 0; i < 4; i++)
+	{
+		putByte(writer, states[i]);
+	}
+	putVec(writer, player->pos);
+	putVec(writer, player->vel);
+	putVec(writer, player->dir);
+	putVec(writer, player->perfectPos);
+	putVec(writer, player->dashVel);
+	putInt(writer, static_cast<std::uint16_t>(player->ammo), 2);
+	putInt(writer, static_cast<std::uint16_t>(player->chargeCount), 2);
+	putInt(writer, static_cast<std::uint16_t>(player->stamina), 2);
+	putInt(writer, static_cast<std::uint16_t>(player->dashCount), 2);
+	putInt(writer, static_cast<std::uint16_t>(player->hitstopCount), 2);
+	putByte(writer, player->stunned);
+}
+
+void getPlayer(SnapshotReader* reader, Player* player)
+{
+	player->id = getByte(reader);
+	size_t depth = getByte(reader);
+	std::uint8_t states[4];
+	for (int i = 0; i < 4; i++)
+	{
+		states[i] = getByte(reader);
+	}
+	if (depth > 4)
+	{
+		reader->underflow = true;
+		depth = 0;
+	}
+	player->pushdown.clear();
+	for (size_t i = 0; i < depth; i++)
+	{
+		player->pushdown.push(static_cast<PState>(states[i]));
+	}
+	player->pos = getVec(reader);
+	player->vel = getVec(reader);
+	player->dir = getVec(reader);
+	player->perfectPos = getVec(reader);
+	player->dashVel = getVec(reader);
+	player->ammo = getInt16(reader);
+	player->chargeCount = getInt16(reader);
+	player->stamina = getInt16(reader);
+	player->dashCount = getInt16(reader);
+	player->hitstopCount = getInt16(reader);
+	player->stunned = getByte(reader) != 0;
+}
+
+//snapshot size in bytes, or 0 if it didn't fit (MAX_SNAPSHOT_BYTES always does)
+size_t encodeSnapshot(const GameState* state, std::uint8_t* bytes, size_t capacity)
+{
+	SnapshotWriter writer{ bytes, capacity };
+	putByte(&writer, SNAPSHOT_MAGIC[0]);
+	putByte(&writer, SNAPSHOT_MAGIC[1]);
+	putByte(&writer, SNAPSHOT_VERSION);
+	putInt(&writer, static_cast<std::uint32_t>(state->frame), 4);
+	putInt(&writer, static_cast<std::uint16_t>(state->roundCountdown), 2);
+	putByte(&writer, static_cast<std::uint8_t>(state->phase));
+	putByte(&writer, static_cast<std::uint8_t>(state->playerCount));
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		putPlayer(&writer, &(state->players[i]));
+		putInt(&writer, static_cast<std::uint16_t>(state->health[i]), 2);
+		putInt(&writer, static_cast<std::uint16_t>(state->rounds[i]), 2);
+		putByte(&writer, state->dmgThisFrame[i]);
+	}
+	putInt(&writer, static_cast<std::uint32_t>(projectileCount(&state->projs)), 2);
+	putInt(&writer, state->projs.spawned, 2);
+	for (projslot slot = firstProjectile(&state->projs); slot != NO_PROJECTILE; slot = nextProjectile(&state->projs, slot))
+	{
+		putVec(&writer, projectilePos(&state->projs, slot));
+		putVec(&writer, projectileVel(&state->projs, slot));
+		putByte(&writer, state->projs.owner[slot]);
+		putInt(&writer, static_cast<std::uint16_t>(state->projs.lifetime[slot]), 2);
+		putInt(&writer, state->projs.serial[slot], 2);
+	}
+	return writer.overflow ? 0 : writer.size;
+}
+
+//false on a wrong tag, another version or a cut short snapshot, and the state is then left unusable
+bool decodeSnapshot(const std::uint8_t* bytes, size_t size, GameState* state)
+{
+	SnapshotReader reader{ bytes, size };
+	if (getByte(&reader) != SNAPSHOT_MAGIC[0] || getByte(&reader) != SNAPSHOT_MAGIC[1]) return false;
+	if (getByte(&reader) != SNAPSHOT_VERSION) return false;
+	*state = GameState{};
+	state->frame = static_cast<std::int32_t>(getInt(&reader, 4));
+	state->roundCountdown = getInt16(&reader);
+	state->phase = static_cast<RoundPhase>(getByte(&reader));
+	state->playerCount = static_cast<int8>(getByte(&reader));
+	if (state->playerCount < 2 || state->playerCount > MAX_PLAYERS) return false;
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		getPlayer(&reader, &(state->players[i]));
+		state->health[i] = getInt16(&reader);
+		state->rounds[i] = getInt16(&reader);
+		state->dmgThisFrame[i] = getByte(&reader) != 0;
+	}
+	size_t count = getInt(&reader, 2);
+	if (count > MAX_PROJECTILES) return false;
+	std::uint16_t spawned = static_cast<std::uint16_t>(getInt(&reader, 2));
+	for (size_t i = 0; i < count; i++)
+	{
+		Projectile proj;
+		proj.pos = getVec(&reader);
+		proj.vel = getVec(&reader);
+		proj.owner = getByte(&reader);
+		proj.lifetime = getInt16(&reader);
+		ProjectileHandle handle = spawnProjectile(&state->projs, proj);
+		state->projs.serial[handle.slot] = static_cast<std::uint16_t>(getInt(&reader, 2));
+	}
+	state->projs.spawned = spawned;
+	return !reader.underflow && reader.read == size;
+}
+
+//deltas: the snapshot XORed byte by byte against an earlier one (missing base bytes count as 0),
+//then stored as alternating runs: how many bytes are unchanged, how many changed, and the changed bytes
+//consecutive frames mostly differ in positions and timers, so most of a delta is short zero runs
+//run lengths are LEB128 varints
+
+inline void putVarint(SnapshotWriter* writer, size_t value)
+{
+	while (value >= 0x80)
+	{
+		putByte(writer, static_cast<std::uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	putByte(writer, static_cast<std::uint8_t>(value));
+}
+
+inline size_t getVarint(SnapshotReader* reader)
+{
+	size_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		std::uint8_t byte = getByte(reader);
+		value |= static_cast<size_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) return value;
+	}
+	reader->underflow = true;
+	return 0;
+}
+
+inline std::uint8_t baseByte(const std::uint8_t* base, size_t baseSize, size_t i)
+{
+	return i < baseSize ? base[i] : 0;
+}
+
+//delta size in bytes, or 0 if it didn't fit (MAX_SNAPSHOT_BYTES * 2 always does)
+size_t encodeSnapshotDelta(const std::uint8_t* base, size_t baseSize,
+	const std::uint8_t* snapshot, size_t size,
+	std::uint8_t* bytes, size_t capacity)
+{
+	SnapshotWriter writer{ bytes, capacity };
+	putByte(&writer, SNAPSHOT_DELTA_MAGIC[0]);
+	putByte(&writer, SNAPSHOT_DELTA_MAGIC[1]);
+	putByte(&writer, SNAPSHOT_VERSION);
+	putVarint(&writer, size);
+	size_t i = 0;
+	while (i < size)
+	{
+		size_t same = i;
+		while (same < size && snapshot[same] == baseByte(base, baseSize, same)) same++;
+		size_t changed = same;
+		while (changed < size && snapshot[changed] != baseByte(base, baseSize, changed)) changed++;
+		putVarint(&writer, same - i);
+		putVarint(&writer, changed - same);
+		for (size_t c = same; c < changed; c++)
+		{
+			putByte(&writer, snapshot[c] ^ baseByte(base, baseSize, c));
+		}
+		i = changed;
+	}
+	return writer.overflow ? 0 : writer.size;
+}
+
+//rebuilds the full snapshot from the one the delta was made against, size in bytes or 0 when it doesn't apply
+size_t decodeSnapshotDelta(const std::uint8_t* base, size_t baseSize,
+	const std::uint8_t* delta, size_t deltaSize,
+	std::uint8_t* bytes, size_t capacity)
+{
+	SnapshotReader reader{ delta, deltaSize };
+	if (getByte(&reader) != SNAPSHOT_DELTA_MAGIC[0] || getByte(&reader) != SNAPSHOT_DELTA_MAGIC[1]) return 0;
+	if (getByte(&reader) != SNAPSHOT_VERSION) return 0;
+	size_t size = getVarint(&reader);
+	if (size > capacity) return 0;
+	size_t i = 0;
+	while (i < size && !reader.underflow)
+	{
+		size_t same = getVarint(&reader);
+		size_t changed = getVarint(&reader);
+		if (i + same + changed > size) return 0;
+		for (size_t c = 0; c < same; c++, i++)
+		{
+			bytes[i] = baseByte(base, baseSize, i);
+		}
+		for (size_t c = 0; c < changed; c++, i++)
+		{
+			bytes[i] = getByte(&reader) ^ baseByte(base, baseSize, i);
+		}
+	}
+	return (!reader.underflow && reader.read == deltaSize) ? size : 0;
+}
+
+#endif
@@ -0,0 +1,422 @@
+#ifndef RBST_SPECTATORRELAY_HPP
+#define RBST_SPECTATORRELAY_HPP
+
+//std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+//-----
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "Snapshot.hpp"
+#include "Transport.hpp"
+#include "UdpSocket.hpp"
+
+//watching a match without being one more GGPO connection
+//a player's session hands every confirmed input (the ones going into its replay file) to a relay,
+//and the relay sends them on to any number of spectators over one UDP socket
+//spectators only ever get confirmed inputs, so they simulate straight ahead with no rollback
+//frames go out in batches, encoded the way replay files are, and the ones a spectator doesn't acknowledge go again
+//a spectator joining late gets the whole match from frame 0 and catches up
+
+const int RELAY_MAX_SPECTATORS = 1024;
+//frames gathered before a packet goes out, 4 frames is 15 packets a second per spectator
+const int RELAY_BATCH_FRAMES = 4;
+//unacknowledged frames go again after this long, and a batch that never filled up goes out anyway
+const double RELAY_RESEND_MS = 200;
+//spectators not heard from in this long are dropped
+const double RELAY_TIMEOUT_MS = 5000;
+//spectators say they're still there (and ask for the config until they get it) this often
+const double SPECTATOR_KEEPALIVE_MS = 250;
+//most frames a spectator's screen simulates at once while it catches up
+const long SPECTATOR_CATCHUP_FRAMES = 60;
+//every spectator acknowledges every packet, the relay's socket has to hold a tick's worth of that
+const int RELAY_SOCKET_BUFFER_BYTES = 1 << 20;
+
+const std::uint8_t RELAY_VERSION = 1;
+//spectator to relay: join (version), acknowledge (next frame needed), leave
+const std::uint8_t RELAY_JOIN = 'J';
+const std::uint8_t RELAY_ACK = 'A';
+const std::uint8_t RELAY_LEAVE = 'L';
+//relay to spectator: config (version, Config bytes as in a replay file), frames (start, count, inputs)
+const std::uint8_t RELAY_CONFIG = 'C';
+const std::uint8_t RELAY_FRAMES = 'F';
+const size_t RELAY_FRAMES_HEADER_BYTES = 1 + 4 + 1;
+
+static_assert(2 + sizeof(Config) <= MAX_DATAGRAM_BYTES, "the config has to fit a single datagram");
+
+//the clock relays and spectators go by when nothing else gives them one
+inline double relayNowMs()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct RelaySpectator
+{
+	UdpAddress address;
+	//the spectator has every frame before this one
+	long acked = 0;
+	//packets so far carried frames up to (not including) this one
+	long sentUpTo = 0;
+	double lastSendMs = 0;
+	double lastHeardMs = 0;
+	//when acked last moved, if it stays put for too long whatever is past it gets sent again
+	double ackedMs = 0;
+	//which frame of a batch this spectator's packets go out on, so the whole crowd isn't sent to
+	//(and doesn't answer) on the same tick
+	int phase = 0;
+};
+
+struct RelayStats
+{
+	long packetsSent = 0;
+	long bytesSent = 0;
+	long packetsReceived = 0;
+	long joins = 0;
+	long timeouts = 0;
+	long resends = 0;
+	//packets actually encoded, the rest were shared by spectators that were at the same frame
+	long encodes = 0;
+	int peakSpectators = 0;
+};
+
+struct SpectatorRelay
+{
+	UdpSocket socket;
+	Config cfg;
+	//every confirmed frame since the start, 16 bytes each
+	std::vector<PlayerInputZip> frames;
+	std::vector<RelaySpectator> spectators;
+	int batchFrames = RELAY_BATCH_FRAMES;
+	//the last packet encoded, spectators that are caught up all get these same bytes
+	long cachedStart = -1;
+	long cachedFrameCount = -1;
+	size_t cachedSize = 0;
+	std::uint8_t cached[MAX_DATAGRAM_BYTES];
+	RelayStats stats;
+};
+
+//false if the port can't be had
+bool openRelay(SpectatorRelay* relay, unsigned short port, const Config* cfg)
+{
+	relay->cfg = *cfg;
+	relay->frames.clear();
+	relay->spectators.clear();
+	relay->spectators.reserve(RELAY_MAX_SPECTATORS);
+	relay->cachedStart = -1;
+	relay->cachedFrameCount = -1;
+	relay->stats = RelayStats{};
+	return openUdpSocket(&relay->socket, port, RELAY_SOCKET_BUFFER_BYTES);
+}
+
+//spectators find out by timing out, there's no telling they got a leave message anyway
+void closeRelay(SpectatorRelay* relay)
+{
+	closeUdpSocket(&relay->socket);
+	relay->spectators.clear();
+	relay->frames.clear();
+}
+
+//confirmed frames have to come in order, starting from 0
+void relayConfirmedInput(SpectatorRelay* relay, long frame, InputData input)
+{
+	if (frame != static_cast<long>(relay->frames.size()) / 2) return;
+	relay->frames.push_back(zipInput(input.players[0]));
+	relay->frames.push_back(zipInput(input.players[1]));
+}
+
+//fits ReplayWriter::confirmed
+void relayConfirmedCallback(void* context, long frame, InputData input)
+{
+	relayConfirmedInput(static_cast<SpectatorRelay*>(context), frame, input);
+}
+
+inline long relayFrameCount(const SpectatorRelay* relay)
+{
+	return static_cast<long>(relay->frames.size()) / 2;
+}
+
+//a frames packet from start on, as many frames as fit; the first one is a keyframe so the packet reads on its own
+//returns the frame after the last one in it
+long encodeRelayFrames(SpectatorRelay* relay, long start)
+{
+	long frameCount = relayFrameCount(relay);
+	if (relay->cachedStart == start && relay->cachedFrameCount == frameCount)
+	{
+		return start + relay->cached[RELAY_FRAMES_HEADER_BYTES - 1];
+	}
+	SnapshotWriter writer{ relay->cached, sizeof(relay->cached) };
+	putByte(&writer, RELAY_FRAMES);
+	putInt(&writer, static_cast<std::uint32_t>(start), 4);
+	putByte(&writer, 0);
+	int32_t p1LastMouse = 0, p2LastMouse = 0;
+	long end = start;
+	while (end < frameCount && end - start < 255 && writer.size + REPLAY_INPUT_MAX_BYTES <= writer.capacity)
+	{
+		InputData input;
+		input.players[0] = unzipInput(relay->frames[2 * end]);
+		input.players[1] = unzipInput(relay->frames[2 * end + 1]);
+		char bytes[REPLAY_INPUT_MAX_BYTES];
+		size_t size = packReplayInput(input, &p1LastMouse, &p2LastMouse, bytes, end == start);
+		for (size_t i = 0; i < size; i++)
+		{
+			putByte(&writer, static_cast<std::uint8_t>(bytes[i]));
+		}
+		end++;
+	}
+	relay->cached[RELAY_FRAMES_HEADER_BYTES - 1] = static_cast<std::uint8_t>(end - start);
+	relay->cachedStart = start;
+	relay->cachedFrameCount = frameCount;
+	relay->cachedSize = writer.size;
+	(relay->stats.encodes)++;
+	return end;
+}
+
+void relaySend(SpectatorRelay* relay, UdpAddress to, const std::uint8_t* bytes, size_t size)
+{
+	udpSendTo(&relay->socket, to, bytes, size);
+	(relay->stats.packetsSent)++;
+	relay->stats.bytesSent += static_cast<long>(size);
+}
+
+RelaySpectator* findSpectator(SpectatorRelay* relay, UdpAddress address)
+{
+	for (RelaySpectator& spectator : relay->spectators)
+	{
+		if (sameAddress(spectator.address, address)) return &spectator;
+	}
+	return NULL;
+}
+
+void receiveRelayMessages(SpectatorRelay* relay, double nowMs)
+{
+	std::uint8_t bytes[MAX_DATAGRAM_BYTES];
+	UdpAddress from;
+	size_t size;
+	while ((size = udpReceiveFrom(&relay->socket, &from, bytes, sizeof(bytes))) > 0)
+	{
+		(relay->stats.packetsReceived)++;
+		SnapshotReader reader{ bytes, size };
+		std::uint8_t type = getByte(&reader);
+		RelaySpectator* spectator = findSpectator(relay, from);
+		if (type == RELAY_JOIN)
+		{
+			if (getByte(&reader) != RELAY_VERSION || reader.underflow) continue;
+			if (!spectator)
+			{
+				if (static_cast<int>(relay->spectators.size()) >= RELAY_MAX_SPECTATORS) continue;
+				RelaySpectator joined;
+				joined.address = from;
+				joined.lastSendMs = nowMs;
+				joined.ackedMs = nowMs;
+				joined.phase = static_cast<int>(relay->stats.joins % relay->batchFrames);
+				relay->spectators.push_back(joined);
+				spectator = &relay->spectators.back();
+				(relay->stats.joins)++;
+				relay->stats.peakSpectators = std::max(relay->stats.peakSpectators, static_cast<int>(relay->spectators.size()));
+			}
+			spectator->lastHeardMs = nowMs;
+			std::uint8_t reply[2 + sizeof(Config)];
+			reply[0] = RELAY_CONFIG;
+			reply[1] = RELAY_VERSION;
+			memcpy(reply + 2, &relay->cfg, sizeof(Config));
+			relaySend(relay, from, reply, sizeof(reply));
+		}
+		else if (type == RELAY_ACK && spectator)
+		{
+			long acked = static_cast<long>(getInt(&reader, 4));
+			if (reader.underflow) continue;
+			spectator->lastHeardMs = nowMs;
+			acked = std::min(acked, relayFrameCount(relay));
+			if (acked > spectator->acked)
+			{
+				spectator->acked = acked;
+				spectator->ackedMs = nowMs;
+				spectator->sentUpTo = std::max(spectator->sentUpTo, acked);
+			}
+		}
+		else if (type == RELAY_LEAVE && spectator)
+		{
+			*spectator = relay->spectators.back();
+			relay->spectators.pop_back();
+		}
+	}
+}
+
+//once per frame on the host: take in joins and acknowledgements, then send every spectator whatever's due
+void relayTick(SpectatorRelay* relay, double nowMs)
+{
+	receiveRelayMessages(relay, nowMs);
+	long frameCount = relayFrameCount(relay);
+	for (size_t i = 0; i < relay->spectators.size();)
+	{
+		RelaySpectator* spectator = &relay->spectators[i];
+		if (nowMs - spectator->lastHeardMs > RELAY_TIMEOUT_MS)
+		{
+			*spectator = relay->spectators.back();
+			relay->spectators.pop_back();
+			(relay->stats.timeouts)++;
+			continue;
+		}
+		//go back to the first frame the spectator is missing
+		if (spectator->acked < spectator->sentUpTo && nowMs - spectator->ackedMs >= RELAY_RESEND_MS)
+		{
+			spectator->sentUpTo = spectator->acked;
+			spectator->ackedMs = nowMs;
+			(relay->stats.resends)++;
+		}
+		long unsent = frameCount - spectator->sentUpTo;
+		bool batchDue = unsent >= relay->batchFrames && (frameCount % relay->batchFrames == spectator->phase || unsent >= 2 * relay->batchFrames);
+		if (batchDue || (unsent > 0 && nowMs - spectator->lastSendMs >= RELAY_RESEND_MS))
+		{
+			spectator->sentUpTo = encodeRelayFrames(relay, spectator->sentUpTo);
+			spectator->lastSendMs = nowMs;
+			relaySend(relay, spectator->address, relay->cached, relay->cachedSize);
+		}
+		i++;
+	}
+}
+
+//SPECTATOR SIDE
+
+struct SpectatorStats
+{
+	long packetsReceived = 0;
+	long bytesReceived = 0;
+	//frames that came again after already arriving
+	long duplicateFrames = 0;
+};
+
+struct SpectatorClient
+{
+	Transport transport;
+	Config cfg;
+	bool haveConfig = false;
+	GameState state;
+	SecSimFlux flux;
+	//frames in, from pendingRead on they're not simulated yet, pending[pendingRead] is state.frame
+	std::vector<InputData> pending;
+	size_t pendingRead = 0;
+	double lastKeepaliveMs = -SPECTATOR_KEEPALIVE_MS;
+	//last time anything came from the relay
+	double lastHeardMs = 0;
+	SpectatorStats stats;
+};
+
+void resetSpectator(SpectatorClient* client, Transport transport)
+{
+	client->transport = transport;
+	client->haveConfig = false;
+	client->state = GameState{};
+	client->flux = SecSimFlux{};
+	client->pending.clear();
+	client->pendingRead = 0;
+	client->lastKeepaliveMs = -SPECTATOR_KEEPALIVE_MS;
+	client->lastHeardMs = 0;
+	client->stats = SpectatorStats{};
+}
+
+//the next frame the spectator needs
+inline long spectatorNextFrame(const SpectatorClient* client)
+{
+	return client->state.frame + static_cast<long>(client->pending.size() - client->pendingRead);
+}
+
+void sendSpectatorAck(SpectatorClient* client)
+{
+	std::uint8_t bytes[5];
+	SnapshotWriter writer{ bytes, sizeof(bytes) };
+	putByte(&writer, RELAY_ACK);
+	putInt(&writer, static_cast<std::uint32_t>(spectatorNextFrame(client)), 4);
+	transportSend(&client->transport, bytes, writer.size);
+}
+
+void readRelayFrames(SpectatorClient* client, SnapshotReader* reader)
+{
+	long start = static_cast<long>(getInt(reader, 4));
+	int count = getByte(reader);
+	if (reader->underflow) return;
+	int32_t p1LastMouse = 0, p2LastMouse = 0;
+	for (long frame = start; frame < start + count; frame++)
+	{
+		InputData input;
+		size_t read = unpackReplayInput((const char*)reader->bytes + reader->read, reader->size - reader->read,
+			&p1LastMouse, &p2LastMouse, &input);
+		if (read == 0) return;
+		reader->read += read;
+		long next = spectatorNextFrame(client);
+		//anything past a gap gets dropped, the relay sends it again from the gap on
+		if (frame > next) return;
+		if (frame < next) (client->stats.duplicateFrames)++;
+		else client->pending.push_back(input);
+	}
+}
+
+//takes in whatever the relay sent and acknowledges it; false while it hasn't heard from the relay yet
+bool spectatorTick(SpectatorClient* client, double nowMs)
+{
+	std::uint8_t bytes[MAX_DATAGRAM_BYTES];
+	size_t size;
+	bool received = false;
+	while ((size = transportReceive(&client->transport, bytes, sizeof(bytes))) > 0)
+	{
+		(client->stats.packetsReceived)++;
+		client->lastHeardMs = nowMs;
+		client->stats.bytesReceived += static_cast<long>(size);
+		SnapshotReader reader{ bytes, size };
+		std::uint8_t type = getByte(&reader);
+		if (type == RELAY_CONFIG && size == 2 + sizeof(Config) && bytes[1] == RELAY_VERSION)
+		{
+			if (!client->haveConfig)
+			{
+				memcpy(&client->cfg, bytes + 2, sizeof(Config));
+				client->state = initialState(&client->cfg);
+				client->haveConfig = true;
+			}
+		}
+		else if (type == RELAY_FRAMES && client->haveConfig)
+		{
+			readRelayFrames(client, &reader);
+			received = true;
+		}
+	}
+	if (received || nowMs - client->lastKeepaliveMs >= SPECTATOR_KEEPALIVE_MS)
+	{
+		if (!client->haveConfig)
+		{
+			std::uint8_t join[2] = { RELAY_JOIN, RELAY_VERSION };
+			transportSend(&client->transport, join, sizeof(join));
+		}
+		else sendSpectatorAck(client);
+		client->lastKeepaliveMs = nowMs;
+	}
+	return client->haveConfig;
+}
+
+//simulates the next frame in, false if there's none; flux is left for the secondary sim to read
+bool stepSpectator(SpectatorClient* client)
+{
+	if (client->pendingRead == client->pending.size()) return false;
+	clearFlux(&client->flux);
+	simulate(&client->state, &client->flux, &client->cfg, client->pending[(client->pendingRead)++]);
+	//only cleared once it's all simulated, a spectator catching up can have the whole match waiting in here
+	if (client->pendingRead == client->pending.size())
+	{
+		client->pending.clear();
+		client->pendingRead = 0;
+	}
+	return true;
+}
+
+void leaveRelay(SpectatorClient* client)
+{
+	std::uint8_t leave = RELAY_LEAVE;
+	transportSend(&client->transport, &leave, 1);
+}
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef RBST_STATEHASH_HPP
+#define RBST_STATEHASH_HPP
+
+//std
+#include <cstddef>
+#include <cstdint>
+//-----
+#include "Math.hpp"
+#include "Player.hpp"
+#include "ProjectilePool.hpp"
+#include "GameState.hpp"
+#include "VecBatch.hpp"
+
+//checksums for telling whether two peers are on the same state
+//hashing the GameState bytes picks up struct padding, etl bookkeeping and dead projectile slots,
+//none of which the game reads, so two equal matches could still checksum differently
+//instead the fields that matter get packed into a flat array of int32 words in a fixed order, and only that gets hashed
+
+const size_t PACKED_HEADER_WORDS = 4;
+const size_t PACKED_PLAYER_WORDS = 25;
+const size_t PACKED_PROJECTILE_WORDS = 6;
+const size_t PACKED_STATE_WORDS = PACKED_HEADER_WORDS +
+	MAX_PLAYERS * PACKED_PLAYER_WORDS +
+	1 + MAX_PROJECTILES * PACKED_PROJECTILE_WORDS;
+
+struct PackedState
+{
+	std::int32_t words[PACKED_STATE_WORDS];
+	size_t count = 0;
+};
+
+inline void packWord(PackedState* packed, std::int32_t word)
+{
+	packed->words[(packed->count)++] = word;
+}
+
+inline void packWord(PackedState* packed, Vec2 word)
+{
+	packWord(packed, word.x.raw_value());
+	packWord(packed, word.y.raw_value());
+}
+
+//the pushdown is packed from the top down and padded to its max size, so every player takes the same room
+void packPlayer(PackedState* packed, const Player* player)
+{
+	etl::stack<PState, 4> pushdown = player->pushdown;
+	packWord(packed, player->id);
+	packWord(packed, static_cast<std::int32_t>(pushdown.size()));
+	for (size_t i = 0; i < pushdown.max_size(); i++)
+	{
+		if (pushdown.empty())
+		{
+			packWord(packed, -1);
+			continue;
+		}
+		packWord(packed, pushdown.top());
+		pushdown.pop();
+	}
+	packWord(packed, player->pos);
+	packWord(packed, player->vel);
+	packWord(packed, player->dir);
+	packWord(packed, player->ammo);
+	packWord(packed, player->chargeCount);
+	packWord(packed, player->stamina);
+	packWord(packed, player->perfectPos);
+	packWord(packed, player->dashVel);
+	packWord(packed, player->dashCount);
+	packWord(packed, player->hitstopCount);
+	packWord(packed, player->stunned);
+}
+
+//projectiles go in spawn order, which is the order the simulation sees them in, whatever slots they sit in
+void packGameState(const GameState* state, PackedState* packed)
+{
+	packed->count = 0;
+	packWord(packed, static_cast<std::int32_t>(state->frame));
+	packWord(packed, state->roundCountdown);
+	packWord(packed, state->phase);
+	packWord(packed, state->playerCount);
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		packPlayer(packed, &(state->players[i]));
+		packWord(packed, state->health[i]);
+		packWord(packed, state->rounds[i]);
+		packWord(packed, state->dmgThisFrame[i]);
+	}
+	packWord(packed, static_cast<std::int32_t>(projectileCount(&state->projs)));
+	for (projslot slot = firstProjectile(&state->projs); slot != NO_PROJECTILE; slot = nextProjectile(&state->projs, slot))
+	{
+		packWord(packed, projectilePos(&state->projs, slot));
+		packWord(packed, projectileVel(&state->projs, slot));
+		packWord(packed, state->projs.owner[slot]);
+		packWord(packed, state->projs.lifetime[slot]);
+	}
+}
+
+//xxHash32 laid out over int32 words: four independent lanes take a word each per round,
+//so the rounds of one stripe run side by side in a single SSE register
+//the vector and plain paths give the same bits, checksums agree between builds
+namespace statehash
+{
+	const std::uint32_t PRIME1 = 2654435761u;
+	const std::uint32_t PRIME2 = 2246822519u;
+	const std::uint32_t PRIME3 = 3266489917u;
+	const std::uint32_t PRIME4 = 668265263u;
+	const std::uint32_t PRIME5 = 374761393u;
+
+	inline std::uint32_t rotl(std::uint32_t x, int r)
+	{
+		return (x << r) | (x >> (32 - r));
+	}
+
+	inline std::uint32_t mixRound(std::uint32_t lane, std::uint32_t word)
+	{
+		return rotl(lane + word * PRIME2, 13) * PRIME1;
+	}
+
+	inline void roundsPlain(std::uint32_t lanes[4], const std::int32_t* words, size_t stripes)
+	{
+		for (size_t s = 0; s < stripes; s++)
+		{
+			for (int l = 0; l < 4; l++)
+			{
+				lanes[l] = mixRound(lanes[l], static_cast<std::uint32_t>(words[s * 4 + l]));
+			}
+		}
+	}
+
+#if defined(RBST_VECBATCH_SSE2)
+	//SSE2 has no 32 bit lane multiply, so lanes 0/2 and 1/3 go through the 32x32->64 one separately
+	inline __m128i mullo4(__m128i a, __m128i b)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	inline void rounds4(std::uint32_t lanes[4], const std::int32_t* words, size_t stripes)
+	{
+		const __m128i prime1 = _mm_set1_epi32(static_cast<int>(PRIME1));
+		const __m128i prime2 = _mm_set1_epi32(static_cast<int>(PRIME2));
+		__m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+		for (size_t s = 0; s < stripes; s++)
+		{
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + s * 4));
+			acc = _mm_add_epi32(acc, mullo4(in, prime2));
+			acc = _mm_or_si128(_mm_slli_epi32(acc, 13), _mm_srli_epi32(acc, 19));
+			acc = mullo4(acc, prime1);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+	}
+#else
+	inline void rounds4(std::uint32_t lanes[4], const std::int32_t* words, size_t stripes)
+	{
+		roundsPlain(lanes, words, stripes);
+	}
+#endif
+
+	using RoundsFn = void(*)(std::uint32_t lanes[4], const std::int32_t* words, size_t stripes);
+
+	template <RoundsFn Rounds>
+	std::uint32_t hash(const std::int32_t* words, size_t count, std::uint32_t seed)
+	{
+		size_t i = 0;
+		std::uint32_t result;
+		if (count >= 4)
+		{
+			std::uint32_t lanes[4] = { seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1 };
+			size_t stripes = count / 4;
+			Rounds(lanes, words, stripes);
+			i = stripes * 4;
+			result = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+		}
+		else result = seed + PRIME5;
+		result += static_cast<std::uint32_t>(count * 4);
+		for (; i < count; i++)
+		{
+			result = rotl(result + static_cast<std::uint32_t>(words[i]) * PRIME3, 17) * PRIME4;
+		}
+		result ^= result >> 15;
+		result *= PRIME2;
+		result ^= result >> 13;
+		result *= PRIME3;
+		result ^= result >> 16;
+		return result;
+	}
+}
+
+std::uint32_t hashWords(const std::int32_t* words, size_t count, std::uint32_t seed = 0)
+{
+	return statehash::hash<statehash::rounds4>(words, count, seed);
+}
+
+//the one to call: packs into a scratch array kept per thread, then hashes that
+std::uint32_t stateHash(const GameState* state)
+{
+	static thread_local PackedState packed;
+	packGameState(state, &packed);
+	return hashWords(packed.words, packed.count);
+}
+
+//checksums only matter on frames somebody compares, interval 1 checksums every frame
+//frames in between report 0, on both peers alike
+inline bool checksumFrame(long frame, int interval)
+{
+	return interval <= 1 || frame % interval == 0;
+}
+
+//the old checksum, kept for comparison in the benchmark
+//lifted from GGPO example
+//(itself lifted from a Wikipedia article about the algorithm? lul)
+int fletcher32_checksum(short* data, size_t len)
+{
+	int sum1 = 0xffff, sum2 = 0xffff;
+
+	while (len) {
+		size_t tlen = len > 360 ? 360 : len;
+		len -= tlen;
+		do {
+			sum1 += *data++;
+			sum2 += sum1;
+		} while (--tlen);
+		sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+		sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+	}
+
+	/* Second reduction step to reduce sums to 16 bits */
+	sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+	sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+	return sum2 << 16 | sum1;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef RBST_TRANSPORT_HPP
+#define RBST_TRANSPORT_HPP
+
+//std
+#include <cstddef>
+#include <cstdint>
+//-----
+
+//how datagrams get between two peers, with UDP's guarantees: none, packets can arrive late, out of order or never
+//GGPO opens its own UDP socket and has no way to swap it, so online matches through GGPOController don't go through this,
+//it sits under the headless rollback peer in RollbackPeer.hpp and the spectators in SpectatorRelay.hpp,
+//which can then run over a real socket (UdpSocket.hpp) or an emulated link
+
+const size_t MAX_DATAGRAM_BYTES = 512;
+
+struct Transport
+{
+	void* context = NULL;
+	//false when the datagram couldn't even be handed off (not the same as it arriving)
+	bool (*send)(void* context, const std::uint8_t* bytes, size_t size) = NULL;
+	//the next datagram that arrived, its size or 0 when there's none waiting
+	size_t (*receive)(void* context, std::uint8_t* bytes, size_t capacity) = NULL;
+};
+
+inline bool transportSend(const Transport* transport, const std::uint8_t* bytes, size_t size)
+{
+	return transport->send(transport->context, bytes, size);
+}
+
+inline size_t transportReceive(const Transport* transport, std::uint8_t* bytes, size_t capacity)
+{
+	return transport->receive(transport->context, bytes, capacity);
+}
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef RBST_UDPSOCKET_HPP
+#define RBST_UDPSOCKET_HPP
+
+//std
+#include <cstddef>
+#include <cstdint>
+//sockets
+#if defined(_WIN32)
+//on Windows whoever includes this has to get winsock going (WSAStartup) before opening anything,
+//and has to have dealt with windows.h vs raylib first, see the top of GGPOController.hpp
+#include <winsock.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+//-----
+#include "Transport.hpp"
+
+//plain nonblocking UDP, for whatever goes over the network without GGPO (GGPO brings its own socket)
+
+#if defined(_WIN32)
+typedef SOCKET UdpHandle;
+const UdpHandle NO_UDP_HANDLE = INVALID_SOCKET;
+#else
+typedef int UdpHandle;
+const UdpHandle NO_UDP_HANDLE = -1;
+#endif
+
+//IPv4, both in host order
+struct UdpAddress
+{
+	std::uint32_t ip = 0;
+	std::uint16_t port = 0;
+};
+
+struct UdpSocket
+{
+	UdpHandle handle = NO_UDP_HANDLE;
+};
+
+inline bool sameAddress(UdpAddress a, UdpAddress b)
+{
+	return a.ip == b.ip && a.port == b.port;
+}
+
+//dotted IPv4 only, false if the text isn't one
+bool parseUdpAddress(const char* text, unsigned short port, UdpAddress* address)
+{
+	in_addr parsed;
+	parsed.s_addr = inet_addr(text);
+	if (parsed.s_addr == INADDR_NONE) return false;
+	address->ip = ntohl(parsed.s_addr);
+	address->port = port;
+	return true;
+}
+
+inline sockaddr_in toSockaddr(UdpAddress address)
+{
+	sockaddr_in sa = {};
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(address.ip);
+	sa.sin_port = htons(address.port);
+	return sa;
+}
+
+//port 0 lets the system pick one, the socket never blocks
+//bufferBytes asks for bigger kernel buffers than the default, for sockets that get bursts from many peers at once
+//(the system may cap it), 0 leaves them be
+bool openUdpSocket(UdpSocket* sock, unsigned short port, int bufferBytes = 0)
+{
+	sock->handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock->handle == NO_UDP_HANDLE) return false;
+	if (bufferBytes > 0)
+	{
+		setsockopt(sock->handle, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferBytes, sizeof(bufferBytes));
+		setsockopt(sock->handle, SOL_SOCKET, SO_SNDBUF, (const char*)&bufferBytes, sizeof(bufferBytes));
+	}
+	UdpAddress any;
+	any.port = port;
+	sockaddr_in sa = toSockaddr(any);
+	bool ok = bind(sock->handle, (sockaddr*)&sa, sizeof(sa)) == 0;
+#if defined(_WIN32)
+	u_long nonBlocking = 1;
+	ok = ok && ioctlsocket(sock->handle, FIONBIO, &nonBlocking) == 0;
+#else
+	ok = ok && fcntl(sock->handle, F_SETFL, fcntl(sock->handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+	if (!ok)
+	{
+#if defined(_WIN32)
+		closesocket(sock->handle);
+#else
+		close(sock->handle);
+#endif
+		sock->handle = NO_UDP_HANDLE;
+	}
+	return ok;
+}
+
+void closeUdpSocket(UdpSocket* sock)
+{
+	if (sock->handle == NO_UDP_HANDLE) return;
+#if defined(_WIN32)
+	closesocket(sock->handle);
+#else
+	close(sock->handle);
+#endif
+	sock->handle = NO_UDP_HANDLE;
+}
+
+//the port the socket ended up bound to, for sockets opened on port 0
+unsigned short udpLocalPort(const UdpSocket* sock)
+{
+	sockaddr_in sa = {};
+#if defined(_WIN32)
+	int length = sizeof(sa);
+#else
+	socklen_t length = sizeof(sa);
+#endif
+	if (getsockname(sock->handle, (sockaddr*)&sa, &length) != 0) return 0;
+	return ntohs(sa.sin_port);
+}
+
+bool udpSendTo(const UdpSocket* sock, UdpAddress to, const std::uint8_t* bytes, size_t size)
+{
+	sockaddr_in sa = toSockaddr(to);
+	return sendto(sock->handle, (const char*)bytes, static_cast<int>(size), 0, (sockaddr*)&sa, sizeof(sa)) == static_cast<int>(size);
+}
+
+//the next datagram waiting and who sent it, 0 when there's none
+size_t udpReceiveFrom(const UdpSocket* sock, UdpAddress* from, std::uint8_t* bytes, size_t capacity)
+{
+	sockaddr_in sa = {};
+#if defined(_WIN32)
+	int length = sizeof(sa);
+#else
+	socklen_t length = sizeof(sa);
+#endif
+	int received = recvfrom(sock->handle, (char*)bytes, static_cast<int>(capacity), 0, (sockaddr*)&sa, &length);
+	//would block, or an ICMP error from an earlier send, either way nothing to read
+	if (received <= 0) return 0;
+	from->ip = ntohl(sa.sin_addr.s_addr);
+	from->port = ntohs(sa.sin_port);
+	return static_cast<size_t>(received);
+}
+
+//a socket talking to a single remote, as a Transport
+struct UdpLink
+{
+	UdpSocket* socket = NULL;
+	UdpAddress remote;
+};
+
+bool udpLinkSend(void* context, const std::uint8_t* bytes, size_t size)
+{
+	UdpLink* link = static_cast<UdpLink*>(context);
+	return udpSendTo(link->socket, link->remote, bytes, size);
+}
+
+size_t udpLinkReceive(void* context, std::uint8_t* bytes, size_t capacity)
+{
+	UdpLink* link = static_cast<UdpLink*>(context);
+	UdpAddress from;
+	size_t size;
+	//anyone but the remote is ignored
+	while ((size = udpReceiveFrom(link->socket, &from, bytes, capacity)) > 0)
+	{
+		if (sameAddress(from, link->remote)) return size;
+	}
+	return 0;
+}
+
+//the link has to stay where it is while the transport is in use
+Transport udpTransport(UdpLink* link)
+{
+	Transport transport;
+	transport.context = link;
+	transport.send = udpLinkSend;
+	transport.receive = udpLinkReceive;
+	return transport;
+}
+
+#endif
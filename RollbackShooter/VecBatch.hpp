@@ -0,0 +1,293 @@
+#ifndef RBST_VECBATCH_HPP
+#define RBST_VECBATCH_HPP
+
+//std
+#include <cstddef>
+#include <cstdint>
+//SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RBST_VECBATCH_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RBST_VECBATCH_SSE2
+#endif
+//-----
+#include "Math.hpp"
+
+//v2 operations over whole arrays of vectors instead of one Vec2 at a time
+//vectors are stored as two columns (all x, then all y) so each column is a plain array of 16.16 values
+//every kernel gives the exact same bits as calling the v2 function on each element
+
+static_assert(sizeof(num_det) == sizeof(std::int32_t), "num_det is expected to be a bare int32");
+
+struct Vec2Columns
+{
+	num_det* x;
+	num_det* y;
+};
+
+struct ConstVec2Columns
+{
+	const num_det* x;
+	const num_det* y;
+
+	ConstVec2Columns(const num_det* x, const num_det* y) : x(x), y(y) {}
+	ConstVec2Columns(Vec2Columns cols) : x(cols.x), y(cols.y) {}
+};
+
+namespace v2batch
+{
+	//fpm multiplies through int64, divides by 2^15 truncating and then halves rounding away from zero
+	//that works out to sign(a*b) * ((|a*b| + 2^15) >> 16), which only needs unsigned 32x32->64 multiplies
+#if defined(RBST_VECBATCH_SSE2)
+	inline __m128i mul4(__m128i a, __m128i b)
+	{
+		const __m128i half = _mm_set1_epi64x(1 << 15);
+		const __m128i low32 = _mm_set1_epi64x(0xffffffff);
+		__m128i signA = _mm_srai_epi32(a, 31);
+		__m128i signB = _mm_srai_epi32(b, 31);
+		__m128i absA = _mm_sub_epi32(_mm_xor_si128(a, signA), signA);
+		__m128i absB = _mm_sub_epi32(_mm_xor_si128(b, signB), signB);
+		__m128i sign = _mm_xor_si128(signA, signB);
+		//lanes 0 and 2, then lanes 1 and 3
+		__m128i even = _mm_mul_epu32(absA, absB);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(absA, 32), _mm_srli_epi64(absB, 32));
+		even = _mm_srli_epi64(_mm_add_epi64(even, half), 16);
+		odd = _mm_srli_epi64(_mm_add_epi64(odd, half), 16);
+		__m128i mag = _mm_or_si128(_mm_and_si128(even, low32), _mm_slli_epi64(odd, 32));
+		return _mm_sub_epi32(_mm_xor_si128(mag, sign), sign);
+	}
+
+	inline __m128i load4(const num_det* p)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	}
+
+	inline void store4(num_det* p, __m128i v)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+	}
+#endif
+
+#if defined(RBST_VECBATCH_AVX2)
+	inline __m256i mul8(__m256i a, __m256i b)
+	{
+		const __m256i half = _mm256_set1_epi64x(1 << 15);
+		const __m256i low32 = _mm256_set1_epi64x(0xffffffff);
+		__m256i signA = _mm256_srai_epi32(a, 31);
+		__m256i signB = _mm256_srai_epi32(b, 31);
+		__m256i absA = _mm256_sub_epi32(_mm256_xor_si256(a, signA), signA);
+		__m256i absB = _mm256_sub_epi32(_mm256_xor_si256(b, signB), signB);
+		__m256i sign = _mm256_xor_si256(signA, signB);
+		__m256i even = _mm256_mul_epu32(absA, absB);
+		__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(absA, 32), _mm256_srli_epi64(absB, 32));
+		even = _mm256_srli_epi64(_mm256_add_epi64(even, half), 16);
+		odd = _mm256_srli_epi64(_mm256_add_epi64(odd, half), 16);
+		__m256i mag = _mm256_or_si256(_mm256_and_si256(even, low32), _mm256_slli_epi64(odd, 32));
+		return _mm256_sub_epi32(_mm256_xor_si256(mag, sign), sign);
+	}
+
+	inline __m256i load8(const num_det* p)
+	{
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	}
+
+	inline void store8(num_det* p, __m256i v)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+	}
+#endif
+
+	//out = a + b, per column
+	void add(ConstVec2Columns a, ConstVec2Columns b, Vec2Columns out, size_t n)
+	{
+		size_t i = 0;
+#if defined(RBST_VECBATCH_AVX2)
+		for (; i + 8 <= n; i += 8)
+		{
+			store8(out.x + i, _mm256_add_epi32(load8(a.x + i), load8(b.x + i)));
+			store8(out.y + i, _mm256_add_epi32(load8(a.y + i), load8(b.y + i)));
+		}
+#endif
+#if defined(RBST_VECBATCH_SSE2)
+		for (; i + 4 <= n; i += 4)
+		{
+			store4(out.x + i, _mm_add_epi32(load4(a.x + i), load4(b.x + i)));
+			store4(out.y + i, _mm_add_epi32(load4(a.y + i), load4(b.y + i)));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out.x[i] = a.x[i] + b.x[i];
+			out.y[i] = a.y[i] + b.y[i];
+		}
+	}
+
+	//out = v * s
+	void scalarMult(ConstVec2Columns v, num_det s, Vec2Columns out, size_t n)
+	{
+		size_t i = 0;
+#if defined(RBST_VECBATCH_AVX2)
+		__m256i s8 = _mm256_set1_epi32(s.raw_value());
+		for (; i + 8 <= n; i += 8)
+		{
+			store8(out.x + i, mul8(load8(v.x + i), s8));
+			store8(out.y + i, mul8(load8(v.y + i), s8));
+		}
+#endif
+#if defined(RBST_VECBATCH_SSE2)
+		__m128i s4 = _mm_set1_epi32(s.raw_value());
+		for (; i + 4 <= n; i += 4)
+		{
+			store4(out.x + i, mul4(load4(v.x + i), s4));
+			store4(out.y + i, mul4(load4(v.y + i), s4));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out.x[i] = v.x[i] * s;
+			out.y[i] = v.y[i] * s;
+		}
+	}
+
+	//out[i] = dot(a[i], b[i])
+	void dot(ConstVec2Columns a, ConstVec2Columns b, num_det* out, size_t n)
+	{
+		size_t i = 0;
+#if defined(RBST_VECBATCH_AVX2)
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256i xx = mul8(load8(a.x + i), load8(b.x + i));
+			__m256i yy = mul8(load8(a.y + i), load8(b.y + i));
+			store8(out + i, _mm256_add_epi32(xx, yy));
+		}
+#endif
+#if defined(RBST_VECBATCH_SSE2)
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128i xx = mul4(load4(a.x + i), load4(b.x + i));
+			__m128i yy = mul4(load4(a.y + i), load4(b.y + i));
+			store4(out + i, _mm_add_epi32(xx, yy));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			out[i] = (a.x[i] * b.x[i]) + (a.y[i] * b.y[i]);
+		}
+	}
+
+	//out[i] = dot(v[i], v[i]), what v2::length takes the root of
+	inline void lengthSquared(ConstVec2Columns v, num_det* out, size_t n)
+	{
+		dot(v, v, out, n);
+	}
+
+	//same as v2::normalize per element
+	//there is no vector 64-bit divide, so only the squared length is batched and root and division stay scalar
+	void normalize(ConstVec2Columns v, Vec2Columns out, size_t n)
+	{
+		const size_t CHUNK = 64;
+		num_det lenSq[CHUNK];
+		for (size_t first = 0; first < n; first += CHUNK)
+		{
+			size_t count = (n - first < CHUNK) ? n - first : CHUNK;
+			lengthSquared(ConstVec2Columns(v.x + first, v.y + first), lenSq, count);
+			for (size_t i = 0; i < count; i++)
+			{
+				num_det len = fpm::sqrt(lenSq[i]);
+				if (len == num_det{ 0 })
+				{
+					out.x[first + i] = num_det{ 0 };
+					out.y[first + i] = num_det{ 0 };
+				}
+				else
+				{
+					out.x[first + i] = v.x[first + i] / len;
+					out.y[first + i] = v.y[first + i] / len;
+				}
+			}
+		}
+	}
+
+	//every vector rotated by the same angle, same as v2::rotate per element
+	void rotate(ConstVec2Columns v, num_det angle, Vec2Columns out, size_t n)
+	{
+		num_det cos = trig::cos(angle);
+		num_det sin = trig::sin(angle);
+		size_t i = 0;
+#if defined(RBST_VECBATCH_AVX2)
+		__m256i cos8 = _mm256_set1_epi32(cos.raw_value());
+		__m256i sin8 = _mm256_set1_epi32(sin.raw_value());
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256i x = load8(v.x + i);
+			__m256i y = load8(v.y + i);
+			store8(out.x + i, _mm256_sub_epi32(mul8(x, cos8), mul8(y, sin8)));
+			store8(out.y + i, _mm256_add_epi32(mul8(x, sin8), mul8(y, cos8)));
+		}
+#endif
+#if defined(RBST_VECBATCH_SSE2)
+		__m128i cos4 = _mm_set1_epi32(cos.raw_value());
+		__m128i sin4 = _mm_set1_epi32(sin.raw_value());
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128i x = load4(v.x + i);
+			__m128i y = load4(v.y + i);
+			store4(out.x + i, _mm_sub_epi32(mul4(x, cos4), mul4(y, sin4)));
+			store4(out.y + i, _mm_add_epi32(mul4(x, sin4), mul4(y, cos4)));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			num_det x = v.x[i];
+			num_det y = v.y[i];
+			out.x[i] = (x * cos) - (y * sin);
+			out.y[i] = (x * sin) + (y * cos);
+		}
+	}
+
+	//each vector rotated by its own angle
+	//the trig stays scalar, the products and sums go four or eight at a time
+	void rotate(ConstVec2Columns v, const num_det* angles, Vec2Columns out, size_t n)
+	{
+		const size_t CHUNK = 64;
+		num_det cos[CHUNK];
+		num_det sin[CHUNK];
+		for (size_t first = 0; first < n; first += CHUNK)
+		{
+			size_t count = (n - first < CHUNK) ? n - first : CHUNK;
+			for (size_t i = 0; i < count; i++)
+			{
+				cos[i] = trig::cos(angles[first + i]);
+				sin[i] = trig::sin(angles[first + i]);
+			}
+			const num_det* x = v.x + first;
+			const num_det* y = v.y + first;
+			num_det* outX = out.x + first;
+			num_det* outY = out.y + first;
+			size_t i = 0;
+#if defined(RBST_VECBATCH_SSE2)
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i x4 = load4(x + i);
+				__m128i y4 = load4(y + i);
+				__m128i cos4 = load4(cos + i);
+				__m128i sin4 = load4(sin + i);
+				store4(outX + i, _mm_sub_epi32(mul4(x4, cos4), mul4(y4, sin4)));
+				store4(outY + i, _mm_add_epi32(mul4(x4, sin4), mul4(y4, cos4)));
+			}
+#endif
+			for (; i < count; i++)
+			{
+				num_det xi = x[i];
+				num_det yi = y[i];
+				outX[i] = (xi * cos[i]) - (yi * sin[i]);
+				outY[i] = (xi * sin[i]) + (yi * cos[i]);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,133 @@
+//headless benchmark: many matches stepped together by the batch engine in BatchSim.hpp
+//every lane replays one of the given files, and its final state is checked against a plain simulate() run
+//the same lanes are also run one after another through plain simulate() on one thread, for comparison
+//usage: rbst_batchbench [-lanes N] [-threads T] replay.rbst [more.rbst ...]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "BatchSim.hpp"
+#include "bench/BenchCommon.hpp"
+
+struct LaneSource
+{
+	std::vector<LoadedReplay>* replays;
+};
+
+//lane i plays replay i % count, and stands still once the recording is over
+InputData laneInput(void* context, int lane, long frame)
+{
+	LaneSource* source = static_cast<LaneSource*>(context);
+	const LoadedReplay* replay = &(*source->replays)[lane % source->replays->size()];
+	if (frame < static_cast<long>(replay->inputs.size())) return replay->inputs[frame];
+	return InputData{};
+}
+
+int main(int argc, char* argv[])
+{
+	int lanes = 1024;
+	int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<LoadedReplay> replays;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-lanes") == 0 && i + 1 < argc)
+			lanes = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			maxThreads = std::max(1, atoi(argv[++i]));
+		else
+		{
+			LoadedReplay loaded;
+			if (!loadReplay(&loaded, argv[i]))
+			{
+				std::cerr << "could not open replay " << argv[i] << std::endl;
+				return 1;
+			}
+			replays.push_back(loaded);
+		}
+	}
+	if (replays.empty())
+	{
+		std::cerr << "usage: rbst_batchbench [-lanes N] [-threads T] replay.rbst [more.rbst ...]" << std::endl;
+		return 1;
+	}
+
+	long frames = 0;
+	for (auto it = replays.begin(); it != replays.end(); it++)
+	{
+		frames = std::max(frames, static_cast<long>(it->inputs.size()));
+	}
+
+	//reference: each replay through plain simulate() once, fed exactly like a lane
+	LaneSource source = { &replays };
+	std::vector<std::uint64_t> expected;
+	for (int r = 0; r < static_cast<int>(replays.size()); r++)
+	{
+		const Config* cfg = &replays[r].cfg;
+		GameState state = initialState(cfg);
+		SecSimFlux flux;
+		for (long f = 0; f < frames && !endCondition(&state, cfg); f++)
+		{
+			simulate(&state, &flux, cfg, laneInput(&source, r, state.frame));
+			clearFlux(&flux);
+		}
+		expected.push_back(hashGameState(&state));
+	}
+
+	bool allMatch = true;
+	std::cout << "lanes: " << lanes << ", frames per lane: up to " << frames << std::endl;
+	auto start = BenchClock::now();
+	long plainFrames = 0;
+	for (int lane = 0; lane < lanes; lane++)
+	{
+		const Config* cfg = &replays[lane % replays.size()].cfg;
+		GameState state = initialState(cfg);
+		SecSimFlux flux;
+		for (long f = 0; f < frames && !endCondition(&state, cfg); f++)
+		{
+			simulate(&state, &flux, cfg, laneInput(&source, lane, state.frame));
+			clearFlux(&flux);
+		}
+		plainFrames += state.frame;
+	}
+	std::cout << "plain simulate(), 1 thread" << std::endl;
+	std::cout << "  match frames/s: " << plainFrames / secondsSince(start) << std::endl;
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		MatchBatch batch;
+		resetBatch(&batch, lanes, &replays[0].cfg);
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			setLaneConfig(&batch, lane, &replays[lane % replays.size()].cfg);
+		}
+		start = BenchClock::now();
+		runBatch(&batch, frames, threads, laneInput, &source);
+		double seconds = secondsSince(start);
+
+		long simulated = 0;
+		long walked = 0;
+		int mismatches = 0;
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			simulated += batch.states[lane].frame;
+			walked += batch.walkedFrames[lane];
+			if (hashGameState(&batch.states[lane]) != expected[lane % replays.size()]) mismatches++;
+		}
+		allMatch = allMatch && mismatches == 0;
+		std::cout << threads << " thread(s)" << std::endl;
+		std::cout << "  match frames/s: " << simulated / seconds << std::endl;
+		std::cout << "  frames moving projectiles one at a time: " << 100.0 * walked / std::max(1L, simulated) << "%" << std::endl;
+		std::cout << "  lanes differing from simulate(): " << mismatches << std::endl;
+		if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+	}
+	return allMatch ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+#ifndef RBST_BENCHCOMMON_HPP
+#define RBST_BENCHCOMMON_HPP
+
+//std
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+//-----
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "Transport.hpp"
+#include "NetEmulator.hpp"
+
+struct LoadedReplay
+{
+	std::string fileName;
+	Config cfg;
+	std::vector<InputData> inputs;
+};
+
+//reading the whole file first keeps disk access out of the measurement
+bool loadReplay(LoadedReplay* loaded, const char* fileName)
+{
+	ReplayReader replay;
+	openReplayFile(&replay, &loaded->cfg, fileName);
+	if (!replay.fileStream.is_open()) return false;
+	loaded->fileName = fileName;
+	loaded->inputs.clear();
+	while (!replayFileEnd(&replay))
+	{
+		loaded->inputs.push_back(readReplayFile(&replay));
+	}
+	closeReplayFile(&replay);
+	return true;
+}
+
+//FNV-1a over the fields that matter, for checking two runs ended in the same place
+struct FieldHash
+{
+	std::uint64_t value = 1469598103934665603ull;
+};
+
+inline void hashField(FieldHash* hash, std::int64_t field)
+{
+	hash->value ^= static_cast<std::uint64_t>(field);
+	hash->value *= 1099511628211ull;
+}
+
+inline void hashField(FieldHash* hash, Vec2 field)
+{
+	hashField(hash, field.x.raw_value());
+	hashField(hash, field.y.raw_value());
+}
+
+void hashPlayer(FieldHash* hash, const Player* player)
+{
+	hashField(hash, player->id);
+	hashField(hash, static_cast<std::int64_t>(player->pushdown.size()));
+	hashField(hash, player->pushdown.top());
+	hashField(hash, player->pos);
+	hashField(hash, player->vel);
+	hashField(hash, player->dir);
+	hashField(hash, player->ammo);
+	hashField(hash, player->chargeCount);
+	hashField(hash, player->stamina);
+	hashField(hash, player->perfectPos);
+	hashField(hash, player->dashVel);
+	hashField(hash, player->dashCount);
+	hashField(hash, player->hitstopCount);
+	hashField(hash, player->stunned);
+}
+
+std::uint64_t hashGameState(const GameState* state)
+{
+	FieldHash hash;
+	hashField(&hash, state->frame);
+	hashField(&hash, state->roundCountdown);
+	hashField(&hash, state->phase);
+	for (int i = 0; i < state->playerCount; i++)
+	{
+		hashPlayer(&hash, &state->players[i]);
+		hashField(&hash, state->health[i]);
+		hashField(&hash, state->rounds[i]);
+	}
+	for (projslot slot = firstProjectile(&state->projs); slot != NO_PROJECTILE; slot = nextProjectile(&state->projs, slot))
+	{
+		Projectile proj = getProjectile(&state->projs, slot);
+		hashField(&hash, proj.pos);
+		hashField(&hash, proj.vel);
+		hashField(&hash, proj.owner);
+		hashField(&hash, proj.lifetime);
+	}
+	return hash.value;
+}
+
+//what the first frames of a replay end on simulated straight through, for the networked runs to be checked against
+std::uint32_t offlineStateHash(const LoadedReplay* replay, long frames)
+{
+	GameState offline = initialState(&replay->cfg);
+	SecSimFlux flux;
+	for (long frame = 0; frame < frames; frame++)
+	{
+		simulate(&offline, &flux, &replay->cfg, replay->inputs[frame]);
+		clearFlux(&flux);
+	}
+	return stateHash(&offline);
+}
+
+NetProfile netProfile(const char* name, double delayMs, double jitterMs, double lossChance, double reorderChance, double reorderMs)
+{
+	NetProfile profile;
+	profile.name = name;
+	profile.delayMs = delayMs;
+	profile.jitterMs = jitterMs;
+	profile.lossChance = lossChance;
+	profile.reorderChance = reorderChance;
+	profile.reorderMs = reorderMs;
+	return profile;
+}
+
+//the connections the network benches play over, best to worst
+const NetProfile NET_PROFILES[] = {
+	netProfile("loopback", 0, 0, 0, 0, 0),
+	netProfile("LAN", 2, 1, 0, 0, 0),
+	netProfile("same city", 15, 3, 0.005, 0, 0),
+	netProfile("cross country", 40, 8, 0.01, 0.01, 20),
+	netProfile("bad wifi", 30, 25, 0.05, 0.05, 40),
+	netProfile("150ms", 75, 10, 0.01, 0.01, 20),
+	netProfile("intercontinental", 90, 10, 0.02, 0.01, 30),
+	netProfile("satellite", 300, 40, 0.03, 0.02, 60) };
+const int NET_PROFILE_COUNT = sizeof(NET_PROFILES) / sizeof(NET_PROFILES[0]);
+
+//NULL if there's no profile by that name
+const NetProfile* findNetProfile(const char* name)
+{
+	for (int i = 0; i < NET_PROFILE_COUNT; i++)
+	{
+		if (strcmp(NET_PROFILES[i].name, name) == 0) return &NET_PROFILES[i];
+	}
+	return NULL;
+}
+
+using BenchClock = std::chrono::steady_clock;
+
+inline double secondsSince(BenchClock::time_point start)
+{
+	return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+#endif
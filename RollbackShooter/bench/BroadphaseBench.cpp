@@ -0,0 +1,126 @@
+//headless benchmark: simulate() cost per frame as the number of live projectiles grows, with and without the collision grid
+//the replay drives the players, and every frame the arena is topped back up with projectiles flying in random directions
+//usage: rbst_broadphasebench [-frames N] replay.rbst
+//build with RBST_MAX_PROJECTILES of at least 1024, the CMake target already does
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "CollisionGrid.hpp"
+#include "GameState.hpp"
+#include "bench/BenchCommon.hpp"
+
+struct BenchRun
+{
+	double seconds = 0;
+	std::uint64_t hash = 0;
+	long events = 0;
+	long frames = 0;
+};
+
+//small LCG so both runs spawn exactly the same projectiles
+inline std::uint32_t nextRandom(std::uint32_t* seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return *seed >> 8;
+}
+
+void topUpProjectiles(GameState* state, const Config* cfg, size_t count, std::uint32_t* seed)
+{
+	std::int32_t spread = (cfg->arenaRadius * num_det{ 0.9 }).raw_value();
+	while (projectileCount(&state->projs) < count)
+	{
+		Vec2 pos = {
+			num_det::from_raw_value(static_cast<std::int32_t>(nextRandom(seed) % (2u * spread)) - spread),
+			num_det::from_raw_value(static_cast<std::int32_t>(nextRandom(seed) % (2u * spread)) - spread) };
+		if (v2::length(pos) > cfg->arenaRadius) continue;
+		num_det angle = num_det::from_raw_value(static_cast<std::int32_t>(nextRandom(seed) % num_det::two_pi().raw_value()));
+		Vec2 vel = v2::scalarMult(v2::rotate(v2::right(), angle), cfg->projSpeed);
+		playerid owner = static_cast<playerid>(1 + nextRandom(seed) % 2);
+		spawnProjectile(&state->projs, { pos, vel, owner, 0 });
+	}
+}
+
+BenchRun runWithProjectiles(const LoadedReplay* replay, size_t count, long frames, bool useGrid)
+{
+	BenchRun run;
+	collisionGrid.enabled = useGrid;
+	GameState state = initialState(&replay->cfg);
+	SecSimFlux flux;
+	std::uint32_t seed = 12345;
+	auto start = BenchClock::now();
+	for (long frame = 0; frame < frames; frame++)
+	{
+		topUpProjectiles(&state, &replay->cfg, count, &seed);
+		simulate(&state, &flux, &replay->cfg, replay->inputs[frame % replay->inputs.size()]);
+		run.events += static_cast<long>(flux.projs.size() + flux.combos.size());
+		clearFlux(&flux);
+		if (endCondition(&state, &replay->cfg))
+		{
+			state = initialState(&replay->cfg);
+		}
+	}
+	run.seconds = secondsSince(start);
+	run.hash = hashGameState(&state);
+	run.frames = frames;
+	collisionGrid.enabled = true;
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 6000;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			frames = std::max(1, atoi(argv[++i]));
+			continue;
+		}
+		fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_broadphasebench [-frames N] replay.rbst" << std::endl;
+		return 1;
+	}
+	if (MAX_PROJECTILES < 1024)
+	{
+		std::cerr << "MAX_PROJECTILES is " << MAX_PROJECTILES << ", rebuild with RBST_MAX_PROJECTILES=1024" << std::endl;
+		return 1;
+	}
+
+	std::cout << replay.fileName << ", " << frames << " frames per run" << std::endl;
+	std::cout << std::setw(8) << "projs"
+		<< std::setw(14) << "exact ns/f"
+		<< std::setw(14) << "grid ns/f"
+		<< std::setw(10) << "speedup"
+		<< std::setw(10) << "events"
+		<< "  result" << std::endl;
+	bool allSame = true;
+	for (size_t count = 16; count <= 1024; count *= 2)
+	{
+		BenchRun exact = runWithProjectiles(&replay, count, frames, false);
+		BenchRun grid = runWithProjectiles(&replay, count, frames, true);
+		bool same = exact.hash == grid.hash && exact.events == grid.events;
+		allSame = allSame && same;
+		std::cout << std::setw(8) << count
+			<< std::setw(14) << std::fixed << std::setprecision(0) << (exact.seconds * 1e9) / exact.frames
+			<< std::setw(14) << (grid.seconds * 1e9) / grid.frames
+			<< std::setw(9) << std::setprecision(2) << exact.seconds / grid.seconds << "x"
+			<< std::setw(10) << grid.events
+			<< "  " << (same ? "identical" : "MISMATCH") << std::endl;
+	}
+	return allSame ? 0 : 1;
+}
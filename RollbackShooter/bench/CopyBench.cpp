@@ -0,0 +1,111 @@
+//headless benchmark: GameState bytes copied per frame by each way of calling simulate()
+//usage: rbst_copybench [-loops N] replay.rbst
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "bench/BenchCommon.hpp"
+
+enum SimulateCall
+{
+	ByValue,
+	DoubleBuffer,
+	InPlace
+};
+
+//full GameState copies each call makes per frame:
+//by value copies into the parameter, out of it on return, and assigns over the caller's state
+int copiesPerFrame(SimulateCall call)
+{
+	switch (call)
+	{
+	case ByValue: return 3;
+	case DoubleBuffer: return 1;
+	default: return 0;
+	}
+}
+
+const char* callName(SimulateCall call)
+{
+	switch (call)
+	{
+	case ByValue: return "state = simulate(state, ...)";
+	case DoubleBuffer: return "simulate(&buffer, ...)";
+	default: return "simulate(&state, ...)";
+	}
+}
+
+long runReplay(const LoadedReplay* replay, SimulateCall call, int loops)
+{
+	SecSimFlux flux;
+	GameState state;
+	GameStateBuffer buffer;
+	long checkFrame = 0;
+	for (int loop = 0; loop < loops; loop++)
+	{
+		state = initialState(&replay->cfg);
+		resetStateBuffer(&buffer, &state);
+		for (auto it = replay->inputs.begin(); it != replay->inputs.end(); it++)
+		{
+			switch (call)
+			{
+			case ByValue:
+				state = simulate(state, &flux, &replay->cfg, *it);
+				break;
+			case DoubleBuffer:
+				simulate(&buffer, &flux, &replay->cfg, *it);
+				break;
+			case InPlace:
+				simulate(&state, &flux, &replay->cfg, *it);
+				break;
+			}
+			clearFlux(&flux);
+		}
+		checkFrame += (call == DoubleBuffer) ? currentState(&buffer)->frame : state.frame;
+	}
+	return checkFrame;
+}
+
+int main(int argc, char* argv[])
+{
+	int loops = 10;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-loops") == 0 && i + 1 < argc)
+			loops = std::max(1, atoi(argv[++i]));
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (!fileName || !loadReplay(&replay, fileName))
+	{
+		std::cerr << "usage: rbst_copybench [-loops N] replay.rbst" << std::endl;
+		return 1;
+	}
+
+	long frames = static_cast<long>(replay.inputs.size()) * loops;
+	std::cout << "sizeof(GameState): " << sizeof(GameState) << " bytes" << std::endl;
+	std::cout << "frames per run: " << frames << std::endl;
+
+	SimulateCall calls[] = { ByValue, DoubleBuffer, InPlace };
+	for (SimulateCall call : calls)
+	{
+		auto start = BenchClock::now();
+		long checkFrame = runReplay(&replay, call, loops);
+		double seconds = secondsSince(start);
+		std::cout << callName(call) << std::endl;
+		std::cout << "  bytes copied/frame: " << copiesPerFrame(call) * sizeof(GameState) << std::endl;
+		std::cout << "  ns/frame: " << (seconds * 1e9) / frames << std::endl;
+		std::cout << "  (frames reached: " << checkFrame << ")" << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,163 @@
+//headless benchmark for the adaptive input delay in InputDelay.hpp
+//two rollback peers play a replay over each network profile twice, once with no input delay like the game used to,
+//once with each side's delay picked by a DelayController, and it reports how deep the rollbacks went both times
+//the ping the controller gets is the profile's round trip, standing in for what GGPO would measure
+//both peers have to end on the same state as simulating the replay offline either way
+//usage: rbst_delaybench [-frames N] [-seed S] [-target F] replay.rbst
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "Transport.hpp"
+#include "NetEmulator.hpp"
+#include "RollbackPeer.hpp"
+#include "InputDelay.hpp"
+#include "bench/BenchCommon.hpp"
+
+const double TICK_MS = 1000.0 / 60.0;
+
+struct DelayRun
+{
+	bool same = false;
+	long rollbacks = 0;
+	long resimulated = 0;
+	long worst = 0;
+	long stalls = 0;
+	int finalDelay[2] = {};
+	int changes = 0;
+};
+
+DelayRun runMatch(const LoadedReplay* replay, long frames, const NetProfile* profile, std::uint32_t seed,
+	std::uint32_t offlineHash, bool adaptive, double target)
+{
+	DelayRun run;
+	NetEmulator* emulator = new NetEmulator();
+	resetEmulator(emulator, profile, seed);
+	RollbackPeer* peers[2] = { new RollbackPeer(), new RollbackPeer() };
+	DelayController ctrls[2];
+	for (int side = 0; side < 2; side++)
+	{
+		resetPeer(peers[side], &replay->cfg, side, emulatorTransport(emulator, side));
+		resetDelayController(&ctrls[side], target);
+	}
+	long tickLimit = frames * 4 + 600;
+	for (long tick = 0; tick < tickLimit; tick++)
+	{
+		advanceEmulator(emulator, TICK_MS);
+		for (int side = 0; side < 2; side++)
+		{
+			RollbackPeer* peer = peers[side];
+			long resimulated = peer->stats.resimulated;
+			receivePeerInputs(peer);
+			rollbackPeer(peer);
+			//the same as peerTick, except every frame gets its own input from the replay whatever the delay does
+			if (peer->state.frame < frames)
+			{
+				if (peerCanAdvance(peer))
+				{
+					while (peerWantsLocalInput(peer) && peer->lastLocalInput + 1 < frames)
+					{
+						peerAddLocalInput(peer, &replay->inputs[peer->lastLocalInput + 1].players[side]);
+					}
+					stepPeer(peer);
+				}
+				else (peer->stats.stalls)++;
+			}
+			sendPeerInputs(peer);
+			if (adaptive)
+			{
+				delaySample(&ctrls[side], static_cast<int>(peer->stats.resimulated - resimulated), 2 * profile->delayMs);
+				if (updateInputDelay(&ctrls[side], peer->state.phase, peer->state.frame)) peer->inputDelay = ctrls[side].delay;
+			}
+		}
+		if (peerSettled(peers[0], frames) && peerSettled(peers[1], frames)) break;
+	}
+	run.same = peerSettled(peers[0], frames) && peerSettled(peers[1], frames) &&
+		stateHash(&peers[0]->state) == offlineHash && stateHash(&peers[1]->state) == offlineHash;
+	for (int side = 0; side < 2; side++)
+	{
+		run.rollbacks += peers[side]->stats.rollbacks;
+		run.resimulated += peers[side]->stats.resimulated;
+		run.worst = std::max(run.worst, peers[side]->stats.worstRollback);
+		run.stalls += peers[side]->stats.stalls;
+		run.finalDelay[side] = peers[side]->inputDelay;
+		run.changes += ctrls[side].changes;
+		delete peers[side];
+	}
+	delete emulator;
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 0;
+	std::uint32_t seed = 1;
+	double target = 2;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+			seed = static_cast<std::uint32_t>(atoi(argv[++i]));
+		else if (strcmp(argv[i], "-target") == 0 && i + 1 < argc)
+			target = atof(argv[++i]);
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_delaybench [-frames N] [-seed S] [-target F] replay.rbst" << std::endl;
+		return 1;
+	}
+	if (frames == 0 || frames > static_cast<long>(replay.inputs.size())) frames = static_cast<long>(replay.inputs.size());
+
+	std::uint32_t offlineHash = offlineStateHash(&replay, frames);
+
+	//the shared profiles but loopback and satellite
+	const char* profiles[] = { "LAN", "same city", "cross country", "bad wifi", "150ms", "intercontinental" };
+
+	std::cout << replay.fileName << ", " << frames << " frames, seed " << seed << ", target mean rollback " << target << "f" << std::endl;
+	std::cout << std::left << std::setw(18) << "profile" << std::right
+		<< std::setw(14) << "no delay: mean"
+		<< std::setw(7) << "worst"
+		<< std::setw(10) << "resim f"
+		<< std::setw(18) << "adaptive: delay"
+		<< std::setw(7) << "mean"
+		<< std::setw(7) << "worst"
+		<< std::setw(10) << "resim f"
+		<< std::setw(9) << "changes"
+		<< "  result" << std::endl;
+	bool allSame = true;
+	for (const char* name : profiles)
+	{
+		const NetProfile& profile = *findNetProfile(name);
+		DelayRun fixed = runMatch(&replay, frames, &profile, seed, offlineHash, false, target);
+		DelayRun adaptive = runMatch(&replay, frames, &profile, seed, offlineHash, true, target);
+		bool ok = fixed.same && adaptive.same;
+		allSame = allSame && ok;
+		std::cout << std::left << std::setw(18) << profile.name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(14) << static_cast<double>(fixed.resimulated) / std::max(1L, fixed.rollbacks)
+			<< std::setw(7) << fixed.worst
+			<< std::setw(10) << fixed.resimulated
+			<< std::setw(14) << adaptive.finalDelay[0] << "/" << adaptive.finalDelay[1] << "f"
+			<< std::setw(7) << static_cast<double>(adaptive.resimulated) / std::max(1L, adaptive.rollbacks)
+			<< std::setw(7) << adaptive.worst
+			<< std::setw(10) << adaptive.resimulated
+			<< std::setw(9) << adaptive.changes
+			<< "  " << (ok ? "identical" : "MISMATCH") << std::endl;
+	}
+	return allSame ? 0 : 1;
+}
@@ -0,0 +1,613 @@
+//headless benchmark of the secondary sim's share of a rollback: keeping the flux history and reconciling the particles
+//with it, three ways: the std::map history and the position matching the game used to do, the same matching over the
+//ring in SecondarySim.hpp, and the ring with the event ids rollbackSecSim matches by now; and a fourth that keeps no
+//particles and makes them from the ring every frame with deriveSecSim (ParticleMode::Derive), nothing to reconcile
+//a replay is played with the second player's inputs arriving depth frames late, so every frame rolls back
+//depth frames and simulates them again like GGPO's advance callback does, at depths 1 to 15, saving and loading
+//snapshots like the save and load callbacks do (projectiles come back in other slots); only the history and
+//secondary sim work is timed, and every allocation is counted (operator new is replaced in this file) once the match
+//is going
+//wrong particles are the ones that differ from a run that never rolls back, over the frames every run has confirmed
+//by the end: left over from events that didn't happen after all, or missing for ones that did
+//-projectiles N keeps the arena topped up with that many projectiles like BroadphaseBench does, for a lot more
+//particles alive
+//usage: rbst_fluxbench [-frames N] [-projectiles N] replay.rbst
+//build with RBST_MAX_PROJECTILES of at least 1024, the CMake target already does
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <new>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "CollisionGrid.hpp"
+#include "GameState.hpp"
+#include "Snapshot.hpp"
+#include "bench/BenchCommon.hpp"
+
+static long allocations = 0;
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == NULL) throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	free(memory);
+}
+
+//the states to roll back to, by frame
+const int SAVED_FRAMES = 16;
+const int MAX_DEPTH = 15;
+//allocations are only counted from here, when the particle vectors are done growing
+const long WARMUP_FRAMES = 600;
+//how far apart particles could be and still be taken for the same one
+const float POSITION_FORGIVENESS = 0.5f;
+//particles counted as wrong or right are from this many frames before the end up to MAX_DEPTH + 1 before it, all
+//confirmed, and none old enough to have faded
+const long CHECKED_FRAMES = 45;
+
+using MapFluxHistory = std::map<long, SecSimFlux>;
+
+enum class Reconcile
+{
+	//the map history and position matching, as the game used to
+	MapPositions,
+	//the same matching over the ring
+	RingPositions,
+	//rollbackSecSim
+	RingIds,
+	//no reconciling, deriveSecSim every frame
+	Derive
+};
+
+//the frames rolled back over, for the position matching to look through whichever history keeps them
+struct RolledBack
+{
+	long frames[FLUX_HISTORY_FRAMES];
+	SecSimFlux* fluxes[FLUX_HISTORY_FRAMES];
+	int count = 0;
+};
+
+void rolledBackFrom(MapFluxHistory* fluxHist, long rollbackFrame, RolledBack* rolled)
+{
+	rolled->count = 0;
+	for (auto histIt = fluxHist->upper_bound(rollbackFrame); histIt != fluxHist->end(); histIt++)
+	{
+		rolled->frames[rolled->count] = histIt->first;
+		rolled->fluxes[(rolled->count)++] = &(histIt->second);
+	}
+}
+
+void rolledBackFrom(SecSimFluxHistory* fluxHist, long rollbackFrame, RolledBack* rolled)
+{
+	rolled->count = 0;
+	for (long frame = std::max(rollbackFrame + 1, fluxHist->newest - FLUX_HISTORY_FRAMES + 1); frame <= fluxHist->newest; frame++)
+	{
+		SecSimFlux* flux = historyFlux(fluxHist, frame);
+		if (flux == NULL) continue;
+		rolled->frames[rolled->count] = frame;
+		rolled->fluxes[(rolled->count)++] = flux;
+	}
+}
+
+//the flux of exactly that frame, an empty one if it wasn't rolled back over
+SecSimFlux* rolledBackFlux(RolledBack* rolled, long frame)
+{
+	static SecSimFlux noFlux;
+	for (int i = 0; i < rolled->count; i++)
+	{
+		if (rolled->frames[i] == frame) return rolled->fluxes[i];
+	}
+	return &noFlux;
+}
+
+//rollbackSecSim as it was before event ids, with the frames it looks at gathered from either history
+void positionsRollbackSecSim(RolledBack* fluxHist, SecSimParticles* particles, long rollbackFrame)
+{
+	//Compare particles to flux
+	//PROJECTILE COLLISIONS
+	//can have slight variations in frame and position if collided with player
+	for (int it = 0; it < particles->projs.count;)
+	{
+		//particle is within flux
+		if (particles->projs.frame[it] > rollbackFrame)
+		{
+			bool exists = false;
+			std::vector<SidedFlux>::iterator fluxIt;
+			//check frames from history
+			for (int hist = 0; hist < fluxHist->count; hist++)
+			{
+				SecSimFlux* histFlux = fluxHist->fluxes[hist];
+				fluxIt = histFlux->projs.begin();
+				for (; fluxIt != histFlux->projs.end(); fluxIt++)
+				{
+					//don't compare with an already associated flux
+					if (fluxIt->associated) continue;
+					exists = (fpm::abs(particles->projs.pos[it].x - fluxIt->pos.x) + fpm::abs(particles->projs.pos[it].y - fluxIt->pos.y)) < num_det{ POSITION_FORGIVENESS };
+					if (exists)
+					{
+						fluxIt->associated = true;
+						particles->projs.pos[it] = fluxIt->pos;
+						particles->projs.frame[it] = fluxHist->frames[hist];
+						break;
+					}
+				}
+				//break out of wider loop
+				if (exists) break;
+			}
+			if (!exists)
+			{
+				removeParticle(&particles->projs, &particles->subParts, it);
+				continue;
+			}
+		}
+
+		it++;
+	}
+	//COMBOS
+	//if it did not happen in that frame at that position, it did not happen
+	for (int it = 0; it < particles->combos.count;)
+	{
+		//particle is within flux
+		if (particles->combos.frame[it] > rollbackFrame)
+		{
+			bool exists = false;
+			SecSimFlux* frameFlux = rolledBackFlux(fluxHist, particles->combos.frame[it]);
+			auto fluxIt = frameFlux->combos.begin();
+			for (; fluxIt != frameFlux->combos.end(); fluxIt++)
+			{
+				//don't compare with an already associated flux
+				if (fluxIt->associated) continue;
+				exists = v2::equal(particles->combos.pos[it], fluxIt->pos);
+				if (exists)
+				{
+					fluxIt->associated = true;
+					break;
+				}
+			}
+			if (!exists)
+			{
+				removeParticle(&particles->combos, &particles->subParts, it);
+				continue;
+			}
+		}
+
+		it++;
+	}
+	//GRAZES
+	//if it did not happen in that frame and NEAR that position, it did not happen
+	for (int it = 0; it < particles->grazes.count;)
+	{
+		//particle is within flux
+		if (particles->grazes.frame[it] > rollbackFrame)
+		{
+			long exactFrame = particles->grazes.frame[it];
+			bool exists = false;
+			SecSimFlux* frameFlux = rolledBackFlux(fluxHist, exactFrame);
+			auto fluxIt = frameFlux->grazes.begin();
+			for (; fluxIt != frameFlux->grazes.end(); fluxIt++)
+			{
+				//don't compare with an already associated flux
+				if (fluxIt->associated) continue;
+				exists = (fpm::abs(particles->grazes.pos[it].x - fluxIt->pos.x) + fpm::abs(particles->grazes.pos[it].y - fluxIt->pos.y)) < num_det{ POSITION_FORGIVENESS };
+				if (exists)
+				{
+					fluxIt->associated = true;
+					particles->grazes.pos[it] = fluxIt->pos;
+					break;
+				}
+			}
+			if (!exists)
+			{
+				removeParticle(&particles->grazes, &particles->subParts, it);
+				continue;
+			}
+		}
+
+		it++;
+	}
+	//ALERTS
+	//can have slight variations in frame and position depending on when player inputted
+	for (int it = 0; it < particles->alerts.count;)
+	{
+		//particle is within flux
+		if (particles->alerts.frame[it] > rollbackFrame)
+		{
+			bool exists = false;
+			std::vector<BasicFlux>::iterator fluxIt;
+			//check frames from history
+			for (int hist = 0; hist < fluxHist->count; hist++)
+			{
+				SecSimFlux* histFlux = fluxHist->fluxes[hist];
+				fluxIt = histFlux->alerts.begin();
+				for (; fluxIt != histFlux->alerts.end(); fluxIt++)
+				{
+					//don't compare with an already associated flux
+					if (fluxIt->associated) continue;
+					exists = (fpm::abs(particles->alerts.pos[it].x - fluxIt->pos.x) + fpm::abs(particles->alerts.pos[it].y - fluxIt->pos.y)) < num_det{ POSITION_FORGIVENESS };
+					if (exists)
+					{
+						fluxIt->associated = true;
+						particles->alerts.pos[it] = fluxIt->pos;
+						particles->alerts.frame[it] = fluxHist->frames[hist];
+						break;
+					}
+				}
+				//break out of wider loop
+				if (exists) break;
+			}
+			if (!exists)
+			{
+				removeParticle(&particles->alerts, &particles->subParts, it);
+				continue;
+			}
+		}
+
+		it++;
+	}
+	//HITSCANS
+	//if it did not happen in that frame at that position, it did not happen
+	for (int it = 0; it < particles->hitscans.count;)
+	{
+		//particle is within flux
+		if (particles->hitscans.frame[it] > rollbackFrame)
+		{
+			bool exists = false;
+			SecSimFlux* frameFlux = rolledBackFlux(fluxHist, particles->hitscans.frame[it]);
+			auto fluxIt = frameFlux->hitscans.begin();
+			for (; fluxIt != frameFlux->hitscans.end(); fluxIt++)
+			{
+				//don't compare with an already associated flux
+				if (fluxIt->associated) continue;
+				exists = v2::equal(particles->hitscans.pos[it], fluxIt->pos);
+				if (exists)
+				{
+					fluxIt->associated = true;
+					break;
+				}
+			}
+			if (!exists)
+			{
+				removeParticle(&particles->hitscans, &particles->subParts, it);
+				continue;
+			}
+		}
+
+		it++;
+	}
+
+	//Add particles of non-associated flux
+	for (int hist = 0; hist < fluxHist->count; hist++)
+	{
+		currentFrameSecSim(fluxHist->fluxes[hist], particles, fluxHist->frames[hist]);
+	}
+}
+
+struct FluxRun
+{
+	double seconds = 0;
+	//of which reconciling, aging, spawning or deriving particles, with the ring; the rest is keeping the history
+	double particleSeconds = 0;
+	long rollbacks = 0;
+	long allocations = 0;
+	long countedFrames = 0;
+	//particles alive after each frame, summed
+	long particles = 0;
+	std::uint64_t hash = 0;
+	//one per particle in the checked frames, sorted
+	std::vector<std::uint64_t> checked;
+};
+
+//the inputs as they're known at tick: the second player's only up to tick - depth, repeated after that
+InputData knownInput(const LoadedReplay* replay, long frame, long tick, int depth)
+{
+	InputData input = replay->inputs[frame];
+	long confirmed = tick - depth;
+	if (frame > confirmed) input.players[1] = predictInput(replay->inputs[std::max(0L, confirmed)].players[1]);
+	return input;
+}
+
+//small LCG so every run spawns exactly the same projectiles
+inline std::uint32_t nextRandom(std::uint32_t* seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return *seed >> 8;
+}
+
+//BroadphaseBench's, seeded from the frame so simulating a frame again spawns the same ones
+void topUpProjectiles(GameState* state, const Config* cfg, size_t count)
+{
+	std::uint32_t seed = 12345u ^ static_cast<std::uint32_t>(state->frame * 2654435761u);
+	std::int32_t spread = (cfg->arenaRadius * num_det{ 0.9 }).raw_value();
+	while (projectileCount(&state->projs) < count)
+	{
+		Vec2 pos = {
+			num_det::from_raw_value(static_cast<std::int32_t>(nextRandom(&seed) % (2u * spread)) - spread),
+			num_det::from_raw_value(static_cast<std::int32_t>(nextRandom(&seed) % (2u * spread)) - spread) };
+		if (v2::length(pos) > cfg->arenaRadius) continue;
+		num_det angle = num_det::from_raw_value(static_cast<std::int32_t>(nextRandom(&seed) % num_det::two_pi().raw_value()));
+		Vec2 vel = v2::scalarMult(v2::rotate(v2::right(), angle), cfg->projSpeed);
+		playerid owner = static_cast<playerid>(1 + nextRandom(&seed) % 2);
+		spawnProjectile(&state->projs, { pos, vel, owner, 0 });
+	}
+}
+
+//simulate, the arena topped up with projectiles first if asked
+void simulateFilled(GameState* state, SecSimFlux* flux, const Config* cfg, InputData input, size_t projectiles)
+{
+	if (projectiles > 0) topUpProjectiles(state, cfg, projectiles);
+	simulate(state, flux, cfg, input);
+}
+
+void hashParticles(FieldHash* hash, const ParticlePool* pool)
+{
+	for (int i = 0; i < pool->count; i++)
+	{
+		hashField(hash, pool->frame[i]);
+		hashField(hash, pool->lifetime[i]);
+		hashField(hash, pool->pos[i]);
+	}
+}
+
+std::uint64_t particlesHash(const SecSimParticles* particles)
+{
+	FieldHash hash;
+	hashParticles(&hash, &particles->projs);
+	hashParticles(&hash, &particles->combos);
+	hashParticles(&hash, &particles->grazes);
+	hashParticles(&hash, &particles->alerts);
+	hashParticles(&hash, &particles->hitscans);
+	return hash.value;
+}
+
+//what a particle shows, where and when, ids left out since the position matching doesn't keep them
+void checkParticles(std::vector<std::uint64_t>* checked, long lastFrame, int kind, const ParticlePool* pool)
+{
+	for (int i = 0; i < pool->count; i++)
+	{
+		if (pool->frame[i] <= lastFrame - CHECKED_FRAMES || pool->frame[i] > lastFrame - MAX_DEPTH - 1) continue;
+		FieldHash hash;
+		hashField(&hash, kind);
+		hashField(&hash, pool->frame[i]);
+		hashField(&hash, pool->pos[i]);
+		checked->push_back(hash.value);
+	}
+}
+
+std::vector<std::uint64_t> checkedParticles(const SecSimParticles* particles, long lastFrame)
+{
+	std::vector<std::uint64_t> checked;
+	checkParticles(&checked, lastFrame, 0, &particles->projs);
+	checkParticles(&checked, lastFrame, 1, &particles->combos);
+	checkParticles(&checked, lastFrame, 2, &particles->grazes);
+	checkParticles(&checked, lastFrame, 3, &particles->alerts);
+	checkParticles(&checked, lastFrame, 4, &particles->hitscans);
+	std::sort(checked.begin(), checked.end());
+	return checked;
+}
+
+//particles one run has and the other doesn't
+long wrongParticles(const FluxRun* run, const FluxRun* truth)
+{
+	std::vector<std::uint64_t> difference;
+	std::set_symmetric_difference(run->checked.begin(), run->checked.end(), truth->checked.begin(), truth->checked.end(), std::back_inserter(difference));
+	return static_cast<long>(difference.size());
+}
+
+//one snapshot per frame GGPO could roll back to, allocated up front so saves don't count as allocations
+struct SavedSnapshots
+{
+	std::uint8_t* bytes = new std::uint8_t[SAVED_FRAMES * MAX_SNAPSHOT_BYTES];
+	size_t sizes[SAVED_FRAMES] = {};
+};
+
+void saveSnapshot(SavedSnapshots* saved, const GameState* state)
+{
+	int index = state->frame % SAVED_FRAMES;
+	saved->sizes[index] = encodeSnapshot(state, saved->bytes + index * MAX_SNAPSHOT_BYTES, MAX_SNAPSHOT_BYTES);
+}
+
+void loadSnapshot(const SavedSnapshots* saved, long frame, GameState* state)
+{
+	int index = frame % SAVED_FRAMES;
+	decodeSnapshot(saved->bytes + index * MAX_SNAPSHOT_BYTES, saved->sizes[index], state);
+}
+
+//the same steps as the GGPO callbacks and stepNetSession; depth 0 never rolls back
+FluxRun runFlux(const LoadedReplay* replay, size_t projectiles, long frames, int depth, Reconcile reconcile)
+{
+	FluxRun run;
+	bool ring = reconcile != Reconcile::MapPositions;
+	SavedSnapshots saved;
+	const Config* cfg = &(replay->cfg);
+	GameState state = initialState(cfg);
+	SecSimParticles* particles = new SecSimParticles();
+	MapFluxHistory mapHist;
+	SecSimFluxHistory* ringHist = new SecSimFluxHistory();
+	resetFluxHistory(ringHist);
+	RolledBack rolled;
+	for (long tick = 0; tick < frames; tick++)
+	{
+		long counted = allocations;
+		//the late input came in, back to its frame and up to now again
+		if (depth > 0 && tick >= depth)
+		{
+			long rollbackFrame = tick - depth;
+			loadSnapshot(&saved, rollbackFrame, &state);
+			for (long frame = rollbackFrame; frame < tick; frame++)
+			{
+				saveSnapshot(&saved, &state);
+				InputData input = knownInput(replay, frame, tick, depth);
+				BenchClock::time_point start = BenchClock::now();
+				if (ring)
+				{
+					SecSimFlux* flux = recordFlux(ringHist, state.frame + 1);
+					run.seconds += secondsSince(start);
+					simulateFilled(&state, flux, cfg, input, projectiles);
+				}
+				else
+				{
+					SecSimFlux flux;
+					simulateFilled(&state, &flux, cfg, input, projectiles);
+					start = BenchClock::now();
+					mapHist.erase(state.frame);
+					mapHist.insert(std::pair<long, SecSimFlux>(state.frame, flux));
+					run.seconds += secondsSince(start);
+				}
+			}
+			BenchClock::time_point start = BenchClock::now();
+			switch (reconcile)
+			{
+			case Reconcile::MapPositions:
+				rolledBackFrom(&mapHist, rollbackFrame, &rolled);
+				positionsRollbackSecSim(&rolled, particles, rollbackFrame);
+				break;
+			case Reconcile::RingPositions:
+				rolledBackFrom(ringHist, rollbackFrame, &rolled);
+				positionsRollbackSecSim(&rolled, particles, rollbackFrame);
+				break;
+			case Reconcile::RingIds:
+				rollbackSecSim(ringHist, particles, rollbackFrame);
+				break;
+			case Reconcile::Derive:
+				break;
+			}
+			run.particleSeconds += secondsSince(start);
+			run.seconds += secondsSince(start);
+			(run.rollbacks)++;
+		}
+		//and the new frame
+		saveSnapshot(&saved, &state);
+		InputData input = knownInput(replay, tick, tick, depth);
+		if (ring)
+		{
+			BenchClock::time_point start = BenchClock::now();
+			SecSimFlux* flux = recordFlux(ringHist, state.frame + 1);
+			run.seconds += secondsSince(start);
+			simulateFilled(&state, flux, cfg, input, projectiles);
+			start = BenchClock::now();
+			if (reconcile == Reconcile::Derive) deriveSecSim(ringHist, particles, state.frame);
+			else
+			{
+				increaseParticleLifetime(particles);
+				currentFrameSecSim(flux, particles, state.frame);
+			}
+			run.particleSeconds += secondsSince(start);
+			run.seconds += secondsSince(start);
+		}
+		else
+		{
+			SecSimFlux flux;
+			simulateFilled(&state, &flux, cfg, input, projectiles);
+			BenchClock::time_point start = BenchClock::now();
+			increaseParticleLifetime(particles);
+			currentFrameSecSim(&flux, particles, state.frame);
+			mapHist.insert(std::pair<long, SecSimFlux>(state.frame, flux));
+			mapHist.erase(state.frame - 15);
+			run.seconds += secondsSince(start);
+		}
+		run.particles += particleCount(particles);
+		if (tick >= WARMUP_FRAMES)
+		{
+			run.allocations += allocations - counted;
+			(run.countedFrames)++;
+		}
+	}
+	run.hash = particlesHash(particles) ^ static_cast<std::uint64_t>(state.frame);
+	run.checked = checkedParticles(particles, state.frame);
+	delete particles;
+	delete ringHist;
+	delete[] saved.bytes;
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 3600;
+	size_t projectiles = 0;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-projectiles") == 0 && i + 1 < argc)
+			projectiles = std::min(static_cast<size_t>(std::max(0, atoi(argv[++i]))), MAX_PROJECTILES);
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_fluxbench [-frames N] [-projectiles N] replay.rbst" << std::endl;
+		return 1;
+	}
+	if (frames > static_cast<long>(replay.inputs.size())) frames = static_cast<long>(replay.inputs.size());
+
+	std::cout << replay.fileName << ", " << frames << " frames";
+	if (projectiles > 0) std::cout << " with " << projectiles << " projectiles flying";
+	std::cout << ", rolling back every frame; allocations counted after frame " << WARMUP_FRAMES << std::endl;
+	FluxRun truth = runFlux(&replay, projectiles, frames, 0, Reconcile::RingIds);
+	std::cout << std::setw(6) << "depth"
+		<< std::setw(11) << "particles"
+		<< std::setw(10) << "map ns/f"
+		<< std::setw(11) << "ring ns/f"
+		<< std::setw(10) << "ids ns/f"
+		<< std::setw(9) << "speedup"
+		<< std::setw(13) << "derive ns/f"
+		<< std::setw(24) << "particles only: ids"
+		<< std::setw(8) << "derive"
+		<< std::setw(8) << "allocs"
+		<< std::setw(13) << "wrong: pos"
+		<< std::setw(5) << "ids"
+		<< std::setw(8) << "derive"
+		<< "  result" << std::endl;
+	bool allSame = true;
+	for (int depth = 1; depth <= MAX_DEPTH; depth++)
+	{
+		FluxRun mapRun = runFlux(&replay, projectiles, frames, depth, Reconcile::MapPositions);
+		FluxRun ringRun = runFlux(&replay, projectiles, frames, depth, Reconcile::RingPositions);
+		FluxRun idRun = runFlux(&replay, projectiles, frames, depth, Reconcile::RingIds);
+		FluxRun deriveRun = runFlux(&replay, projectiles, frames, depth, Reconcile::Derive);
+		long idWrong = wrongParticles(&idRun, &truth);
+		long deriveWrong = wrongParticles(&deriveRun, &truth);
+		//the map and the ring have to agree, and neither matching by id nor deriving can get anything wrong
+		bool same = mapRun.hash == ringRun.hash && idWrong == 0 && deriveWrong == 0;
+		allSame = allSame && same;
+		std::cout << std::setw(6) << depth << std::fixed << std::setprecision(1)
+			<< std::setw(11) << static_cast<double>(idRun.particles) / frames << std::setprecision(0)
+			<< std::setw(10) << mapRun.seconds * 1e9 / frames
+			<< std::setw(11) << ringRun.seconds * 1e9 / frames
+			<< std::setw(10) << idRun.seconds * 1e9 / frames
+			<< std::setprecision(2) << std::setw(8) << ringRun.seconds / idRun.seconds << "x"
+			<< std::setprecision(0) << std::setw(13) << deriveRun.seconds * 1e9 / frames
+			<< std::setw(24) << idRun.particleSeconds * 1e9 / frames
+			<< std::setw(8) << deriveRun.particleSeconds * 1e9 / frames << std::setprecision(2)
+			<< std::setw(8) << static_cast<double>(idRun.allocations) / std::max(1L, idRun.countedFrames)
+			<< std::setw(13) << wrongParticles(&ringRun, &truth)
+			<< std::setw(5) << idWrong
+			<< std::setw(8) << deriveWrong
+			<< "  " << (same ? "ok" : "MISMATCH") << std::endl;
+	}
+	return allSame ? 0 : 1;
+}
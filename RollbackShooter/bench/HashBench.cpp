@@ -0,0 +1,114 @@
+//headless benchmark: checksum cost per saved frame, fletcher32 over the raw GameState against the packed state hash
+//also checks the SSE and plain hash paths agree, and how often each checksum changes when only unused bytes do
+//(a projectile spawned and removed again leaves the pool bookkeeping different but the match the same)
+//usage: rbst_hashbench [-loops N] replay.rbst
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "bench/BenchCommon.hpp"
+
+//every state the replay goes through, so the timed loops only checksum
+std::vector<GameState> recordStates(const LoadedReplay* replay)
+{
+	std::vector<GameState> states;
+	SecSimFlux flux;
+	GameState state = initialState(&replay->cfg);
+	for (auto it = replay->inputs.begin(); it != replay->inputs.end(); it++)
+	{
+		simulate(&state, &flux, &replay->cfg, *it);
+		clearFlux(&flux);
+		states.push_back(state);
+	}
+	return states;
+}
+
+int main(int argc, char* argv[])
+{
+	int loops = 50;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-loops") == 0 && i + 1 < argc)
+			loops = std::max(1, atoi(argv[++i]));
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_hashbench [-loops N] replay.rbst" << std::endl;
+		return 1;
+	}
+	std::vector<GameState> states = recordStates(&replay);
+	long checks = static_cast<long>(states.size()) * loops;
+
+	//sums keep the optimizer from dropping the loops
+	std::uint64_t fletcherSum = 0;
+	auto start = BenchClock::now();
+	for (int loop = 0; loop < loops; loop++)
+	{
+		for (auto it = states.begin(); it != states.end(); it++)
+		{
+			fletcherSum += static_cast<std::uint32_t>(fletcher32_checksum((short*)&(*it), sizeof(GameState) / 2));
+		}
+	}
+	double fletcherSeconds = secondsSince(start);
+
+	std::uint64_t hashSum = 0;
+	start = BenchClock::now();
+	for (int loop = 0; loop < loops; loop++)
+	{
+		for (auto it = states.begin(); it != states.end(); it++)
+		{
+			hashSum += stateHash(&(*it));
+		}
+	}
+	double hashSeconds = secondsSince(start);
+	volatile std::uint64_t sink = fletcherSum ^ hashSum;
+	(void)sink;
+
+	long pathMismatches = 0;
+	long fletcherChanged = 0;
+	long hashChanged = 0;
+	PackedState packed;
+	for (auto it = states.begin(); it != states.end(); it++)
+	{
+		packGameState(&(*it), &packed);
+		std::uint32_t plain = statehash::hash<statehash::roundsPlain>(packed.words, packed.count, 0);
+		if (plain != hashWords(packed.words, packed.count)) pathMismatches++;
+
+		GameState same = *it;
+		if (projectileCount(&same.projs) < MAX_PROJECTILES)
+		{
+			ProjectileHandle handle = spawnProjectile(&same.projs, { v2::zero(), v2::right(), 1, 0 });
+			removeProjectile(&same.projs, handle);
+		}
+		if (fletcher32_checksum((short*)&(*it), sizeof(GameState) / 2) != fletcher32_checksum((short*)&same, sizeof(GameState) / 2))
+			fletcherChanged++;
+		if (stateHash(&(*it)) != stateHash(&same))
+			hashChanged++;
+	}
+
+	std::cout << replay.fileName << ", " << states.size() << " states, " << loops << " loops, "
+		<< sizeof(GameState) << " byte GameState, " << packed.count << " packed words on the last frame" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "fletcher32 raw:  " << (fletcherSeconds * 1e9) / checks << " ns/checksum" << std::endl;
+	std::cout << "packed hash:     " << (hashSeconds * 1e9) / checks << " ns/checksum, "
+		<< std::setprecision(2) << fletcherSeconds / hashSeconds << "x" << std::endl;
+	std::cout << "unused bytes changed: fletcher32 differs on " << fletcherChanged << ", packed hash on " << hashChanged
+		<< " of " << states.size() << " frames" << std::endl;
+	std::cout << "SSE/plain hash mismatches: " << pathMismatches << std::endl;
+	return (pathMismatches == 0 && hashChanged == 0) ? 0 : 1;
+}
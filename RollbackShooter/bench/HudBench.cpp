@@ -0,0 +1,231 @@
+//headless benchmark of building the networked HUD text every frame, the way the game did it with std::ostringstream
+//and std::string copies against the fixed char arrays and the frame arena in FrameArena.hpp
+//the diagnostics get filled in like publishNetFrame() does on the sim thread and the HUD put together like
+//NetworkedMain() does on the render thread, diagnostics on, from numbers that change every frame
+//operator new is counted (RBST_COUNT_ALLOCATIONS), and both have to build the same text every frame
+//usage: rbst_hudbench [-frames N]
+
+#define RBST_COUNT_ALLOCATIONS
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+//-----
+#include "FrameArena.hpp"
+#include "bench/BenchCommon.hpp"
+
+thread_local long threadAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+	threadAllocations++;
+	void* memory = std::malloc(size > 0 ? size : 1);
+	if (memory == NULL) throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+//what publishNetFrame() reads, made up
+struct HudStats
+{
+	double simHz, lateMean, lateWorst, sampleHz, inputMean, inputWorst;
+	int rollbackFrames, rollbackWorst;
+	long timesyncs;
+	double stretchedMs, frameSd;
+	int delay; double target; int changes;
+	int inUse, peak;
+	size_t spectators;
+	double idleTime;
+	int fps;
+};
+
+HudStats frameStats(long frame)
+{
+	HudStats stats;
+	stats.simHz = 60 - (frame % 3) * 0.5;
+	stats.lateMean = 0.25 + (frame % 17) / 64.0;
+	stats.lateWorst = 1.5 + (frame % 29) / 8.0;
+	stats.sampleHz = 998 + frame % 5;
+	stats.inputMean = 0.5 + (frame % 11) / 32.0;
+	stats.inputWorst = 2 + (frame % 7) / 4.0;
+	stats.rollbackFrames = static_cast<int>(frame * 3 / 2);
+	stats.rollbackWorst = static_cast<int>(1 + frame % 8);
+	stats.timesyncs = frame / 300;
+	stats.stretchedMs = frame * 0.0625;
+	stats.frameSd = 0.1 + (frame % 13) / 100.0;
+	stats.delay = static_cast<int>(frame / 600 % 3);
+	stats.target = 2;
+	stats.changes = static_cast<int>(frame / 600);
+	stats.inUse = static_cast<int>(2 + frame % 6);
+	stats.peak = 9;
+	stats.spectators = frame / 400;
+	stats.idleTime = 0.004 + (frame % 9) / 10000.0;
+	stats.fps = static_cast<int>(59 + frame % 3);
+	return stats;
+}
+
+const int SAVE_SLOTS = 16;
+const char* CONNECTION = "[NET]Succesfully synchronized!\n[NET]Succesfully connected!\n";
+
+//NetFrame's text as it was
+struct StringFrame
+{
+	std::string diagnostics;
+	std::string connection;
+};
+
+void stringPublish(StringFrame* frame, const HudStats* stats, const std::string* connectionString)
+{
+	std::ostringstream diagnosticsOSS;
+	diagnosticsOSS << "Sim: " << stats->simHz << " Hz, tick late " << stats->lateMean << " ms mean, "
+		<< stats->lateWorst << " ms worst" << std::endl;
+	diagnosticsOSS << "Input: " << stats->sampleHz << " samples/s, " << stats->inputMean << " ms mean to simulate, "
+		<< stats->inputWorst << " ms worst" << std::endl;
+	diagnosticsOSS << "Rollbacked frames:" << stats->rollbackFrames << "f" << std::endl;
+	diagnosticsOSS << "Worst rollback: " << stats->rollbackWorst << "f" << std::endl;
+	diagnosticsOSS << "Pacing: " << "spread" << ", " << stats->timesyncs << " timesyncs, "
+		<< stats->stretchedMs << " ms given back, frame time sd " << stats->frameSd << " ms" << std::endl;
+	diagnosticsOSS << "Input delay: " << stats->delay << "f (target mean rollback " << stats->target << "f, " << stats->changes << " changes)" << std::endl;
+	diagnosticsOSS << "Save slots: " << stats->inUse << " in use, " << stats->peak << " peak of " << SAVE_SLOTS << std::endl;
+	if (stats->spectators > 0) diagnosticsOSS << "Spectators: " << stats->spectators << std::endl;
+	frame->diagnostics = diagnosticsOSS.str();
+	frame->connection = *connectionString;
+}
+
+void stringHud(std::ostringstream* gameInfoOSS, const StringFrame* frame, const HudStats* stats)
+{
+	gameInfoOSS->str("");
+	*gameInfoOSS << "FPS: " << stats->fps << std::endl;
+	*gameInfoOSS << "Semaphore idle time: " << stats->idleTime * 1000 << " ms" << std::endl;
+	*gameInfoOSS << frame->diagnostics;
+	*gameInfoOSS << frame->connection;
+}
+
+//and as it is now
+struct ArrayFrame
+{
+	char diagnostics[1024];
+	char connection[512];
+};
+
+void arrayPublish(ArrayFrame* frame, const HudStats* stats, const std::string* connectionString)
+{
+	char* text = frame->diagnostics;
+	size_t size = sizeof(frame->diagnostics);
+	text[0] = '\0';
+	appendText(text, size, "Sim: %g Hz, tick late %g ms mean, %g ms worst\n", stats->simHz, stats->lateMean, stats->lateWorst);
+	appendText(text, size, "Input: %g samples/s, %g ms mean to simulate, %g ms worst\n", stats->sampleHz, stats->inputMean, stats->inputWorst);
+	appendText(text, size, "Rollbacked frames:%df\n", stats->rollbackFrames);
+	appendText(text, size, "Worst rollback: %df\n", stats->rollbackWorst);
+	appendText(text, size, "Pacing: %s, %ld timesyncs, %g ms given back, frame time sd %g ms\n",
+		"spread", stats->timesyncs, stats->stretchedMs, stats->frameSd);
+	appendText(text, size, "Input delay: %df (target mean rollback %gf, %d changes)\n", stats->delay, stats->target, stats->changes);
+	appendText(text, size, "Save slots: %d in use, %d peak of %d\n", stats->inUse, stats->peak, SAVE_SLOTS);
+	if (stats->spectators > 0) appendText(text, size, "Spectators: %zu\n", stats->spectators);
+	frame->connection[0] = '\0';
+	appendText(frame->connection, sizeof(frame->connection), "%s", connectionString->c_str());
+}
+
+FrameString arenaHud(FrameArena* arena, const ArrayFrame* frame, const HudStats* stats)
+{
+	FrameString gameInfo = frameString(arena);
+	appendf(&gameInfo, "FPS: %d\n", stats->fps);
+	appendf(&gameInfo, "Semaphore idle time: %g ms\n", stats->idleTime * 1000);
+	gameInfo += frame->diagnostics;
+	gameInfo += frame->connection;
+	return gameInfo;
+}
+
+struct HudRun
+{
+	double publishSeconds = 0;
+	double hudSeconds = 0;
+	long allocations = 0;
+	size_t bytes = 0;
+};
+
+int main(int argc, char* argv[])
+{
+	long frames = 100000;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else
+		{
+			std::cerr << "usage: rbst_hudbench [-frames N]" << std::endl;
+			return 1;
+		}
+	}
+	std::string connectionString = CONNECTION;
+
+	HudRun stringRun;
+	HudRun arenaRun;
+	bool same = true;
+	StringFrame stringFrame;
+	std::ostringstream gameInfoOSS;
+	ArrayFrame arrayFrame;
+	FrameArena arena;
+	for (long frame = 0; frame < frames; frame++)
+	{
+		HudStats stats = frameStats(frame);
+
+		long counted = threadAllocations;
+		BenchClock::time_point start = BenchClock::now();
+		stringPublish(&stringFrame, &stats, &connectionString);
+		stringRun.publishSeconds += secondsSince(start);
+		start = BenchClock::now();
+		stringHud(&gameInfoOSS, &stringFrame, &stats);
+		std::string stringText = gameInfoOSS.str();
+		stringRun.hudSeconds += secondsSince(start);
+		stringRun.allocations += threadAllocations - counted;
+		stringRun.bytes += stringText.size();
+
+		counted = threadAllocations;
+		start = BenchClock::now();
+		arrayPublish(&arrayFrame, &stats, &connectionString);
+		arenaRun.publishSeconds += secondsSince(start);
+		start = BenchClock::now();
+		resetArena(&arena);
+		FrameString arenaText = arenaHud(&arena, &arrayFrame, &stats);
+		arenaRun.hudSeconds += secondsSince(start);
+		arenaRun.allocations += threadAllocations - counted;
+		arenaRun.bytes += arenaText.size();
+
+		same = same && stringText.size() == arenaText.size() && memcmp(stringText.data(), arenaText.data(), arenaText.size()) == 0;
+	}
+	std::cout << frames << " frames of HUD text, about " << arenaRun.bytes / frames << " bytes each; ns and allocations per frame" << std::endl;
+	std::cout << std::setw(8) << ""
+		<< std::setw(10) << "publish"
+		<< std::setw(8) << "HUD"
+		<< std::setw(8) << "total"
+		<< std::setw(9) << "allocs" << std::endl;
+	const char* names[] = { "ostream", "arena" };
+	const HudRun* runs[] = { &stringRun, &arenaRun };
+	for (int i = 0; i < 2; i++)
+	{
+		const HudRun* run = runs[i];
+		std::cout << std::setw(8) << names[i] << std::fixed << std::setprecision(0)
+			<< std::setw(10) << run->publishSeconds * 1e9 / frames
+			<< std::setw(8) << run->hudSeconds * 1e9 / frames
+			<< std::setw(8) << (run->publishSeconds + run->hudSeconds) * 1e9 / frames
+			<< std::setprecision(2) << std::setw(9) << static_cast<double>(run->allocations) / frames << std::endl;
+	}
+	double speedup = (stringRun.publishSeconds + stringRun.hudSeconds) / (arenaRun.publishSeconds + arenaRun.hudSeconds);
+	std::cout << "speedup " << std::setprecision(2) << speedup << "x, " << (same ? "identical" : "MISMATCH") << " text" << std::endl;
+	return (same && arenaRun.allocations == 0) ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+//headless benchmark: two rollback peers playing a replay to each other over emulated connections
+//each peer feeds its own player's inputs from the replay, the link in between delays, jitters, reorders and drops packets,
+//and both peers have to end on the same state as simulating the replay offline
+//per network profile it reports rollbacks, resimulated frames, stalls and the CPU time spent
+//usage: rbst_netbench [-frames N] [-seed S] replay.rbst
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "Transport.hpp"
+#include "NetEmulator.hpp"
+#include "RollbackPeer.hpp"
+#include "bench/BenchCommon.hpp"
+
+const double TICK_MS = 1000.0 / 60.0;
+
+struct NetRun
+{
+	bool settled = false;
+	bool same = false;
+	long ticks = 0;
+	double cpuSeconds = 0;
+	PeerStats stats[2];
+	long dropped = 0;
+	long sent = 0;
+};
+
+NetRun runMatch(const LoadedReplay* replay, long frames, const NetProfile* profile, std::uint32_t seed, std::uint32_t offlineHash)
+{
+	NetRun run;
+	NetEmulator* emulator = new NetEmulator();
+	resetEmulator(emulator, profile, seed);
+	RollbackPeer* peers[2] = { new RollbackPeer(), new RollbackPeer() };
+	for (int side = 0; side < 2; side++)
+	{
+		resetPeer(peers[side], &replay->cfg, side, emulatorTransport(emulator, side));
+	}
+	//give up at some point rather than spin forever if the peers can't settle
+	long tickLimit = frames * 4 + 600;
+	std::clock_t start = std::clock();
+	while (run.ticks < tickLimit)
+	{
+		advanceEmulator(emulator, TICK_MS);
+		for (int side = 0; side < 2; side++)
+		{
+			RollbackPeer* peer = peers[side];
+			if (peer->state.frame < frames)
+			{
+				PlayerInput local = replay->inputs[peer->state.frame].players[side];
+				peerTick(peer, &local);
+			}
+			else peerTick(peer, NULL);
+		}
+		(run.ticks)++;
+		if (peerSettled(peers[0], frames) && peerSettled(peers[1], frames))
+		{
+			run.settled = true;
+			break;
+		}
+	}
+	run.cpuSeconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+	run.same = stateHash(&peers[0]->state) == offlineHash && stateHash(&peers[1]->state) == offlineHash;
+	for (int side = 0; side < 2; side++)
+	{
+		run.stats[side] = peers[side]->stats;
+		run.sent += emulator->links[side].sent;
+		run.dropped += emulator->links[side].dropped;
+		delete peers[side];
+	}
+	delete emulator;
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 0;
+	std::uint32_t seed = 1;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+			seed = static_cast<std::uint32_t>(atoi(argv[++i]));
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_netbench [-frames N] [-seed S] replay.rbst" << std::endl;
+		return 1;
+	}
+	if (frames == 0 || frames > static_cast<long>(replay.inputs.size())) frames = static_cast<long>(replay.inputs.size());
+
+	std::uint32_t offlineHash = offlineStateHash(&replay, frames);
+
+	std::cout << replay.fileName << ", " << frames << " frames, seed " << seed << std::endl;
+	std::cout << std::left << std::setw(18) << "profile" << std::right
+		<< std::setw(10) << "rollbacks"
+		<< std::setw(10) << "resim f"
+		<< std::setw(8) << "worst"
+		<< std::setw(8) << "stalls"
+		<< std::setw(8) << "loss"
+		<< std::setw(10) << "cpu ms"
+		<< std::setw(12) << "us/frame"
+		<< "  result" << std::endl;
+	bool allSame = true;
+	for (const NetProfile& profile : NET_PROFILES)
+	{
+		NetRun run = runMatch(&replay, frames, &profile, seed, offlineHash);
+		bool ok = run.settled && run.same;
+		allSame = allSame && ok;
+		long rollbacks = run.stats[0].rollbacks + run.stats[1].rollbacks;
+		long resimulated = run.stats[0].resimulated + run.stats[1].resimulated;
+		long worst = std::max(run.stats[0].worstRollback, run.stats[1].worstRollback);
+		long stalls = run.stats[0].stalls + run.stats[1].stalls;
+		std::cout << std::left << std::setw(18) << profile.name << std::right
+			<< std::setw(10) << rollbacks
+			<< std::setw(10) << resimulated
+			<< std::setw(8) << worst
+			<< std::setw(8) << stalls
+			<< std::setw(7) << std::fixed << std::setprecision(1) << 100.0 * run.dropped / std::max(1L, run.sent) << "%"
+			<< std::setw(10) << run.cpuSeconds * 1000
+			<< std::setw(12) << std::setprecision(2) << run.cpuSeconds * 1e6 / (2 * frames)
+			<< "  " << (!run.settled ? "DIDN'T SETTLE" : run.same ? "identical" : "MISMATCH") << std::endl;
+	}
+	return allSame ? 0 : 1;
+}
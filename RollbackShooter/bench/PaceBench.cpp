@@ -0,0 +1,148 @@
+//headless comparison of the two ways FramePacer.hpp pays back time when this side runs ahead of the other
+//two peers' frame loops are played out on a shared clock: one starts a few frames ahead and its clock runs a little fast,
+//the other keeps 60 FPS; the one ahead measures its advantage the way GGPO does (averaged over the last 40 frames)
+//and gets a timesync event when it's 3 or more frames ahead, checked every 240 frames, like GGPO's defaults
+//for each mode it reports how much the frame times vary, the worst frame, how many frames ran 1ms or more long
+//(the ones a player can see), and how far ahead the fast peer got over the match
+//usage: rbst_pacebench [-frames N] [-drift F] [-offset N] [-stretch MS]
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+//-----
+#include "FramePacer.hpp"
+
+//GGPO's FRAME_WINDOW_SIZE, RECOMMENDATION_INTERVAL and MIN_FRAME_ADVANTAGE
+const int ADVANTAGE_WINDOW = 40;
+const int TIMESYNC_INTERVAL = 240;
+const int TIMESYNC_MIN_AHEAD = 3;
+
+struct PacePeer
+{
+	FramePacer pacer;
+	//how much faster than real time its clock runs
+	double speed = 1;
+	double nextAt = 0;
+	long frame = 0;
+	double window[ADVANTAGE_WINDOW] = {};
+	//frame times as they really came out
+	long frames = 0;
+	double total = 0;
+	double totalSquares = 0;
+	double worst = 0;
+	long hitches = 0;
+};
+
+struct PaceRun
+{
+	double stdDevMs[2] = {};
+	double worstMs[2] = {};
+	long hitches[2] = {};
+	double meanAhead = 0;
+	double worstAhead = 0;
+	long timesyncs = 0;
+};
+
+PaceRun runPace(PacingMode mode, long frames, double drift, int offset, double maxStretchMs)
+{
+	PacePeer peers[2];
+	for (int side = 0; side < 2; side++)
+	{
+		resetPacer(&peers[side].pacer, mode, maxStretchMs);
+	}
+	peers[0].speed = 1 + drift;
+	peers[0].frame = offset;
+	PaceRun run;
+	double aheadTotal = 0;
+	long aheadSamples = 0;
+	while (peers[0].frame < frames + offset && peers[1].frame < frames)
+	{
+		int side = (peers[0].nextAt <= peers[1].nextAt) ? 0 : 1;
+		PacePeer* peer = &peers[side];
+		PacePeer* other = &peers[side ^ 1];
+		peer->window[peer->frame % ADVANTAGE_WINDOW] = static_cast<double>(peer->frame - other->frame);
+		double ahead = 0;
+		for (int i = 0; i < ADVANTAGE_WINDOW; i++)
+		{
+			ahead += peer->window[i];
+		}
+		ahead /= ADVANTAGE_WINDOW;
+		if (peer->frame % TIMESYNC_INTERVAL == 0 && ahead >= TIMESYNC_MIN_AHEAD)
+			pacerTimesync(&peer->pacer, static_cast<int>(ahead));
+		double frameMs = pacerFrameMs(&peer->pacer, ahead) / peer->speed;
+		peer->nextAt += frameMs;
+		(peer->frame)++;
+		(peer->frames)++;
+		peer->total += frameMs;
+		peer->totalSquares += frameMs * frameMs;
+		peer->worst = std::max(peer->worst, frameMs);
+		if (frameMs >= FRAME_MS + 1) (peer->hitches)++;
+		if (side == 0)
+		{
+			double lead = static_cast<double>(peer->frame - other->frame);
+			aheadTotal += std::fabs(lead);
+			aheadSamples++;
+			run.worstAhead = std::max(run.worstAhead, lead);
+		}
+	}
+	for (int side = 0; side < 2; side++)
+	{
+		const PacePeer* peer = &peers[side];
+		double mean = peer->total / peer->frames;
+		run.stdDevMs[side] = std::sqrt(std::max(0.0, peer->totalSquares / peer->frames - mean * mean));
+		run.worstMs[side] = peer->worst;
+		run.hitches[side] = peer->hitches;
+		run.timesyncs += peer->pacer.timesyncs;
+	}
+	run.meanAhead = aheadTotal / std::max(1L, aheadSamples);
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 14400;
+	double drift = 0.001;
+	int offset = 4;
+	double maxStretchMs = PACER_MAX_STRETCH_MS;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-drift") == 0 && i + 1 < argc)
+			drift = atof(argv[++i]);
+		else if (strcmp(argv[i], "-offset") == 0 && i + 1 < argc)
+			offset = std::max(0, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-stretch") == 0 && i + 1 < argc)
+			maxStretchMs = atof(argv[++i]);
+		else
+		{
+			std::cerr << "usage: rbst_pacebench [-frames N] [-drift F] [-offset N] [-stretch MS]" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << frames << " frames, the fast peer starts " << offset << " frames ahead with its clock "
+		<< std::fixed << std::setprecision(2) << drift * 100 << "% fast, stretching up to " << maxStretchMs << "ms" << std::endl;
+	std::cout << std::left << std::setw(10) << "pacing" << std::right
+		<< std::setw(20) << "frame sd ms (f/s)"
+		<< std::setw(20) << "worst ms (f/s)"
+		<< std::setw(14) << "long frames"
+		<< std::setw(12) << "mean ahead"
+		<< std::setw(8) << "worst"
+		<< std::setw(11) << "timesyncs" << std::endl;
+	const PacingMode modes[] = { PacingMode::Penalty, PacingMode::Spread };
+	const char* names[] = { "penalty", "spread" };
+	for (int m = 0; m < 2; m++)
+	{
+		PaceRun run = runPace(modes[m], frames, drift, offset, maxStretchMs);
+		std::cout << std::left << std::setw(10) << names[m] << std::right << std::setprecision(3)
+			<< std::setw(14) << run.stdDevMs[0] << "/" << std::setw(5) << run.stdDevMs[1]
+			<< std::setprecision(2) << std::setw(14) << run.worstMs[0] << "/" << std::setw(5) << run.worstMs[1]
+			<< std::setw(14) << run.hitches[0] + run.hitches[1]
+			<< std::setw(12) << run.meanAhead
+			<< std::setprecision(0) << std::setw(8) << run.worstAhead
+			<< std::setw(11) << run.timesyncs << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,367 @@
+//headless benchmark of the particle storage with thousands of particles alive, the std::vectors of particle structs
+//the game used to keep against the pools in ParticlePool.hpp
+//every frame a batch of events of each kind comes in, enough that about N of each are alive once the first ones start
+//expiring, and each frame is timed in three parts like the game does them: aging and spawning (the sim thread),
+//copying out for the renderer (publishNetFrame) and walking what the renderer reads, sub particles included
+//both have to end with the same particles
+//usage: rbst_particlebench [-frames N]
+//build with RBST_MAX_PARTICLES of at least 8192, the CMake target already does
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "SecondarySim.hpp"
+#include "bench/BenchCommon.hpp"
+
+//the particles as they were
+struct BasicParticle
+{
+	long frame; int lifetime; Vec2 pos; std::uint64_t id;
+};
+struct SidedParticle
+{
+	long frame; int lifetime; Vec2 pos; std::uint8_t owner; std::uint64_t id;
+};
+struct HitscanParticle
+{
+	long frame; int lifetime; Vec2 pos; Vec2 dir; std::uint8_t owner; std::uint64_t id;
+};
+struct EffectParticle
+{
+	long frame; int lifetime; Vec2 pos; std::array<Vector4, 10> subParts; std::uint64_t id;
+};
+
+struct VectorParticles
+{
+	std::vector<SidedParticle> projs;
+	std::vector<BasicParticle> combos;
+	std::vector<EffectParticle> grazes;
+	std::vector<EffectParticle> alerts;
+	std::vector<HitscanParticle> hitscans;
+};
+
+std::array<Vector4, 10> vectorSubParts()
+{
+	std::array<Vector4, 10> subParts;
+	createSubParts(subParts.data());
+	return subParts;
+}
+
+//increaseParticleLifetime as it was
+void vectorLifetime(VectorParticles* particles)
+{
+	for (size_t it = 0; it < particles->projs.size();)
+	{
+		particles->projs.at(it).lifetime++;
+		if (particles->projs.at(it).lifetime > 60)
+			particles->projs.erase(particles->projs.begin() + it);
+		else
+			it++;
+	}
+	for (size_t it = 0; it < particles->combos.size();)
+	{
+		particles->combos.at(it).lifetime++;
+		if (particles->combos.at(it).lifetime > 60)
+			particles->combos.erase(particles->combos.begin() + it);
+		else
+			it++;
+	}
+	for (size_t it = 0; it < particles->grazes.size();)
+	{
+		particles->grazes.at(it).lifetime++;
+		if (particles->grazes.at(it).lifetime > 60)
+			particles->grazes.erase(particles->grazes.begin() + it);
+		else
+			it++;
+	}
+	for (size_t it = 0; it < particles->alerts.size();)
+	{
+		particles->alerts.at(it).lifetime++;
+		if (particles->alerts.at(it).lifetime > 60)
+			particles->alerts.erase(particles->alerts.begin() + it);
+		else
+			it++;
+	}
+	for (size_t it = 0; it < particles->hitscans.size();)
+	{
+		particles->hitscans.at(it).lifetime++;
+		if (particles->hitscans.at(it).lifetime > 60)
+			particles->hitscans.erase(particles->hitscans.begin() + it);
+		else
+			it++;
+	}
+}
+
+//currentFrameSecSim as it was
+void vectorSpawn(SecSimFlux* flux, VectorParticles* particles, long currFrame)
+{
+	for (auto fluxIt = flux->projs.begin(); fluxIt != flux->projs.end(); fluxIt++)
+	{
+		if (!fluxIt->associated)
+		{
+			SidedParticle part = { currFrame, 0, fluxIt->pos, fluxIt->owner, fluxIt->id };
+			particles->projs.push_back(part);
+			fluxIt->associated = true;
+		}
+	}
+	for (auto fluxIt = flux->combos.begin(); fluxIt != flux->combos.end(); fluxIt++)
+	{
+		if (!fluxIt->associated)
+		{
+			BasicParticle part = { currFrame, 0, fluxIt->pos, fluxIt->id };
+			particles->combos.push_back(part);
+			fluxIt->associated = true;
+		}
+	}
+	for (auto fluxIt = flux->grazes.begin(); fluxIt != flux->grazes.end(); fluxIt++)
+	{
+		if (!fluxIt->associated)
+		{
+			EffectParticle part = { currFrame, 0, fluxIt->pos, vectorSubParts(), fluxIt->id };
+			particles->grazes.push_back(part);
+			fluxIt->associated = true;
+		}
+	}
+	for (auto fluxIt = flux->alerts.begin(); fluxIt != flux->alerts.end(); fluxIt++)
+	{
+		if (!fluxIt->associated)
+		{
+			EffectParticle part = { currFrame, 0, fluxIt->pos, vectorSubParts(), fluxIt->id };
+			particles->alerts.push_back(part);
+			fluxIt->associated = true;
+		}
+	}
+	for (auto fluxIt = flux->hitscans.begin(); fluxIt != flux->hitscans.end(); fluxIt++)
+	{
+		if (!fluxIt->associated)
+		{
+			HitscanParticle part = { currFrame, 0, fluxIt->pos, fluxIt->dir, fluxIt->owner, fluxIt->id };
+			particles->hitscans.push_back(part);
+			fluxIt->associated = true;
+		}
+	}
+}
+
+//the math gameScene does per particle, minus the drawing, summed so none of it gets optimized out
+inline float drawnBasic(int lifetime, Vec2 pos)
+{
+	float secs = lifetime / 60.0f;
+	return static_cast<float>(pos.x) + static_cast<float>(pos.y) + std::max(0.0f, -12 * secs * secs + 4 * secs + 1);
+}
+
+inline float drawnEffect(int lifetime, Vec2 pos, const Vector4* subParts)
+{
+	float sum = 0;
+	float x = std::min(lifetime / 60.0f, 1.0f);
+	float leap = -x * x + 2 * x;
+	for (int i = 0; i < SUB_PARTS; i++)
+	{
+		sum += static_cast<float>(pos.x) + subParts[i].x * leap + subParts[i].z + static_cast<float>(pos.y) + subParts[i].y * leap + subParts[i].w;
+	}
+	return sum;
+}
+
+float drawVectors(const VectorParticles* particles)
+{
+	float sum = 0;
+	for (const SidedParticle& part : particles->projs) sum += drawnBasic(part.lifetime, part.pos);
+	for (const BasicParticle& part : particles->combos) sum += drawnBasic(part.lifetime, part.pos);
+	for (const EffectParticle& part : particles->grazes) sum += drawnEffect(part.lifetime, part.pos, part.subParts.data());
+	for (const EffectParticle& part : particles->alerts) sum += drawnEffect(part.lifetime, part.pos, part.subParts.data());
+	for (const HitscanParticle& part : particles->hitscans) sum += drawnBasic(part.lifetime, part.pos);
+	return sum;
+}
+
+float drawPool(const ParticlePool* pool)
+{
+	float sum = 0;
+	for (int i = 0; i < pool->count; i++) sum += drawnBasic(pool->lifetime[i], pool->pos[i]);
+	return sum;
+}
+
+float drawEffects(const ParticlePool* pool, const SubPartPool* subs)
+{
+	float sum = 0;
+	for (int i = 0; i < pool->count; i++) sum += drawnEffect(pool->lifetime[i], pool->pos[i], subs->parts[pool->sub[i]]);
+	return sum;
+}
+
+float drawPools(const SecSimParticles* particles)
+{
+	return drawPool(&particles->projs) + drawPool(&particles->combos) + drawEffects(&particles->grazes, &particles->subParts) +
+		drawEffects(&particles->alerts, &particles->subParts) + drawPool(&particles->hitscans);
+}
+
+//this frame's events, so that about alive of each kind are up at once
+void fillFlux(SecSimFlux* flux, long frame, int alive)
+{
+	clearFlux(flux);
+	//spread evenly over the frames of a lifetime
+	int events = static_cast<int>((frame + 1) * alive / (PARTICLE_LIFETIME + 1) - frame * alive / (PARTICLE_LIFETIME + 1));
+	for (int i = 0; i < events; i++)
+	{
+		Vec2 pos{ num_det{ (frame * 7 + i * 13) % 200 - 100 } / num_det{ 10 }, num_det{ (frame * 11 + i * 3) % 200 - 100 } / num_det{ 10 } };
+		std::uint8_t owner = static_cast<std::uint8_t>(1 + i % 2);
+		std::uint64_t id = eventId(frame, owner, static_cast<std::uint16_t>(i));
+		flux->projs.push_back({ false, pos, owner, id });
+		flux->combos.push_back({ false, pos, id });
+		flux->grazes.push_back({ false, pos, id });
+		flux->alerts.push_back({ false, pos, id });
+		flux->hitscans.push_back({ false, pos, v2::right(), owner, id });
+	}
+}
+
+struct ParticleRun
+{
+	double simSeconds = 0;
+	double copySeconds = 0;
+	double drawSeconds = 0;
+	//particles alive after each frame, summed
+	long particles = 0;
+	float drawn = 0;
+	std::uint64_t hash = 0;
+};
+
+//order free, swap and pop doesn't keep it
+std::uint64_t aliveHash(std::vector<std::uint64_t>* alive)
+{
+	std::sort(alive->begin(), alive->end());
+	FieldHash hash;
+	for (std::uint64_t part : *alive) hashField(&hash, static_cast<std::int64_t>(part));
+	return hash.value;
+}
+
+inline std::uint64_t particleKey(int kind, long frame, int lifetime, Vec2 pos)
+{
+	FieldHash hash;
+	hashField(&hash, kind);
+	hashField(&hash, frame);
+	hashField(&hash, lifetime);
+	hashField(&hash, pos);
+	return hash.value;
+}
+
+ParticleRun runVectors(int alive, long frames)
+{
+	ParticleRun run;
+	SecSimFlux flux;
+	VectorParticles* particles = new VectorParticles();
+	VectorParticles* published = new VectorParticles();
+	for (long frame = 0; frame < frames; frame++)
+	{
+		fillFlux(&flux, frame, alive);
+		BenchClock::time_point start = BenchClock::now();
+		vectorLifetime(particles);
+		vectorSpawn(&flux, particles, frame);
+		run.simSeconds += secondsSince(start);
+		start = BenchClock::now();
+		*published = *particles;
+		run.copySeconds += secondsSince(start);
+		start = BenchClock::now();
+		run.drawn += drawVectors(published);
+		run.drawSeconds += secondsSince(start);
+		run.particles += static_cast<long>(particles->projs.size() + particles->combos.size() + particles->grazes.size() + particles->alerts.size() + particles->hitscans.size());
+	}
+	std::vector<std::uint64_t> keys;
+	for (const SidedParticle& part : particles->projs) keys.push_back(particleKey(0, part.frame, part.lifetime, part.pos));
+	for (const BasicParticle& part : particles->combos) keys.push_back(particleKey(1, part.frame, part.lifetime, part.pos));
+	for (const EffectParticle& part : particles->grazes) keys.push_back(particleKey(2, part.frame, part.lifetime, part.pos));
+	for (const EffectParticle& part : particles->alerts) keys.push_back(particleKey(3, part.frame, part.lifetime, part.pos));
+	for (const HitscanParticle& part : particles->hitscans) keys.push_back(particleKey(4, part.frame, part.lifetime, part.pos));
+	run.hash = aliveHash(&keys);
+	delete published;
+	delete particles;
+	return run;
+}
+
+void poolKeys(std::vector<std::uint64_t>* keys, int kind, const ParticlePool* pool)
+{
+	for (int i = 0; i < pool->count; i++) keys->push_back(particleKey(kind, pool->frame[i], pool->lifetime[i], pool->pos[i]));
+}
+
+ParticleRun runPools(int alive, long frames)
+{
+	ParticleRun run;
+	SecSimFlux flux;
+	SecSimParticles* particles = new SecSimParticles();
+	SecSimParticles* published = new SecSimParticles();
+	for (long frame = 0; frame < frames; frame++)
+	{
+		fillFlux(&flux, frame, alive);
+		BenchClock::time_point start = BenchClock::now();
+		increaseParticleLifetime(particles);
+		currentFrameSecSim(&flux, particles, frame);
+		run.simSeconds += secondsSince(start);
+		start = BenchClock::now();
+		copySecSim(published, particles);
+		run.copySeconds += secondsSince(start);
+		start = BenchClock::now();
+		run.drawn += drawPools(published);
+		run.drawSeconds += secondsSince(start);
+		run.particles += particleCount(particles);
+	}
+	std::vector<std::uint64_t> keys;
+	poolKeys(&keys, 0, &particles->projs);
+	poolKeys(&keys, 1, &particles->combos);
+	poolKeys(&keys, 2, &particles->grazes);
+	poolKeys(&keys, 3, &particles->alerts);
+	poolKeys(&keys, 4, &particles->hitscans);
+	run.hash = aliveHash(&keys);
+	delete published;
+	delete particles;
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 1200;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else
+		{
+			std::cerr << "usage: rbst_particlebench [-frames N]" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << frames << " frames, up to " << MAX_PARTICLES << " particles of each of the 5 kinds; ns per frame" << std::endl;
+	std::cout << std::setw(7) << "alive"
+		<< std::setw(13) << "vector sim"
+		<< std::setw(10) << "pool sim"
+		<< std::setw(13) << "vector copy"
+		<< std::setw(11) << "pool copy"
+		<< std::setw(13) << "vector draw"
+		<< std::setw(11) << "pool draw"
+		<< std::setw(10) << "speedup"
+		<< "  result" << std::endl;
+	const int alives[] = { 16, 256, 1024, 4096, 8192 };
+	bool allSame = true;
+	for (int alive : alives)
+	{
+		if (alive > MAX_PARTICLES) break;
+		ParticleRun vectorRun = runVectors(alive, frames);
+		ParticleRun poolRun = runPools(alive, frames);
+		bool same = vectorRun.hash == poolRun.hash && vectorRun.particles == poolRun.particles;
+		allSame = allSame && same;
+		double vectorTotal = vectorRun.simSeconds + vectorRun.copySeconds + vectorRun.drawSeconds;
+		double poolTotal = poolRun.simSeconds + poolRun.copySeconds + poolRun.drawSeconds;
+		std::cout << std::setw(7) << poolRun.particles / frames << std::fixed << std::setprecision(0)
+			<< std::setw(13) << vectorRun.simSeconds * 1e9 / frames
+			<< std::setw(10) << poolRun.simSeconds * 1e9 / frames
+			<< std::setw(13) << vectorRun.copySeconds * 1e9 / frames
+			<< std::setw(11) << poolRun.copySeconds * 1e9 / frames
+			<< std::setw(13) << vectorRun.drawSeconds * 1e9 / frames
+			<< std::setw(11) << poolRun.drawSeconds * 1e9 / frames
+			<< std::setprecision(2) << std::setw(9) << vectorTotal / poolTotal << "x"
+			<< "  " << (same ? "identical" : "MISMATCH") << std::endl;
+	}
+	return allSame ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+//headless benchmark: simulate() cost per frame for free-for-all matches of 2 up to MAX_PLAYERS players
+//the replay only provides the config, every player is a bot pressing random inputs from a fixed seed
+//each size runs twice and both runs have to end in the same state
+//usage: rbst_playerbench [-frames N] replay.rbst
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "bench/BenchCommon.hpp"
+
+struct BenchRun
+{
+	double seconds = 0;
+	std::uint64_t hash = 0;
+	long rounds = 0;
+};
+
+//small LCG so both runs press exactly the same buttons
+inline std::uint32_t nextRandom(std::uint32_t* seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return *seed >> 8;
+}
+
+//bots hold an input for a few frames like a person would, mostly moving and shooting
+struct Bot
+{
+	PlayerInput input;
+	int holdFrames = 0;
+};
+
+void stepBot(Bot* bot, std::uint32_t* seed)
+{
+	if (--(bot->holdFrames) > 0) return;
+	bot->holdFrames = 4 + nextRandom(seed) % 20;
+	std::uint32_t atk = nextRandom(seed) % 16;
+	bot->input.atk = atk < 8 ? None : atk < 13 ? Shot : atk < 15 ? Dash : AltShot;
+	bot->input.mov = static_cast<MoveInput>(1 + nextRandom(seed) % 9);
+	bot->input.mouse = num_det::from_raw_value(static_cast<std::int32_t>(nextRandom(seed) % 8192) - 4096);
+}
+
+BenchRun runLobby(const Config* cfg, int playerCount, long frames)
+{
+	BenchRun run;
+	GameState state = initialState(cfg, playerCount);
+	SecSimFlux flux;
+	Bot bots[MAX_PLAYERS];
+	InputData input;
+	std::uint32_t seed = 12345;
+	auto start = BenchClock::now();
+	for (long frame = 0; frame < frames; frame++)
+	{
+		for (int i = 0; i < playerCount; i++)
+		{
+			stepBot(&bots[i], &seed);
+			input.players[i] = bots[i].input;
+		}
+		RoundPhase phase = state.phase;
+		simulate(&state, &flux, cfg, input);
+		clearFlux(&flux);
+		if (phase == RoundPhase::Play && state.phase == RoundPhase::End) (run.rounds)++;
+		if (endCondition(&state, cfg))
+		{
+			state = initialState(cfg, playerCount);
+		}
+	}
+	run.seconds = secondsSince(start);
+	run.hash = hashGameState(&state);
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 60000;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			frames = std::max(1, atoi(argv[++i]));
+			continue;
+		}
+		fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName))
+	{
+		std::cerr << "usage: rbst_playerbench [-frames N] replay.rbst" << std::endl;
+		return 1;
+	}
+
+	std::cout << replay.fileName << " config, " << frames << " frames per run" << std::endl;
+	std::cout << std::setw(8) << "players"
+		<< std::setw(12) << "ns/f"
+		<< std::setw(16) << "ns/f/player"
+		<< std::setw(10) << "rounds"
+		<< "  result" << std::endl;
+	bool allSame = true;
+	for (int players = 2; players <= static_cast<int>(MAX_PLAYERS); players++)
+	{
+		BenchRun first = runLobby(&replay.cfg, players, frames);
+		BenchRun second = runLobby(&replay.cfg, players, frames);
+		bool same = first.hash == second.hash && first.rounds == second.rounds;
+		allSame = allSame && same;
+		double seconds = std::min(first.seconds, second.seconds);
+		std::cout << std::setw(8) << players
+			<< std::setw(12) << std::fixed << std::setprecision(0) << (seconds * 1e9) / frames
+			<< std::setw(16) << (seconds * 1e9) / frames / players
+			<< std::setw(10) << first.rounds
+			<< "  " << (same ? "identical" : "MISMATCH") << std::endl;
+	}
+	return allSame ? 0 : 1;
+}
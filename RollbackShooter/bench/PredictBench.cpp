@@ -0,0 +1,255 @@
+//offline benchmark for the remote input predictors in InputPredictor.hpp, run over a corpus of replays
+//every player in every replay is predicted the way a rollback peer would predict them with the inputs arriving a fixed
+//number of frames late: each late input that turns out different from what was simulated is a rollback back to its frame
+//it reports how often each predictor guesses the very next frame wrong, and the rollbacks and resimulated frames that
+//comes to at a few latencies; the n-gram model predicting a player only learns from the other players in the corpus
+//last it plays the first replay between two rollback peers over an emulated connection with each predictor,
+//where both peers have to end on the same state as simulating the replay offline
+//usage: rbst_predictbench [-order N] [-seed S] replay.rbst [more.rbst ...]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "InputPredictor.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "Transport.hpp"
+#include "NetEmulator.hpp"
+#include "RollbackPeer.hpp"
+#include "bench/BenchCommon.hpp"
+
+const double TICK_MS = 1000.0 / 60.0;
+const int HISTORY_RING = 64;
+const int LATENCIES[] = { 2, 4, 8 };
+const int LATENCY_COUNT = sizeof(LATENCIES) / sizeof(LATENCIES[0]);
+
+struct ModelRun
+{
+	long rollbacks = 0;
+	long resimulated = 0;
+	long predictions = 0;
+};
+
+//one player's inputs arriving latency frames after the frame they're for is simulated
+//every wrong one costs a whole rollback of latency frames, a real peer merges the ones that arrive together, so it's a ceiling
+ModelRun runModel(const std::vector<PlayerInputZip>& inputs, const InputPredictor* predictor, int latency)
+{
+	ModelRun run;
+	PlayerInputZip ring[HISTORY_RING];
+	PlayerInputZip used[HISTORY_RING];
+	InputHistory history{ ring, HISTORY_RING, -1 };
+	long frames = static_cast<long>(inputs.size());
+	for (long frame = 0; frame < frames; frame++)
+	{
+		long arrived = frame - latency;
+		if (arrived >= 0)
+		{
+			ring[arrived % HISTORY_RING] = inputs[arrived];
+			history.confirmed = arrived;
+			if (!sameInput(used[arrived % HISTORY_RING], inputs[arrived]))
+			{
+				(run.rollbacks)++;
+				run.resimulated += frame - arrived;
+				for (long f = arrived + 1; f < frame; f++)
+				{
+					used[f % HISTORY_RING] = predictWith(predictor, &history, f);
+					(run.predictions)++;
+				}
+			}
+		}
+		used[frame % HISTORY_RING] = predictWith(predictor, &history, frame);
+		(run.predictions)++;
+	}
+	return run;
+}
+
+long nextFrameMisses(const std::vector<PlayerInputZip>& inputs, const InputPredictor* predictor)
+{
+	PlayerInputZip ring[HISTORY_RING];
+	InputHistory history{ ring, HISTORY_RING, -1 };
+	long misses = 0;
+	for (long frame = 0; frame < static_cast<long>(inputs.size()); frame++)
+	{
+		if (!sameInput(predictWith(predictor, &history, frame), inputs[frame])) misses++;
+		ring[frame % HISTORY_RING] = inputs[frame];
+		history.confirmed = frame;
+	}
+	return misses;
+}
+
+struct PeerRun
+{
+	bool same = false;
+	long rollbacks = 0;
+	long resimulated = 0;
+};
+
+//predictors[side] is what that side uses to predict the other
+PeerRun runPeers(const LoadedReplay* replay, const NetProfile* profile, std::uint32_t seed, std::uint32_t offlineHash,
+	const InputPredictor* predictors)
+{
+	PeerRun run;
+	long frames = static_cast<long>(replay->inputs.size());
+	NetEmulator* emulator = new NetEmulator();
+	resetEmulator(emulator, profile, seed);
+	RollbackPeer* peers[2] = { new RollbackPeer(), new RollbackPeer() };
+	for (int side = 0; side < 2; side++)
+	{
+		resetPeer(peers[side], &replay->cfg, side, emulatorTransport(emulator, side));
+		peers[side]->predictor = predictors[side];
+	}
+	long tickLimit = frames * 4 + 600;
+	for (long tick = 0; tick < tickLimit; tick++)
+	{
+		advanceEmulator(emulator, TICK_MS);
+		for (int side = 0; side < 2; side++)
+		{
+			RollbackPeer* peer = peers[side];
+			if (peer->state.frame < frames)
+			{
+				PlayerInput local = replay->inputs[peer->state.frame].players[side];
+				peerTick(peer, &local);
+			}
+			else peerTick(peer, NULL);
+		}
+		if (peerSettled(peers[0], frames) && peerSettled(peers[1], frames)) break;
+	}
+	run.same = peerSettled(peers[0], frames) && peerSettled(peers[1], frames) &&
+		stateHash(&peers[0]->state) == offlineHash && stateHash(&peers[1]->state) == offlineHash;
+	for (int side = 0; side < 2; side++)
+	{
+		run.rollbacks += peers[side]->stats.rollbacks;
+		run.resimulated += peers[side]->stats.resimulated;
+		delete peers[side];
+	}
+	delete emulator;
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	int order = NgramModel{}.order;
+	std::uint32_t seed = 1;
+	std::vector<const char*> fileNames;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-order") == 0 && i + 1 < argc)
+			order = std::max(0, std::min(NGRAM_MAX_ORDER, atoi(argv[++i])));
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+			seed = static_cast<std::uint32_t>(atoi(argv[++i]));
+		else
+			fileNames.push_back(argv[i]);
+	}
+	std::vector<LoadedReplay> replays(fileNames.size());
+	bool loaded = !fileNames.empty();
+	for (size_t i = 0; i < fileNames.size() && loaded; i++)
+	{
+		loaded = loadReplay(&replays[i], fileNames[i]) && !replays[i].inputs.empty();
+	}
+	if (!loaded)
+	{
+		std::cerr << "usage: rbst_predictbench [-order N] [-seed S] replay.rbst [more.rbst ...]" << std::endl;
+		return 1;
+	}
+
+	//one stream per player per replay, duels only
+	std::vector<std::vector<PlayerInputZip>> streams;
+	long totalFrames = 0;
+	for (const LoadedReplay& replay : replays)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			std::vector<PlayerInputZip> stream;
+			for (const InputData& input : replay.inputs)
+			{
+				stream.push_back(zipInput(input.players[side]));
+			}
+			totalFrames += static_cast<long>(stream.size());
+			streams.push_back(stream);
+		}
+	}
+	std::vector<NgramModel> models(streams.size());
+	for (size_t i = 0; i < streams.size(); i++)
+	{
+		models[i].order = order;
+		for (size_t j = 0; j < streams.size(); j++)
+		{
+			if (j != i) learnNgram(&models[i], streams[j]);
+		}
+		finishNgram(&models[i]);
+	}
+
+	const int PREDICTOR_COUNT = 4;
+	InputPredictor fixedPredictors[PREDICTOR_COUNT - 1] = { repeatPredictor(), holdPredictor(), extrapolatePredictor() };
+	std::cout << replays.size() << " replays, " << streams.size() << " players, " << totalFrames << " frames of input; n-gram order "
+		<< order << ", each player predicted by a model learned from the others (" << models[0].best.size() << " contexts)" << std::endl;
+	std::cout << std::left << std::setw(21) << "predictor" << std::right << std::setw(11) << "next miss";
+	for (int l = 0; l < LATENCY_COUNT; l++)
+	{
+		std::cout << std::setw(9) << LATENCIES[l] << "f: rb%" << std::setw(8) << "resim/f";
+	}
+	std::cout << std::setw(12) << "ns/predict" << std::endl;
+
+	for (int p = 0; p < PREDICTOR_COUNT; p++)
+	{
+		long misses = 0;
+		ModelRun runs[LATENCY_COUNT];
+		long predictions = 0;
+		BenchClock::time_point start = BenchClock::now();
+		const char* name = "";
+		for (size_t s = 0; s < streams.size(); s++)
+		{
+			InputPredictor predictor = (p < PREDICTOR_COUNT - 1) ? fixedPredictors[p] : ngramPredictor(&models[s]);
+			name = predictor.name;
+			misses += nextFrameMisses(streams[s], &predictor);
+			predictions += static_cast<long>(streams[s].size());
+			for (int l = 0; l < LATENCY_COUNT; l++)
+			{
+				ModelRun run = runModel(streams[s], &predictor, LATENCIES[l]);
+				runs[l].rollbacks += run.rollbacks;
+				runs[l].resimulated += run.resimulated;
+				predictions += run.predictions;
+			}
+		}
+		double seconds = secondsSince(start);
+		std::cout << std::left << std::setw(21) << name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(10) << 100.0 * misses / totalFrames << "%";
+		for (int l = 0; l < LATENCY_COUNT; l++)
+		{
+			std::cout << std::setprecision(1) << std::setw(15) << 100.0 * runs[l].rollbacks / totalFrames
+				<< std::setprecision(3) << std::setw(8) << static_cast<double>(runs[l].resimulated) / totalFrames;
+		}
+		std::cout << std::setprecision(0) << std::setw(12) << seconds * 1e9 / predictions << std::endl;
+	}
+
+	//the first replay for real, each peer predicting the other player with a model that never saw them
+	const LoadedReplay* replay = &replays[0];
+	std::uint32_t offlineHash = offlineStateHash(replay, static_cast<long>(replay->inputs.size()));
+	const NetProfile profile = *findNetProfile("cross country");
+	std::cout << replay->fileName << " between two peers, " << profile.name << " (" << profile.delayMs << "ms, seed " << seed << ")" << std::endl;
+	bool allSame = true;
+	for (int p = 0; p < PREDICTOR_COUNT; p++)
+	{
+		InputPredictor predictors[2];
+		for (int side = 0; side < 2; side++)
+		{
+			predictors[side] = (p < PREDICTOR_COUNT - 1) ? fixedPredictors[p] : ngramPredictor(&models[side ^ 1]);
+		}
+		PeerRun run = runPeers(replay, &profile, seed, offlineHash, predictors);
+		allSame = allSame && run.same;
+		std::cout << std::left << std::setw(21) << predictors[0].name << std::right
+			<< std::setw(8) << run.rollbacks << " rollbacks" << std::setw(8) << run.resimulated << " resimulated frames  "
+			<< (run.same ? "identical" : "MISMATCH") << std::endl;
+	}
+	return allSame ? 0 : 1;
+}
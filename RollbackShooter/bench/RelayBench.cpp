@@ -0,0 +1,199 @@
+//load generator for the spectator relay: one relay and a crowd of spectators, all on real UDP sockets over loopback
+//the relay is fed a replay's inputs one frame per tick, the way a player's session would confirm them,
+//a quarter of the spectators only join halfway through and have to catch up, and packets get dropped on purpose
+//it reports the relay's CPU time per tick and per spectator, what each spectator costs in bandwidth,
+//and checks every spectator ends on the same state as simulating the replay offline
+//usage: rbst_relaybench [-spectators N] [-frames N] [-loss P] replay.rbst
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "Transport.hpp"
+#include "UdpSocket.hpp"
+#include "SpectatorRelay.hpp"
+#include "bench/BenchCommon.hpp"
+
+const double TICK_MS = 1000.0 / 60.0;
+
+//loopback never loses anything, so this does it in both directions
+struct LossyLink
+{
+	Transport inner;
+	double lossChance = 0;
+	std::uint32_t seed = 1;
+};
+
+inline bool lose(LossyLink* link)
+{
+	link->seed = link->seed * 1664525u + 1013904223u;
+	return (link->seed >> 8) / static_cast<double>(1u << 24) < link->lossChance;
+}
+
+bool lossySend(void* context, const std::uint8_t* bytes, size_t size)
+{
+	LossyLink* link = static_cast<LossyLink*>(context);
+	if (lose(link)) return true;
+	return transportSend(&link->inner, bytes, size);
+}
+
+size_t lossyReceive(void* context, std::uint8_t* bytes, size_t capacity)
+{
+	LossyLink* link = static_cast<LossyLink*>(context);
+	size_t size;
+	while ((size = transportReceive(&link->inner, bytes, capacity)) > 0)
+	{
+		if (!lose(link)) return size;
+	}
+	return 0;
+}
+
+struct BenchSpectator
+{
+	UdpSocket socket;
+	UdpLink link;
+	LossyLink lossy;
+	SpectatorClient client;
+	long joinFrame = 0;
+	bool joined = false;
+};
+
+int main(int argc, char* argv[])
+{
+	int spectatorCount = 256;
+	long frames = 0;
+	double lossChance = 0.02;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-spectators") == 0 && i + 1 < argc)
+			spectatorCount = std::max(1, std::min(RELAY_MAX_SPECTATORS, atoi(argv[++i])));
+		else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-loss") == 0 && i + 1 < argc)
+			lossChance = atof(argv[++i]);
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_relaybench [-spectators N] [-frames N] [-loss P] replay.rbst" << std::endl;
+		return 1;
+	}
+	if (frames == 0 || frames > static_cast<long>(replay.inputs.size())) frames = static_cast<long>(replay.inputs.size());
+
+	std::uint32_t offlineHash = offlineStateHash(&replay, frames);
+
+	SpectatorRelay* relay = new SpectatorRelay();
+	if (!openRelay(relay, 0, &replay.cfg))
+	{
+		std::cerr << "couldn't open the relay socket" << std::endl;
+		return 1;
+	}
+	UdpAddress relayAddress;
+	parseUdpAddress("127.0.0.1", udpLocalPort(&relay->socket), &relayAddress);
+
+	//spectators hold their own addresses, so they can't move once the transports point into them
+	std::vector<BenchSpectator*> spectators;
+	for (int s = 0; s < spectatorCount; s++)
+	{
+		BenchSpectator* spectator = new BenchSpectator();
+		if (!openUdpSocket(&spectator->socket, 0))
+		{
+			std::cerr << "couldn't open spectator socket " << s << std::endl;
+			return 1;
+		}
+		spectator->link.socket = &spectator->socket;
+		spectator->link.remote = relayAddress;
+		spectator->lossy.inner = udpTransport(&spectator->link);
+		spectator->lossy.lossChance = lossChance;
+		spectator->lossy.seed = static_cast<std::uint32_t>(s + 1);
+		Transport transport;
+		transport.context = &spectator->lossy;
+		transport.send = lossySend;
+		transport.receive = lossyReceive;
+		resetSpectator(&spectator->client, transport);
+		spectator->joinFrame = (s % 4 == 3) ? frames / 2 : 0;
+		spectators.push_back(spectator);
+	}
+
+	//the match plays out in real time as far as the relay knows, without actually waiting on the clock
+	long tickLimit = frames + 3600;
+	long ticks = 0;
+	double relaySeconds = 0;
+	double spectatorSeconds = 0;
+	int done = 0;
+	while (ticks < tickLimit && done < spectatorCount)
+	{
+		double nowMs = ticks * TICK_MS;
+		if (ticks < frames) relayConfirmedInput(relay, ticks, replay.inputs[ticks]);
+		BenchClock::time_point relayStart = BenchClock::now();
+		relayTick(relay, nowMs);
+		relaySeconds += secondsSince(relayStart);
+
+		BenchClock::time_point spectatorStart = BenchClock::now();
+		done = 0;
+		for (BenchSpectator* spectator : spectators)
+		{
+			if (ticks < spectator->joinFrame) continue;
+			spectatorTick(&spectator->client, nowMs);
+			while (stepSpectator(&spectator->client));
+			if (spectator->client.state.frame >= frames) done++;
+		}
+		spectatorSeconds += secondsSince(spectatorStart);
+		ticks++;
+	}
+
+	int same = 0;
+	long duplicates = 0;
+	for (BenchSpectator* spectator : spectators)
+	{
+		if (spectator->client.state.frame == frames && stateHash(&spectator->client.state) == offlineHash) same++;
+		duplicates += spectator->client.stats.duplicateFrames;
+		leaveRelay(&spectator->client);
+		closeUdpSocket(&spectator->socket);
+		delete spectator;
+	}
+
+	//a replay file takes the same bytes the frames packets do, minus their headers and keyframes
+	long replayBytes = 0;
+	int32_t p1LastMouse = 0, p2LastMouse = 0;
+	for (long frame = 0; frame < frames; frame++)
+	{
+		char bytes[REPLAY_INPUT_MAX_BYTES];
+		replayBytes += static_cast<long>(packReplayInput(replay.inputs[frame], &p1LastMouse, &p2LastMouse, bytes));
+	}
+	double matchSeconds = frames / 60.0;
+	double perSpectatorBytes = static_cast<double>(relay->stats.bytesSent) / spectatorCount;
+	double relayUsPerTick = relaySeconds * 1e6 / ticks;
+	std::cout << replay.fileName << ", " << frames << " frames, " << spectatorCount << " spectators ("
+		<< spectatorCount / 4 << " joining late), " << std::fixed << std::setprecision(1) << lossChance * 100 << "% loss" << std::endl;
+	std::cout << "relay: " << std::setprecision(1) << relaySeconds * 1000 << " ms over " << ticks << " ticks, "
+		<< std::setprecision(2) << relayUsPerTick << " us per tick, "
+		<< std::setprecision(3) << relayUsPerTick / spectatorCount << " us per spectator per tick" << std::endl;
+	std::cout << "  " << relay->stats.packetsSent << " packets out, " << relay->stats.encodes << " of them encoded, "
+		<< relay->stats.packetsReceived << " in, " << relay->stats.resends << " resends, " << relay->stats.timeouts << " timeouts" << std::endl;
+	std::cout << "  at that cost one core keeps up with about " << static_cast<long>(TICK_MS * 1000 / (relayUsPerTick / spectatorCount))
+		<< " spectators at 60 ticks a second" << std::endl;
+	std::cout << "per spectator: " << std::setprecision(0) << perSpectatorBytes / matchSeconds << " bytes/s, "
+		<< std::setprecision(1) << relay->stats.packetsSent / (spectatorCount * matchSeconds) << " packets/s, "
+		<< static_cast<double>(duplicates) / spectatorCount << " frames received twice on average" << std::endl;
+	std::cout << "  the replay file itself takes " << std::setprecision(0) << replayBytes / matchSeconds << " bytes/s" << std::endl;
+	std::cout << "spectators: " << std::setprecision(1) << spectatorSeconds * 1000 << " ms of receiving and simulating" << std::endl;
+	std::cout << same << "/" << spectatorCount << " spectators match the offline result" << std::endl;
+	closeRelay(relay);
+	delete relay;
+	return same == spectatorCount ? 0 : 1;
+}
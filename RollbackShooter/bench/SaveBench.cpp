@@ -0,0 +1,130 @@
+//headless benchmark: GGPO style save/load/free traffic with malloc per save against the save-state pool
+//saved states are held in a ring of MAX_PREDICTION_FRAMES + 2 like GGPO's sync does, and every few frames
+//the last frames get rolled back and simulated again, saving each one anew
+//states are saved and loaded as snapshots like GGPOController does, so the two only differ in where the bytes live
+//usage: rbst_savebench [-loops N] [-rollback F] replay.rbst
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "Snapshot.hpp"
+#include "SaveStatePool.hpp"
+#include "bench/BenchCommon.hpp"
+
+//GGPO's own ring size
+const int SAVED_FRAMES = 8 + 2;
+
+struct SavedFrames
+{
+	unsigned char* buffers[SAVED_FRAMES] = {};
+	size_t sizes[SAVED_FRAMES] = {};
+};
+
+struct BenchRun
+{
+	double seconds = 0;
+	long saves = 0;
+	long frames = 0;
+	std::uint64_t hash = 0;
+};
+
+//same as GGPO: saving over a ring entry frees whatever was there
+void saveFrame(SavedFrames* saved, SaveStatePool* pool, bool usePool, const GameState* state)
+{
+	int index = state->frame % SAVED_FRAMES;
+	if (usePool) releaseSaveState(pool, saved->buffers[index]);
+	else free(saved->buffers[index]);
+	saved->buffers[index] = usePool ? acquireSaveState(pool) : static_cast<unsigned char*>(malloc(MAX_SNAPSHOT_BYTES));
+	saved->sizes[index] = encodeSnapshot(state, saved->buffers[index], MAX_SNAPSHOT_BYTES);
+}
+
+BenchRun runReplay(const LoadedReplay* replay, SaveStatePool* pool, bool usePool, int loops, int rollback)
+{
+	BenchRun run;
+	SecSimFlux flux;
+	GameState state;
+	auto start = BenchClock::now();
+	for (int loop = 0; loop < loops; loop++)
+	{
+		SavedFrames saved;
+		resetSaveStatePool(pool);
+		state = initialState(&replay->cfg);
+		long count = static_cast<long>(replay->inputs.size());
+		for (long frame = 0; frame < count; frame++)
+		{
+			saveFrame(&saved, pool, usePool, &state);
+			(run.saves)++;
+			simulate(&state, &flux, &replay->cfg, replay->inputs[frame]);
+			clearFlux(&flux);
+			(run.frames)++;
+			//a late remote input every few frames: load an older state and catch back up
+			if (rollback > 0 && frame % 4 == 3 && frame >= rollback)
+			{
+				long target = state.frame - rollback;
+				decodeSnapshot(saved.buffers[target % SAVED_FRAMES], saved.sizes[target % SAVED_FRAMES], &state);
+				for (long redo = frame - rollback + 1; redo <= frame; redo++)
+				{
+					saveFrame(&saved, pool, usePool, &state);
+					(run.saves)++;
+					simulate(&state, &flux, &replay->cfg, replay->inputs[redo]);
+					clearFlux(&flux);
+				}
+			}
+		}
+		for (int i = 0; i < SAVED_FRAMES; i++)
+		{
+			if (usePool) releaseSaveState(pool, saved.buffers[i]);
+			else free(saved.buffers[i]);
+		}
+	}
+	run.seconds = secondsSince(start);
+	run.hash = hashGameState(&state);
+	return run;
+}
+
+int main(int argc, char* argv[])
+{
+	int loops = 20;
+	int rollback = 3;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-loops") == 0 && i + 1 < argc)
+			loops = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-rollback") == 0 && i + 1 < argc)
+			rollback = std::max(0, std::min(SAVED_FRAMES - 2, atoi(argv[++i])));
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_savebench [-loops N] [-rollback F] replay.rbst" << std::endl;
+		return 1;
+	}
+
+	//the pool is a few hundred KB with stress sized projectile counts, keep it off the stack
+	SaveStatePool* pool = new SaveStatePool();
+	BenchRun heap = runReplay(&replay, pool, false, loops, rollback);
+	BenchRun pooled = runReplay(&replay, pool, true, loops, rollback);
+	std::cout << replay.fileName << ", " << loops << " loops, " << rollback << "f rollback every 4 frames" << std::endl;
+	std::cout << std::fixed << std::setprecision(0);
+	std::cout << "malloc/free: " << (heap.seconds * 1e9) / heap.frames << " ns/f, "
+		<< std::setprecision(2) << static_cast<double>(heap.saves) / heap.frames << " saves/f" << std::endl;
+	std::cout << std::setprecision(0);
+	std::cout << "save pool:   " << (pooled.seconds * 1e9) / pooled.frames << " ns/f, peak "
+		<< pool->peak << " of " << SAVE_STATE_SLOTS << " slots, " << pool->fallbacks << " fallbacks" << std::endl;
+	bool same = heap.hash == pooled.hash;
+	std::cout << (same ? "identical" : "MISMATCH") << std::endl;
+	delete pool;
+	return same ? 0 : 1;
+}
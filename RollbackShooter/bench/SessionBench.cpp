@@ -0,0 +1,195 @@
+//headless benchmark: many rollback matches running side by side in one process, the way a match server would host them
+//every match is a pair of rollback peers on its own emulated link, ticked round robin from a single thread,
+//so nothing one match holds can leak into another; each has to end on the offline result
+//it reports the memory each match holds, fixed and in flight, and the CPU time of a tick across all of them
+//the matches are RollbackPeer pairs standing in for the game's NetSession, which needs GGPO and winsock and can't be
+//built headless; what a NetSession itself holds is reported separately, from its parts as NewNetworkedSession
+//leaves them, without GGPO's own session and the buffers of the two files it writes
+//usage: rbst_sessionbench [-sessions N] [-frames N] replay.rbst
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "SaveStatePool.hpp"
+#include "RollbackProfiler.hpp"
+#include "InputDelay.hpp"
+#include "FramePacer.hpp"
+#include "Transport.hpp"
+#include "NetEmulator.hpp"
+#include "RollbackPeer.hpp"
+#include "SpectatorRelay.hpp"
+#include "bench/BenchCommon.hpp"
+
+const double TICK_MS = 1000.0 / 60.0;
+
+struct BenchSession
+{
+	NetEmulator emulator;
+	RollbackPeer peers[2];
+	bool settled = false;
+	size_t peakInFlight = 0;
+};
+
+//what resetFluxHistory reserves
+size_t fluxHistoryHeapBytes(const SecSimFluxHistory* fluxHist)
+{
+	size_t bytes = fluxHist->index.capacity() * sizeof(FluxRef);
+	for (const SecSimFlux& flux : fluxHist->slots)
+	{
+		bytes += flux.projs.capacity() * sizeof(SidedFlux) + flux.combos.capacity() * sizeof(BasicFlux)
+			+ flux.grazes.capacity() * sizeof(BasicFlux) + flux.alerts.capacity() * sizeof(BasicFlux)
+			+ flux.hitscans.capacity() * sizeof(HitscanFlux);
+	}
+	return bytes;
+}
+
+//NetSession's members that are more than a few bytes, fixed and heap
+void printNetSessionParts()
+{
+	SecSimFluxHistory* fluxHist = new SecSimFluxHistory();
+	resetFluxHistory(fluxHist);
+	size_t fluxHeap = fluxHistoryHeapBytes(fluxHist);
+	delete fluxHist;
+	size_t relayHeap = RELAY_MAX_SPECTATORS * sizeof(RelaySpectator);
+	struct { const char* name; size_t fixed; size_t heap; } parts[] = {
+		{ "GameState", sizeof(GameState), 0 },
+		{ "flux history", sizeof(SecSimFluxHistory), fluxHeap },
+		{ "particles", sizeof(SecSimParticles), 0 },
+		{ "Config", sizeof(Config), 0 },
+		{ "save state pool", sizeof(SaveStatePool), 0 },
+		{ "profiler", sizeof(RollbackProfiler), 0 },
+		{ "delay controller", sizeof(DelayController), 0 },
+		{ "replay writer", sizeof(ReplayWriter), 0 },
+		{ "frame pacer", sizeof(FramePacer), 0 },
+	};
+	size_t fixed = 0;
+	size_t heap = 0;
+	std::cout << "a NetSession, as far as a headless build can see it (GGPO's own session and the replay and CSV file buffers not counted):" << std::endl;
+	for (const auto& part : parts)
+	{
+		std::cout << std::setw(20) << part.name << std::setw(8) << part.fixed << " bytes";
+		if (part.heap > 0) std::cout << " + " << part.heap << " on the heap";
+		std::cout << std::endl;
+		fixed += part.fixed;
+		heap += part.heap;
+	}
+	std::cout << std::setw(20) << "total" << std::setw(8) << fixed << " bytes + " << heap << " on the heap, "
+		<< std::fixed << std::setprecision(1) << (fixed + heap) / 1024.0 << " KiB" << std::endl;
+	std::cout << std::setw(20) << "relay, if hosted" << std::setw(8) << sizeof(SpectatorRelay) << " bytes + "
+		<< relayHeap << " on the heap, then " << sizeof(PlayerInputZip) * 60 << " bytes per second of match" << std::endl;
+	std::cout << std::defaultfloat;
+}
+
+int main(int argc, char* argv[])
+{
+	int sessionCount = 100;
+	long frames = 0;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-sessions") == 0 && i + 1 < argc)
+			sessionCount = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_sessionbench [-sessions N] [-frames N] replay.rbst" << std::endl;
+		return 1;
+	}
+	if (frames == 0 || frames > static_cast<long>(replay.inputs.size())) frames = static_cast<long>(replay.inputs.size());
+
+	std::uint32_t offlineHash = offlineStateHash(&replay, frames);
+
+	//the same kind of connection for all, but every match loses and delays its own packets
+	const NetProfile profile = *findNetProfile("cross country");
+
+	//sessions hold their own addresses, so they can't move once the transports point into them
+	std::vector<BenchSession*> sessions;
+	for (int s = 0; s < sessionCount; s++)
+	{
+		BenchSession* session = new BenchSession();
+		resetEmulator(&session->emulator, &profile, static_cast<std::uint32_t>(s + 1));
+		for (int side = 0; side < 2; side++)
+		{
+			resetPeer(&session->peers[side], &replay.cfg, side, emulatorTransport(&session->emulator, side));
+		}
+		sessions.push_back(session);
+	}
+
+	long tickLimit = frames * 4 + 600;
+	long ticks = 0;
+	int settledCount = 0;
+	std::clock_t start = std::clock();
+	while (ticks < tickLimit && settledCount < sessionCount)
+	{
+		for (BenchSession* session : sessions)
+		{
+			if (session->settled) continue;
+			advanceEmulator(&session->emulator, TICK_MS);
+			for (int side = 0; side < 2; side++)
+			{
+				RollbackPeer* peer = &session->peers[side];
+				if (peer->state.frame < frames)
+				{
+					PlayerInput local = replay.inputs[peer->state.frame].players[side];
+					peerTick(peer, &local);
+				}
+				else peerTick(peer, NULL);
+			}
+			size_t inFlight = session->emulator.links[0].inFlight.size() + session->emulator.links[1].inFlight.size();
+			session->peakInFlight = std::max(session->peakInFlight, inFlight);
+			if (peerSettled(&session->peers[0], frames) && peerSettled(&session->peers[1], frames))
+			{
+				session->settled = true;
+				settledCount++;
+			}
+		}
+		ticks++;
+	}
+	double cpuSeconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+	int same = 0;
+	size_t worstInFlight = 0;
+	long rollbacks = 0;
+	for (BenchSession* session : sessions)
+	{
+		if (session->settled &&
+			stateHash(&session->peers[0].state) == offlineHash &&
+			stateHash(&session->peers[1].state) == offlineHash)
+			same++;
+		worstInFlight = std::max(worstInFlight, session->peakInFlight);
+		rollbacks += session->peers[0].stats.rollbacks + session->peers[1].stats.rollbacks;
+		delete session;
+	}
+
+	size_t fixedBytes = sizeof(BenchSession);
+	size_t inFlightBytes = worstInFlight * sizeof(EmulatedPacket);
+	std::cout << replay.fileName << ", " << frames << " frames, " << sessionCount << " sessions over " << profile.name << std::endl;
+	std::cout << "per session: " << fixedBytes << " bytes fixed (2 peers of " << sizeof(RollbackPeer) << "), "
+		<< "worst " << inFlightBytes << " bytes in flight (" << worstInFlight << " packets)" << std::endl;
+	std::cout << "all sessions: " << std::fixed << std::setprecision(1) << (fixedBytes + inFlightBytes) * sessionCount / (1024.0 * 1024.0) << " MiB at most" << std::endl;
+	std::cout << ticks << " ticks, " << rollbacks << " rollbacks, "
+		<< std::setprecision(1) << cpuSeconds * 1000 << " ms CPU, "
+		<< std::setprecision(2) << cpuSeconds * 1000 / std::max(1L, ticks) << " ms per tick for every session" << std::endl;
+	std::cout << same << "/" << sessionCount << " sessions match the offline result" << std::endl;
+	std::cout << std::endl;
+	printNetSessionParts();
+	return same == sessionCount ? 0 : 1;
+}
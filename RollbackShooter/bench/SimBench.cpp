@@ -0,0 +1,78 @@
+//headless benchmark: replays .rbst files through simulate() and reports simulated frames per second
+//usage: rbst_simbench [-loops N] replay.rbst [more.rbst ...]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "bench/BenchCommon.hpp"
+
+int main(int argc, char* argv[])
+{
+	int loops = 10;
+	std::vector<LoadedReplay> replays;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-loops") == 0 && i + 1 < argc)
+		{
+			loops = std::max(1, atoi(argv[++i]));
+			continue;
+		}
+		LoadedReplay loaded;
+		if (!loadReplay(&loaded, argv[i]))
+		{
+			std::cerr << "could not open replay " << argv[i] << std::endl;
+			return 1;
+		}
+		replays.push_back(loaded);
+	}
+	if (replays.empty())
+	{
+		std::cerr << "usage: rbst_simbench [-loops N] replay.rbst [more.rbst ...]" << std::endl;
+		return 1;
+	}
+
+	long totalFrames = 0;
+	double totalSeconds = 0;
+	for (auto it = replays.begin(); it != replays.end(); it++)
+	{
+		GameState state;
+		SecSimFlux flux;
+		auto start = BenchClock::now();
+		for (int loop = 0; loop < loops; loop++)
+		{
+			state = initialState(&it->cfg);
+			for (auto inputIt = it->inputs.begin(); inputIt != it->inputs.end(); inputIt++)
+			{
+				simulate(&state, &flux, &it->cfg, *inputIt);
+				clearFlux(&flux);
+			}
+		}
+		double seconds = secondsSince(start);
+		long frames = static_cast<long>(it->inputs.size()) * loops;
+		totalFrames += frames;
+		totalSeconds += seconds;
+
+		std::cout << it->fileName << std::endl;
+		std::cout << "  frames: " << frames << " (" << it->inputs.size() << " x " << loops << ")" << std::endl;
+		std::cout << "  final score: " << state.rounds[0] << "-" << state.rounds[1] << std::endl;
+		std::cout << "  sim fps: " << frames / seconds << std::endl;
+		std::cout << "  ns/frame: " << (seconds * 1e9) / frames << std::endl;
+	}
+	if (replays.size() > 1)
+	{
+		std::cout << "total" << std::endl;
+		std::cout << "  sim fps: " << totalFrames / totalSeconds << std::endl;
+	}
+	return 0;
+}
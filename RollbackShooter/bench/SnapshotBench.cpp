@@ -0,0 +1,163 @@
+//headless benchmark: snapshot bytes per frame and encode/decode throughput, full and as deltas against the previous frame
+//every decoded snapshot is checked against the original, and simulated one more frame next to it
+//usage: rbst_snapshotbench [-loops N] replay.rbst
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "Snapshot.hpp"
+#include "bench/BenchCommon.hpp"
+
+struct EncodedFrames
+{
+	std::vector<std::uint8_t> bytes;
+	std::vector<size_t> offsets;
+	std::vector<size_t> sizes;
+};
+
+void addEncoded(EncodedFrames* frames, const std::uint8_t* bytes, size_t size)
+{
+	frames->offsets.push_back(frames->bytes.size());
+	frames->sizes.push_back(size);
+	frames->bytes.insert(frames->bytes.end(), bytes, bytes + size);
+}
+
+inline const std::uint8_t* encodedAt(const EncodedFrames* frames, size_t i)
+{
+	return frames->bytes.data() + frames->offsets[i];
+}
+
+int main(int argc, char* argv[])
+{
+	int loops = 20;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-loops") == 0 && i + 1 < argc)
+			loops = std::max(1, atoi(argv[++i]));
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_snapshotbench [-loops N] replay.rbst" << std::endl;
+		return 1;
+	}
+
+	std::vector<GameState> states;
+	{
+		SecSimFlux flux;
+		GameState state = initialState(&replay.cfg);
+		for (auto it = replay.inputs.begin(); it != replay.inputs.end(); it++)
+		{
+			simulate(&state, &flux, &replay.cfg, *it);
+			clearFlux(&flux);
+			states.push_back(state);
+		}
+	}
+	size_t count = states.size();
+
+	//full snapshots
+	EncodedFrames full;
+	std::uint8_t buffer[MAX_SNAPSHOT_BYTES];
+	auto start = BenchClock::now();
+	for (int loop = 0; loop < loops; loop++)
+	{
+		full = EncodedFrames{};
+		full.bytes.reserve(count * MAX_SNAPSHOT_BYTES);
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t size = encodeSnapshot(&states[i], buffer, sizeof(buffer));
+			addEncoded(&full, buffer, size);
+		}
+	}
+	double encodeSeconds = secondsSince(start);
+
+	GameState decoded;
+	long failures = 0;
+	start = BenchClock::now();
+	for (int loop = 0; loop < loops; loop++)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!decodeSnapshot(encodedAt(&full, i), full.sizes[i], &decoded)) failures++;
+		}
+	}
+	double decodeSeconds = secondsSince(start);
+
+	//deltas against the frame before, the first one against nothing
+	EncodedFrames deltas;
+	std::uint8_t deltaBuffer[MAX_SNAPSHOT_BYTES * 2];
+	start = BenchClock::now();
+	for (int loop = 0; loop < loops; loop++)
+	{
+		deltas = EncodedFrames{};
+		deltas.bytes.reserve(count * MAX_SNAPSHOT_BYTES);
+		for (size_t i = 0; i < count; i++)
+		{
+			const std::uint8_t* base = i > 0 ? encodedAt(&full, i - 1) : NULL;
+			size_t baseSize = i > 0 ? full.sizes[i - 1] : 0;
+			size_t size = encodeSnapshotDelta(base, baseSize, encodedAt(&full, i), full.sizes[i], deltaBuffer, sizeof(deltaBuffer));
+			addEncoded(&deltas, deltaBuffer, size);
+		}
+	}
+	double deltaEncodeSeconds = secondsSince(start);
+
+	start = BenchClock::now();
+	for (int loop = 0; loop < loops; loop++)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const std::uint8_t* base = i > 0 ? encodedAt(&full, i - 1) : NULL;
+			size_t baseSize = i > 0 ? full.sizes[i - 1] : 0;
+			size_t size = decodeSnapshotDelta(base, baseSize, encodedAt(&deltas, i), deltas.sizes[i], buffer, sizeof(buffer));
+			if (size != full.sizes[i]) failures++;
+		}
+	}
+	double deltaDecodeSeconds = secondsSince(start);
+
+	//round trips have to be the same match, and stay the same for the next frame too
+	long mismatches = 0;
+	SecSimFlux flux;
+	for (size_t i = 0; i < count; i++)
+	{
+		const std::uint8_t* base = i > 0 ? encodedAt(&full, i - 1) : NULL;
+		size_t baseSize = i > 0 ? full.sizes[i - 1] : 0;
+		size_t size = decodeSnapshotDelta(base, baseSize, encodedAt(&deltas, i), deltas.sizes[i], buffer, sizeof(buffer));
+		if (size != full.sizes[i] || memcmp(buffer, encodedAt(&full, i), size) != 0) mismatches++;
+		if (!decodeSnapshot(buffer, size, &decoded) || stateHash(&decoded) != stateHash(&states[i]))
+		{
+			mismatches++;
+			continue;
+		}
+		if (i + 1 < count)
+		{
+			simulate(&decoded, &flux, &replay.cfg, replay.inputs[i + 1]);
+			clearFlux(&flux);
+			if (stateHash(&decoded) != stateHash(&states[i + 1])) mismatches++;
+		}
+	}
+
+	long checks = static_cast<long>(count) * loops;
+	std::cout << replay.fileName << ", " << count << " frames, " << loops << " loops" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "GameState:      " << sizeof(GameState) << " bytes/frame" << std::endl;
+	std::cout << "full snapshot:  " << static_cast<double>(full.bytes.size()) / count << " bytes/frame, encode "
+		<< (encodeSeconds * 1e9) / checks << " ns, decode " << (decodeSeconds * 1e9) / checks << " ns" << std::endl;
+	std::cout << "delta snapshot: " << static_cast<double>(deltas.bytes.size()) / count << " bytes/frame, encode "
+		<< (deltaEncodeSeconds * 1e9) / checks << " ns, decode " << (deltaDecodeSeconds * 1e9) / checks << " ns" << std::endl;
+	std::cout << failures << " failed decodes, " << mismatches << " mismatched round trips" << std::endl;
+	return (failures == 0 && mismatches == 0) ? 0 : 1;
+}
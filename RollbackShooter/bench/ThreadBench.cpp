@@ -0,0 +1,345 @@
+//real time benchmark for the sim thread setup in SimThread.hpp: a replay is simulated at a fixed 60Hz and every frame is
+//handed to a pretend renderer that stalls now and then (-stallMs every -stallEvery frames, like a slow frame or a vsync hitch)
+//once with both on one thread like the game used to be, once with the sim on its own thread behind a triple buffer
+//it reports how late the ticks ran, how many frames the renderer drew or never saw, and checks every frame the renderer
+//got was whole (its hash matches the one taken when it was published) and the sim ended on the offline result
+//then the input side with the same stalls: a made up player double taps (a shot, a dash 8ms later, every 157ms so it
+//lands anywhere in a frame) and swings the mouse, and the render thread polls them once per frame it draws, or every
+//millisecond between frames too, into the queue the sim thread takes its input from; it reports presses lost, how far
+//the mouse drifted from where the player moved it (in num_det steps), how long a press waited to be polled and how long
+//a sample waited to be simulated
+//it runs in real time, about frames / 60 seconds per run
+//usage: rbst_threadbench [-frames N] [-stallEvery N] [-stallMs MS] replay.rbst
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "StateHash.hpp"
+#include "RollbackProfiler.hpp"
+#include "FramePacer.hpp"
+#include "SimThread.hpp"
+#include "bench/BenchCommon.hpp"
+
+struct BenchFrame
+{
+	GameState state;
+	std::uint32_t hash = 0;
+};
+
+struct ThreadRun
+{
+	const LoadedReplay* replay = NULL;
+	long frames = 0;
+	int stallEvery = 0;
+	double stallMs = 0;
+	GameState state;
+	BenchFrame slots[3];
+	TripleBuffer buffer;
+	std::atomic<bool> running{ true };
+	ProfileHistogram lateHist{ "tick late", "ms", 0.25 };
+	long rendered = 0;
+	long seen = 0;
+	long torn = 0;
+};
+
+void simTick(ThreadRun* run, SecSimFlux* flux)
+{
+	simulate(&run->state, flux, &run->replay->cfg, run->replay->inputs[run->state.frame]);
+	clearFlux(flux);
+	BenchFrame* frame = &run->slots[tripleWriteSlot(&run->buffer)];
+	frame->state = run->state;
+	frame->hash = stateHash(&frame->state);
+	triplePublish(&run->buffer);
+}
+
+//what the renderer does with a frame: check it, and every so often take far too long
+void renderFrame(ThreadRun* run, long* lastSeen)
+{
+	tripleRead(&run->buffer);
+	const BenchFrame* frame = &run->slots[tripleReadSlot(&run->buffer)];
+	if (stateHash(&frame->state) != frame->hash) (run->torn)++;
+	if (frame->state.frame != *lastSeen)
+	{
+		(run->seen)++;
+		*lastSeen = frame->state.frame;
+	}
+	(run->rendered)++;
+	if (run->stallEvery > 0 && run->rendered % run->stallEvery == 0)
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(run->stallMs));
+}
+
+void runOneThread(ThreadRun* run)
+{
+	SimTicker ticker;
+	startTicker(&ticker);
+	SecSimFlux flux;
+	long lastSeen = -1;
+	while (run->state.frame < run->frames)
+	{
+		tickerWait(&ticker);
+		double lateMs, intervalMs;
+		tickerTick(&ticker, FRAME_MS, &lateMs, &intervalMs);
+		addSample(&run->lateHist, lateMs);
+		simTick(run, &flux);
+		renderFrame(run, &lastSeen);
+	}
+}
+
+void simThread(ThreadRun* run)
+{
+	SimTicker ticker;
+	startTicker(&ticker);
+	SecSimFlux flux;
+	while (run->state.frame < run->frames)
+	{
+		tickerWait(&ticker);
+		double lateMs, intervalMs;
+		tickerTick(&ticker, FRAME_MS, &lateMs, &intervalMs);
+		addSample(&run->lateHist, lateMs);
+		simTick(run, &flux);
+	}
+	run->running.store(false);
+}
+
+//INPUT
+
+const double TAP_EVERY_MS = 157;
+const double TAP_GAP_MS = 8;
+//the mouse goes back and forth at up to this speed
+const double MOUSE_RAD_PER_MS = 0.002;
+const double MOUSE_SWING_MS = 400;
+
+//where the mouse has moved to since the start
+inline double deviceMouse(double atMs)
+{
+	return MOUSE_RAD_PER_MS * MOUSE_SWING_MS * (1 - cos(atMs / MOUSE_SWING_MS));
+}
+
+inline double devicePressMs(long press)
+{
+	return (press / 2) * TAP_EVERY_MS + (press % 2) * TAP_GAP_MS + 5;
+}
+
+struct InputRun
+{
+	bool everyMs = false;
+	long frames = 0;
+	int stallEvery = 0;
+	double stallMs = 0;
+	SimClock::time_point start;
+	InputQueue queue;
+	InputCollector collector;
+	std::atomic<bool> running{ true };
+	//render thread
+	double lastPollMs = 0;
+	long nextPress = 0;
+	ProfileHistogram pollHist{ "press to poll", "ms", 1 };
+	//sim thread, the mean wait of the samples each tick took
+	ProfileHistogram simHist{ "sample to simulate", "ms", 1 };
+	long received = 0;
+	num_det mouse{ 0 };
+	//where the player moved the mouse, up to the last sample that was simulated
+	double movedMouse = 0;
+};
+
+inline double msSince(SimClock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(SimClock::now() - start).count();
+}
+
+//what raylib would hand processInput now: the presses since the last poll (the last one wins), the mouse moved since
+void benchPoll(InputRun* run)
+{
+	double nowMs = msSince(run->start);
+	InputSample sample{ SimClock::now(), PolledInput{} };
+	while (devicePressMs(run->nextPress) <= nowMs)
+	{
+		sample.input.atk = (run->nextPress % 2 == 0) ? Shot : Dash;
+		addSample(&run->pollHist, nowMs - devicePressMs(run->nextPress));
+		(run->nextPress)++;
+	}
+	sample.input.mouse = deviceMouse(nowMs) - deviceMouse(run->lastPollMs);
+	//polled once a frame it's a num_det on the spot, like processInput makes it
+	if (!run->everyMs) sample.input.mouse = static_cast<double>(num_det{ sample.input.mouse });
+	run->lastPollMs = nowMs;
+	pushSample(&run->queue, &sample);
+}
+
+void inputSimThread(InputRun* run)
+{
+	SimTicker ticker;
+	startTicker(&ticker);
+	for (long frame = 0; frame < run->frames; frame++)
+	{
+		tickerWait(&ticker);
+		double lateMs, intervalMs, latencyMs;
+		tickerTick(&ticker, FRAME_MS, &lateMs, &intervalMs);
+		PlayerInput input = collectInput(&run->collector, &run->queue, &latencyMs);
+		if (latencyMs >= 0) addSample(&run->simHist, latencyMs);
+		if (input.atk != None) (run->received)++;
+		run->mouse += input.mouse;
+	}
+	run->running.store(false);
+}
+
+void runInput(InputRun* run)
+{
+	run->start = SimClock::now();
+	std::thread sim(inputSimThread, run);
+	//the two clocks are half a frame apart, in the game they're as likely to be any distance apart
+	SimTicker ticker;
+	startTicker(&ticker);
+	ticker.due += std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double, std::milli>(FRAME_MS / 2));
+	long drawn = 0;
+	while (run->running.load())
+	{
+		if (!run->everyMs) tickerWait(&ticker);
+		benchPoll(run);
+		if (run->everyMs && tickerMsLeft(&ticker) > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(INPUT_SAMPLE_MS));
+			continue;
+		}
+		double lateMs, intervalMs;
+		tickerTick(&ticker, FRAME_MS, &lateMs, &intervalMs);
+		drawn++;
+		if (run->stallEvery > 0 && drawn % run->stallEvery == 0)
+			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(run->stallMs));
+	}
+	sim.join();
+	//polled after the last tick, never simulated
+	double unsimulated = 0;
+	InputSample sample;
+	while (popSample(&run->queue, &sample))
+	{
+		unsimulated += sample.input.mouse;
+	}
+	run->movedMouse = deviceMouse(run->lastPollMs) - unsimulated;
+}
+
+void runTwoThreads(ThreadRun* run)
+{
+	//the renderer needs something to look at before the first tick, like in the game
+	BenchFrame* first = &run->slots[tripleWriteSlot(&run->buffer)];
+	first->state = run->state;
+	first->hash = stateHash(&first->state);
+	triplePublish(&run->buffer);
+	std::thread sim(simThread, run);
+	//the renderer keeps to 60 FPS too, but on its own clock
+	SimTicker ticker;
+	startTicker(&ticker);
+	long lastSeen = -1;
+	while (run->running.load())
+	{
+		tickerWait(&ticker);
+		double lateMs, intervalMs;
+		tickerTick(&ticker, FRAME_MS, &lateMs, &intervalMs);
+		renderFrame(run, &lastSeen);
+	}
+	sim.join();
+}
+
+int main(int argc, char* argv[])
+{
+	long frames = 300;
+	int stallEvery = 20;
+	double stallMs = 50;
+	const char* fileName = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			frames = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-stallEvery") == 0 && i + 1 < argc)
+			stallEvery = std::max(0, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-stallMs") == 0 && i + 1 < argc)
+			stallMs = atof(argv[++i]);
+		else
+			fileName = argv[i];
+	}
+	LoadedReplay replay;
+	if (fileName == NULL || !loadReplay(&replay, fileName) || replay.inputs.empty())
+	{
+		std::cerr << "usage: rbst_threadbench [-frames N] [-stallEvery N] [-stallMs MS] replay.rbst" << std::endl;
+		return 1;
+	}
+	if (frames > static_cast<long>(replay.inputs.size())) frames = static_cast<long>(replay.inputs.size());
+
+	std::uint32_t offlineHash = offlineStateHash(&replay, frames);
+
+	std::cout << replay.fileName << ", " << frames << " frames at 60Hz, the renderer stalls " << stallMs << "ms every "
+		<< stallEvery << " frames it draws" << std::endl;
+	std::cout << std::left << std::setw(14) << "setup" << std::right
+		<< std::setw(16) << "tick late mean"
+		<< std::setw(8) << "sd"
+		<< std::setw(9) << "worst"
+		<< std::setw(10) << "drawn"
+		<< std::setw(12) << "never seen"
+		<< std::setw(7) << "torn"
+		<< "  result" << std::endl;
+	bool allSame = true;
+	for (int threaded = 0; threaded < 2; threaded++)
+	{
+		ThreadRun* run = new ThreadRun();
+		run->replay = &replay;
+		run->frames = frames;
+		run->stallEvery = stallEvery;
+		run->stallMs = stallMs;
+		run->state = initialState(&replay.cfg);
+		if (threaded) runTwoThreads(run);
+		else runOneThread(run);
+		bool same = stateHash(&run->state) == offlineHash && run->torn == 0;
+		allSame = allSame && same;
+		std::cout << std::left << std::setw(14) << (threaded ? "sim thread" : "one thread") << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(13) << histogramMean(&run->lateHist) << " ms"
+			<< std::setw(8) << histogramStdDev(&run->lateHist)
+			<< std::setw(9) << run->lateHist.worst
+			<< std::setw(10) << run->rendered
+			<< std::setw(12) << frames - run->seen
+			<< std::setw(7) << run->torn
+			<< "  " << (same ? "identical" : "MISMATCH") << std::endl;
+		delete run;
+	}
+
+	std::cout << std::left << std::setw(14) << "polled" << std::right
+		<< std::setw(10) << "presses"
+		<< std::setw(7) << "lost"
+		<< std::setw(14) << "mouse drift"
+		<< std::setw(16) << "press to poll"
+		<< std::setw(8) << "worst"
+		<< std::setw(15) << "to simulate"
+		<< std::setw(8) << "worst" << std::endl;
+	for (int everyMs = 0; everyMs < 2; everyMs++)
+	{
+		InputRun* run = new InputRun();
+		run->everyMs = everyMs != 0;
+		run->frames = frames;
+		run->stallEvery = stallEvery;
+		run->stallMs = stallMs;
+		runInput(run);
+		long pressed = run->nextPress;
+		double drift = (static_cast<double>(run->mouse) - run->movedMouse) / static_cast<double>(num_det::from_raw_value(1));
+		std::cout << std::left << std::setw(14) << (everyMs ? "every ms" : "once a frame") << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << pressed
+			<< std::setw(7) << pressed - run->received
+			<< std::setw(14) << drift
+			<< std::setw(13) << histogramMean(&run->pollHist) << " ms"
+			<< std::setw(8) << run->pollHist.worst
+			<< std::setw(12) << histogramMean(&run->simHist) << " ms"
+			<< std::setw(8) << run->simHist.worst << std::endl;
+		delete run;
+	}
+	return allSame ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+//headless benchmark and determinism check for the table-driven trig in Math.hpp
+//compares trig::sin/cos with fpm::sin/cos over every folded angle, times both,
+//and replays the given files printing a final state hash to diff across compilers and platforms
+//usage: rbst_trigbench [replay.rbst ...]
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "Config.hpp"
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "Player.hpp"
+#include "SecondarySim.hpp"
+#include "GameState.hpp"
+#include "bench/BenchCommon.hpp"
+
+inline bool sameRotation(trig::Rotation rot, std::int32_t angleRaw)
+{
+	num_det angle = num_det::from_raw_value(angleRaw);
+	return rot.cos == fpm::cos(angle) && rot.sin == fpm::sin(angle);
+}
+
+int main(int argc, char* argv[])
+{
+	int mismatches = 0;
+	const std::int32_t twoPi = num_det::two_pi().raw_value();
+
+	//every angle fmod can hand over, which covers every int32 angle since both sides fold the same way
+	double maxError = 0;
+	for (std::int32_t raw = -twoPi + 1; raw < twoPi; raw++)
+	{
+		num_det angle = num_det::from_raw_value(raw);
+		num_det sin = trig::sin(angle);
+		if (sin != fpm::sin(angle) || trig::cos(angle) != fpm::cos(angle)) mismatches++;
+		maxError = std::max(maxError, std::fabs(static_cast<double>(sin) - std::sin(static_cast<double>(angle))));
+	}
+	std::cout << "folded angles checked: " << 2 * twoPi - 1 << ", mismatches: " << mismatches << std::endl;
+	std::cout << "max abs error against std::sin: " << maxError << std::endl;
+
+	const std::int32_t pi = num_det::pi().raw_value();
+	const std::int32_t halfPi = num_det::half_pi().raw_value();
+	int compassMismatches = !sameRotation(COMPASS_FOR_LEFT, -QUARTER_PI_RAW) +
+		!sameRotation(COMPASS_LEFT, -halfPi) +
+		!sameRotation(COMPASS_BACK_LEFT, pi + QUARTER_PI_RAW) +
+		!sameRotation(COMPASS_BACK_RIGHT, pi - QUARTER_PI_RAW) +
+		!sameRotation(COMPASS_RIGHT, halfPi) +
+		!sameRotation(COMPASS_FOR_RIGHT, QUARTER_PI_RAW);
+	std::cout << "compass rotation mismatches: " << compassMismatches << std::endl;
+	mismatches += compassMismatches;
+
+	//timing, mouse-sized angles
+	const int COUNT = 1 << 16;
+	const int LOOPS = 50;
+	std::mt19937 rng(60);
+	std::uniform_int_distribution<std::int32_t> mouseDist(-(1 << 15), 1 << 15);
+	std::vector<num_det> angles(COUNT);
+	for (int i = 0; i < COUNT; i++) angles[i] = num_det::from_raw_value(mouseDist(rng));
+	std::int64_t sink = 0;
+
+	auto start = BenchClock::now();
+	for (int l = 0; l < LOOPS; l++)
+		for (int i = 0; i < COUNT; i++) sink += fpm::sin(angles[i]).raw_value() + fpm::cos(angles[i]).raw_value();
+	double fpmNs = secondsSince(start) * 1e9 / (double(LOOPS) * COUNT);
+	start = BenchClock::now();
+	for (int l = 0; l < LOOPS; l++)
+		for (int i = 0; i < COUNT; i++) sink += trig::sin(angles[i]).raw_value() + trig::cos(angles[i]).raw_value();
+	double tableNs = secondsSince(start) * 1e9 / (double(LOOPS) * COUNT);
+	std::cout << "sin+cos: fpm " << fpmNs << " ns, table " << tableNs << " ns" << std::endl;
+
+	//read back every iteration so the compiler can't hoist the series out of the loop
+	volatile std::int32_t quarterPi = QUARTER_PI_RAW;
+	Vec2 v = v2::right();
+	start = BenchClock::now();
+	for (int l = 0; l < LOOPS * COUNT; l++)
+	{
+		num_det angle = num_det::from_raw_value(quarterPi);
+		num_det cos = fpm::cos(angle);
+		num_det sin = fpm::sin(angle);
+		v = Vec2{ (v.x * cos) - (v.y * sin), (v.x * sin) + (v.y * cos) };
+	}
+	fpmNs = secondsSince(start) * 1e9 / (double(LOOPS) * COUNT);
+	sink += v.x.raw_value();
+	v = v2::right();
+	start = BenchClock::now();
+	for (int l = 0; l < LOOPS * COUNT; l++) v = v2::rotate(v, COMPASS_FOR_RIGHT);
+	tableNs = secondsSince(start) * 1e9 / (double(LOOPS) * COUNT);
+	sink += v.x.raw_value();
+	std::cout << "compass rotate: fpm " << fpmNs << " ns, precomputed " << tableNs << " ns" << std::endl;
+	std::cout << "(checksum " << sink << ")" << std::endl;
+
+	//replay corpus: every recorded mouse turn has to agree, and the final hash is printed for cross-build diffing
+	for (int i = 1; i < argc; i++)
+	{
+		LoadedReplay replay;
+		if (!loadReplay(&replay, argv[i]))
+		{
+			std::cerr << "could not open replay " << argv[i] << std::endl;
+			return 1;
+		}
+		int replayMismatches = 0;
+		GameState state = initialState(&replay.cfg);
+		SecSimFlux flux;
+		for (auto it = replay.inputs.begin(); it != replay.inputs.end(); it++)
+		{
+			num_det turns[2] = { it->players[0].mouse, it->players[1].mouse };
+			for (num_det turn : turns)
+			{
+				if (trig::sin(turn) != fpm::sin(turn) || trig::cos(turn) != fpm::cos(turn)) replayMismatches++;
+			}
+			simulate(&state, &flux, &replay.cfg, *it);
+			clearFlux(&flux);
+		}
+		mismatches += replayMismatches;
+		std::cout << replay.fileName << ": " << replay.inputs.size() << " frames, mouse mismatches " << replayMismatches;
+		std::cout << ", final hash " << std::hex << std::setw(16) << std::setfill('0') << hashGameState(&state) << std::dec << std::endl;
+	}
+
+	std::cout << (mismatches == 0 ? "deterministic" : "MISMATCH") << std::endl;
+	return mismatches == 0 ? 0 : 1;
+}
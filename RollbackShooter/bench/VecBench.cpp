@@ -0,0 +1,169 @@
+//headless benchmark: batched v2 kernels against the one-Vec2-at-a-time v2 functions
+//checks every element for bit-exactness and reports ns per vector for both
+//rbst_vecbench_avx2 is the same bench built with -mavx2, for the AVX2 kernels the default build never uses
+//usage: rbst_vecbench [-count N] [-loops N]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+//-----
+#include "Math.hpp"
+#include "VecBatch.hpp"
+#include "bench/BenchCommon.hpp"
+
+struct Columns
+{
+	std::vector<num_det> x;
+	std::vector<num_det> y;
+
+	Vec2Columns cols() { return Vec2Columns{ x.data(), y.data() }; }
+	Vec2 at(size_t i) const { return Vec2{ x[i], y[i] }; }
+};
+
+//mostly arena-sized values, with some extremes thrown in since those are where rounding bites
+Columns randomColumns(std::mt19937* rng, size_t count)
+{
+	std::uniform_int_distribution<std::int32_t> arena(-(16 << 16), 16 << 16);
+	std::uniform_int_distribution<std::int32_t> tiny(-256, 256);
+	std::uniform_int_distribution<std::int32_t> pick(0, 9);
+	Columns c;
+	c.x.resize(count);
+	c.y.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		int kind = pick(*rng);
+		c.x[i] = num_det::from_raw_value(kind == 0 ? tiny(*rng) : arena(*rng));
+		c.y[i] = num_det::from_raw_value(kind == 1 ? tiny(*rng) : arena(*rng));
+	}
+	return c;
+}
+
+int reportMismatches(const char* name, const Columns* got, const std::vector<Vec2>* expected)
+{
+	int mismatches = 0;
+	for (size_t i = 0; i < expected->size(); i++)
+	{
+		if (!v2::equal(got->at(i), (*expected)[i])) mismatches++;
+	}
+	std::cout << "  " << name << " mismatches: " << mismatches << std::endl;
+	return mismatches;
+}
+
+template <typename Scalar, typename Batch>
+void timeCase(const char* name, Scalar scalar, Batch batch, int loops, size_t count)
+{
+	auto start = BenchClock::now();
+	for (int l = 0; l < loops; l++) scalar();
+	double scalarNs = secondsSince(start) * 1e9 / (double(loops) * count);
+	start = BenchClock::now();
+	for (int l = 0; l < loops; l++) batch();
+	double batchNs = secondsSince(start) * 1e9 / (double(loops) * count);
+	std::cout << "  " << name << ": v2 " << scalarNs << " ns/vector, batch " << batchNs << " ns/vector" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t count = 4096;
+	int loops = 200;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-count") == 0 && i + 1 < argc)
+			count = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "-loops") == 0 && i + 1 < argc)
+			loops = std::max(1, atoi(argv[++i]));
+	}
+
+	std::mt19937 rng(20230329);
+	Columns a = randomColumns(&rng, count);
+	Columns b = randomColumns(&rng, count);
+	Columns out = a;
+	std::vector<num_det> angles(count);
+	std::uniform_int_distribution<std::int32_t> angleDist(-(7 << 16), 7 << 16);
+	for (size_t i = 0; i < count; i++) angles[i] = num_det::from_raw_value(angleDist(rng));
+	num_det s = b.x[0];
+	num_det angle = angles[0];
+
+	int mismatches = 0;
+	std::vector<Vec2> expected(count);
+	std::vector<num_det> scalars(count);
+
+#if defined(RBST_VECBATCH_AVX2)
+#if defined(__GNUC__)
+	//the rbst_vecbench_avx2 build, on a CPU that can't run it
+	if (!__builtin_cpu_supports("avx2"))
+	{
+		std::cerr << "built for AVX2, which this CPU doesn't have" << std::endl;
+		return 1;
+	}
+#endif
+	std::cout << "kernels: AVX2" << std::endl;
+#elif defined(RBST_VECBATCH_SSE2)
+	std::cout << "kernels: SSE2" << std::endl;
+#else
+	std::cout << "kernels: scalar fallback" << std::endl;
+#endif
+	std::cout << "vectors: " << count << ", loops: " << loops << std::endl;
+
+	auto copyScalars = [&]()
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out.x[i] = scalars[i];
+			out.y[i] = num_det{ 0 };
+		}
+	};
+
+	//ADD
+	auto addScalar = [&]() { for (size_t i = 0; i < count; i++) expected[i] = v2::add(a.at(i), b.at(i)); };
+	auto addBatch = [&]() { v2batch::add(a.cols(), b.cols(), out.cols(), count); };
+	addScalar(); addBatch();
+	mismatches += reportMismatches("add", &out, &expected);
+	timeCase("add", addScalar, addBatch, loops, count);
+
+	//SCALAR MULT
+	auto multScalar = [&]() { for (size_t i = 0; i < count; i++) expected[i] = v2::scalarMult(a.at(i), s); };
+	auto multBatch = [&]() { v2batch::scalarMult(a.cols(), s, out.cols(), count); };
+	multScalar(); multBatch();
+	mismatches += reportMismatches("scalarMult", &out, &expected);
+	timeCase("scalarMult", multScalar, multBatch, loops, count);
+
+	//DOT
+	auto dotScalar = [&]() { for (size_t i = 0; i < count; i++) expected[i] = Vec2{ v2::dot(a.at(i), b.at(i)), num_det{ 0 } }; };
+	auto dotBatch = [&]() { v2batch::dot(a.cols(), b.cols(), scalars.data(), count); };
+	dotScalar(); dotBatch(); copyScalars();
+	mismatches += reportMismatches("dot", &out, &expected);
+	timeCase("dot", dotScalar, dotBatch, loops, count);
+
+	//LENGTH SQUARED
+	auto lenScalar = [&]() { for (size_t i = 0; i < count; i++) expected[i] = Vec2{ v2::dot(a.at(i), a.at(i)), num_det{ 0 } }; };
+	auto lenBatch = [&]() { v2batch::lengthSquared(a.cols(), scalars.data(), count); };
+	lenScalar(); lenBatch(); copyScalars();
+	mismatches += reportMismatches("lengthSquared", &out, &expected);
+	timeCase("lengthSquared", lenScalar, lenBatch, loops, count);
+
+	//NORMALIZE
+	auto normScalar = [&]() { for (size_t i = 0; i < count; i++) expected[i] = v2::normalize(a.at(i)); };
+	auto normBatch = [&]() { v2batch::normalize(a.cols(), out.cols(), count); };
+	normScalar(); normBatch();
+	mismatches += reportMismatches("normalize", &out, &expected);
+	timeCase("normalize", normScalar, normBatch, loops, count);
+
+	//ROTATE, ONE ANGLE FOR ALL
+	auto rotScalar = [&]() { for (size_t i = 0; i < count; i++) expected[i] = v2::rotate(a.at(i), angle); };
+	auto rotBatch = [&]() { v2batch::rotate(a.cols(), angle, out.cols(), count); };
+	rotScalar(); rotBatch();
+	mismatches += reportMismatches("rotate (one angle)", &out, &expected);
+	timeCase("rotate (one angle)", rotScalar, rotBatch, loops, count);
+
+	//ROTATE, ANGLE PER VECTOR
+	auto rotsScalar = [&]() { for (size_t i = 0; i < count; i++) expected[i] = v2::rotate(a.at(i), angles[i]); };
+	auto rotsBatch = [&]() { v2batch::rotate(a.cols(), angles.data(), out.cols(), count); };
+	rotsScalar(); rotsBatch();
+	mismatches += reportMismatches("rotate (per vector)", &out, &expected);
+	timeCase("rotate (per vector)", rotsScalar, rotsBatch, loops, count);
+
+	std::cout << (mismatches == 0 ? "bit-exact" : "MISMATCH") << std::endl;
+	return mismatches == 0 ? 0 : 1;
+}